@@ -2073,3 +2073,67 @@ lp_build_sample_offset(struct lp_build_context *bld,
 
    *out_offset = offset;
 }
+
+
+/**
+ * Compute the offset of a texel in a Y-major tiled image.
+ *
+ * Y-major tiles are 4KB, 128 bytes wide by 32 rows, made of 16 byte wide
+ * columns stored one after another.  Tiles are laid out in rows, so with
+ * y_stride the image row pitch (a multiple of 128) the offset is still the
+ * sum of an x and a y term:
+ *
+ *    (xb & 15) + ((xb >> 4) << 9) + ((y & 31) << 4) + (y >> 5) * 32 * y_stride
+ *
+ * where xb is x in bytes.  Only formats with 1x1 blocks whose size divides
+ * 16 bytes can be tiled this way.
+ */
+void
+lp_build_sample_offset_ymajor(struct lp_build_context *bld,
+                              const struct util_format_description *format_desc,
+                              LLVMValueRef x,
+                              LLVMValueRef y,
+                              LLVMValueRef z,
+                              LLVMValueRef y_stride,
+                              LLVMValueRef z_stride,
+                              LLVMValueRef *out_offset,
+                              LLVMValueRef *out_i,
+                              LLVMValueRef *out_j)
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMValueRef x_stride;
+   LLVMValueRef xb, x_offset, y_offset, offset;
+
+   assert(format_desc->block.width == 1 && format_desc->block.height == 1);
+   assert(util_is_power_of_two(format_desc->block.bits / 8));
+   assert(format_desc->block.bits / 8 <= 16);
+
+   x_stride = lp_build_const_int_vec(gallivm, bld->type,
+                                     format_desc->block.bits/8);
+   xb = lp_build_mul(bld, x, x_stride);
+
+   x_offset = lp_build_and(bld, xb,
+                           lp_build_const_int_vec(gallivm, bld->type, 15));
+   offset = lp_build_shr_imm(bld, xb, 4);
+   offset = lp_build_shl_imm(bld, offset, 9);
+   offset = lp_build_add(bld, offset, x_offset);
+
+   if (y && y_stride) {
+      y_offset = lp_build_and(bld, y,
+                              lp_build_const_int_vec(gallivm, bld->type, 31));
+      y_offset = lp_build_shl_imm(bld, y_offset, 4);
+      offset = lp_build_add(bld, offset, y_offset);
+
+      y_offset = lp_build_mul(bld, lp_build_shr_imm(bld, y, 5),
+                              lp_build_shl_imm(bld, y_stride, 5));
+      offset = lp_build_add(bld, offset, y_offset);
+   }
+
+   if (z && z_stride) {
+      offset = lp_build_add(bld, offset, lp_build_mul(bld, z, z_stride));
+   }
+
+   *out_offset = offset;
+   *out_i = bld->zero;
+   *out_j = bld->zero;
+}
@@ -131,6 +131,7 @@ struct lp_static_texture_state
    unsigned pot_height:1;
    unsigned pot_depth:1;
    unsigned level_zero_only:1;
+   unsigned tiled:1;         /**< texels stored in 4KB Y-major tiles */
 };
 
 
@@ -572,6 +573,19 @@ lp_build_sample_offset(struct lp_build_context *bld,
                        LLVMValueRef *out_j);
 
 
+void
+lp_build_sample_offset_ymajor(struct lp_build_context *bld,
+                              const struct util_format_description *format_desc,
+                              LLVMValueRef x,
+                              LLVMValueRef y,
+                              LLVMValueRef z,
+                              LLVMValueRef y_stride,
+                              LLVMValueRef z_stride,
+                              LLVMValueRef *out_offset,
+                              LLVMValueRef *out_i,
+                              LLVMValueRef *out_j);
+
+
 void
 lp_build_sample_soa(const struct lp_static_texture_state *static_texture_state,
                     const struct lp_static_sampler_state *static_sampler_state,
@@ -136,10 +136,16 @@ lp_build_sample_texel_soa(struct lp_build_sample_context *bld,
    }
 
    /* convert x,y,z coords to linear offset from start of texture, in bytes */
-   lp_build_sample_offset(&bld->int_coord_bld,
-                          bld->format_desc,
-                          x, y, z, y_stride, z_stride,
-                          &offset, &i, &j);
+   if (bld->static_texture_state->tiled)
+      lp_build_sample_offset_ymajor(&bld->int_coord_bld,
+                                    bld->format_desc,
+                                    x, y, z, y_stride, z_stride,
+                                    &offset, &i, &j);
+   else
+      lp_build_sample_offset(&bld->int_coord_bld,
+                             bld->format_desc,
+                             x, y, z, y_stride, z_stride,
+                             &offset, &i, &j);
    if (mipoffsets) {
       offset = lp_build_add(&bld->int_coord_bld, offset, mipoffsets);
    }
@@ -2370,10 +2376,16 @@ lp_build_fetch_texel(struct lp_build_sample_context *bld,
       }
    }
 
-   lp_build_sample_offset(int_coord_bld,
-                          bld->format_desc,
-                          x, y, z, row_stride_vec, img_stride_vec,
-                          &offset, &i, &j);
+   if (bld->static_texture_state->tiled)
+      lp_build_sample_offset_ymajor(int_coord_bld,
+                                    bld->format_desc,
+                                    x, y, z, row_stride_vec, img_stride_vec,
+                                    &offset, &i, &j);
+   else
+      lp_build_sample_offset(int_coord_bld,
+                             bld->format_desc,
+                             x, y, z, row_stride_vec, img_stride_vec,
+                             &offset, &i, &j);
 
    if (bld->static_texture_state->target != PIPE_BUFFER) {
       offset = lp_build_add(int_coord_bld, offset,
@@ -2797,6 +2809,10 @@ lp_build_sample_soa_code(struct gallivm_state *gallivm,
          /* theoretically possible with AoS filtering but not implemented (complex!) */
          use_aos = 0;
       }
+      if (static_texture_state->tiled) {
+         /* the aos path only knows linear layouts */
+         use_aos = 0;
+      }
 
       if ((gallivm_debug & GALLIVM_DEBUG_PERF) &&
           !use_aos && util_format_fits_8unorm(bld.format_desc)) {
@@ -134,6 +134,13 @@ unsigned char _BitScanForward(unsigned int *Index, unsigned int Mask)
     return (Mask != 0);
 }
 
+inline
+unsigned char _BitScanForward64(unsigned int *Index, unsigned long long Mask)
+{
+    *Index = __builtin_ctzll(Mask);
+    return (Mask != 0);
+}
+
 inline
 unsigned char _BitScanReverse(unsigned int *Index, unsigned int Mask)
 {
@@ -169,6 +176,7 @@ unsigned int _mm_popcnt_u32(unsigned int v)
 #define _aligned_free free
 #define InterlockedCompareExchange(Dest, Exchange, Comparand) __sync_val_compare_and_swap(Dest, Comparand, Exchange)
 #define InterlockedExchangeAdd(Addend, Value) __sync_fetch_and_add(Addend, Value)
+#define InterlockedExchangeAdd64(Addend, Value) __sync_fetch_and_add(Addend, Value)
 #define InterlockedDecrement(Append) __sync_sub_and_fetch(Append, 1)
 #define _ReadWriteBarrier() asm volatile("" ::: "memory")
 #define __stdcall
@@ -0,0 +1,188 @@
+/****************************************************************************
+* Copyright (C) 2014-2015 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+* 
+* 
+* @file rdtsc_trace.cpp
+* 
+* @brief implementation of rdtsc bucket tracing.
+* 
+* Notes:
+* 
+******************************************************************************/
+#include "rdtsc_trace.h"
+#include <inttypes.h>
+#include <algorithm>
+
+THREAD TRACE_THREAD* tlsTraceThread = nullptr;
+
+TraceManager::~TraceManager()
+{
+    for (TRACE_THREAD* pThread : mThreads)
+    {
+        free(pThread->pEvents);
+        delete pThread;
+    }
+}
+
+TRACE_THREAD* TraceManager::GetThread()
+{
+    if (tlsTraceThread != nullptr)
+    {
+        return tlsTraceThread;
+    }
+
+    TRACE_THREAD* pThread = new TRACE_THREAD();
+
+    mThreadMutex.lock();
+
+    pThread->id = (uint32_t)mThreads.size();
+    pThread->name = "Thread " + std::to_string(pThread->id);
+    if (mEventsPerThread)
+    {
+        pThread->pEvents = (TRACE_EVENT*)malloc(mEventsPerThread * sizeof(TRACE_EVENT));
+        pThread->capacity = pThread->pEvents ? mEventsPerThread : 0;
+    }
+    mThreads.push_back(pThread);
+
+    mThreadMutex.unlock();
+
+    tlsTraceThread = pThread;
+    return pThread;
+}
+
+void TraceManager::RegisterThread(const std::string& name)
+{
+    TRACE_THREAD* pThread = GetThread();
+
+    mThreadMutex.lock();
+    pThread->name = name + " " + std::to_string(pThread->id);
+    mThreadMutex.unlock();
+}
+
+void TraceManager::StartCapture(uint32_t eventsPerThread)
+{
+    mThreadMutex.lock();
+
+    // buffers are sized by the first capture, threads may be recording into them later
+    if (mEventsPerThread == 0)
+    {
+        mEventsPerThread = std::max(eventsPerThread, 1u);
+    }
+
+    for (TRACE_THREAD* pThread : mThreads)
+    {
+        if (pThread->pEvents == nullptr)
+        {
+            pThread->pEvents = (TRACE_EVENT*)malloc(mEventsPerThread * sizeof(TRACE_EVENT));
+            pThread->capacity = pThread->pEvents ? mEventsPerThread : 0;
+        }
+        pThread->numEvents = 0;
+    }
+
+    mThreadMutex.unlock();
+
+    mCaptureStartTime = std::chrono::steady_clock::now();
+    mCaptureStartTsc = __rdtsc();
+    mCaptureId++;
+
+    _mm_mfence();
+    mCapturing = true;
+}
+
+void TraceManager::StopCapture()
+{
+    mCapturing = false;
+    _mm_mfence();
+
+    mCaptureStopTsc = __rdtsc();
+    mCaptureStopTime = std::chrono::steady_clock::now();
+
+    // wait for threads that saw the capture on to finish their last event
+    mThreadMutex.lock();
+    for (TRACE_THREAD* pThread : mThreads)
+    {
+        while (pThread->recording)
+        {
+            _mm_pause();
+        }
+    }
+    mThreadMutex.unlock();
+}
+
+void TraceManager::WriteTrace(const std::string& filename, const BUCKET_DESC* pBuckets, uint32_t numBuckets)
+{
+    // events are only stable once StopCapture has waited for the threads
+    if (mCapturing)
+    {
+        return;
+    }
+
+    FILE* f = fopen(filename.c_str(), "w");
+    if (f == nullptr)
+    {
+        return;
+    }
+
+    double captureUs = std::chrono::duration<double, std::micro>(mCaptureStopTime - mCaptureStartTime).count();
+    uint64_t captureTicks = mCaptureStopTsc - mCaptureStartTsc;
+    double usPerTick = (captureTicks && captureUs > 0.0) ? captureUs / (double)captureTicks : 0.0;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+
+    mThreadMutex.lock();
+
+    for (const TRACE_THREAD* pThread : mThreads)
+    {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", pThread->id, pThread->name.c_str());
+        first = false;
+
+        if (pThread->capacity == 0)
+        {
+            continue;
+        }
+
+        // the ring buffer keeps the most recent events
+        uint64_t numEvents = pThread->numEvents;
+        uint64_t firstEvent = (numEvents > pThread->capacity) ? numEvents - pThread->capacity : 0;
+
+        for (uint64_t e = firstEvent; e < numEvents; ++e)
+        {
+            const TRACE_EVENT& event = pThread->pEvents[e % pThread->capacity];
+            const char* pName = (event.id < numBuckets) ? pBuckets[event.id].name.c_str() : "Unknown";
+
+            double ts = (double)(event.start - mCaptureStartTsc) * usPerTick;
+            double dur = (double)(event.end - event.start) * usPerTick;
+
+            fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"swr\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,"
+                "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"draw\":%" PRIu64 "}}",
+                pName, pThread->id, ts, dur, event.drawId);
+        }
+    }
+
+    mThreadMutex.unlock();
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+}
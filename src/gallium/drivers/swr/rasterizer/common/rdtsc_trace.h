@@ -0,0 +1,194 @@
+/****************************************************************************
+* Copyright (C) 2014-2015 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+* 
+* 
+* @file rdtsc_trace.h
+* 
+* @brief declaration for rdtsc bucket tracing.
+* 
+* Notes:
+* 
+******************************************************************************/
+#pragma once
+
+#include "os.h"
+#include <vector>
+#include <mutex>
+#include <string>
+#include <chrono>
+
+#include "rdtsc_buckets_shared.h"
+
+struct TRACE_THREAD;
+
+// trace state of the calling thread, nullptr until it records its first span
+extern THREAD TRACE_THREAD* tlsTraceThread;
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief A completed bucket span.
+struct TRACE_EVENT
+{
+    uint64_t start;
+    uint64_t end;
+    uint64_t drawId;
+    uint32_t id;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Per thread trace data. Spans are written to a ring buffer that
+///        keeps the most recent events, only the owning thread writes it.
+struct TRACE_THREAD
+{
+    static const uint32_t MaxDepth = 32;
+
+    struct OPEN_SPAN
+    {
+        uint32_t id;
+        uint64_t start;
+    };
+
+    std::string name;
+    uint32_t id;
+
+    TRACE_EVENT* pEvents{ nullptr };
+    uint32_t capacity{ 0 };
+    volatile uint64_t numEvents{ 0 };
+
+    OPEN_SPAN stack[MaxDepth];
+    uint32_t depth{ 0 };
+
+    // capture the open spans belong to, spans from an earlier capture are dropped
+    uint32_t captureId{ 0 };
+
+    // set while the thread may be writing an event, StopCapture waits for it
+    volatile bool recording{ false };
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief TraceManager records begin/end spans of buckets per thread and
+///        writes them as Chrome trace event JSON, which chrome://tracing
+///        and Perfetto load. Unlike BucketManager it doesn't need
+///        KNOB_ENABLE_RDTSC, recording is switched on at runtime and costs
+///        a flag check per bucket while off.
+class TraceManager
+{
+public:
+    TraceManager() {}
+    ~TraceManager();
+
+    /// Names the calling thread in the trace.
+    void RegisterThread(const std::string& name);
+
+    /// Starts recording.
+    /// @param eventsPerThread - ring buffer size, older events are overwritten
+    void StartCapture(uint32_t eventsPerThread);
+
+    /// Stops recording. Returns once no thread is still writing an event.
+    void StopCapture();
+
+    /// Writes the events recorded by the last capture. Call after StopCapture.
+    /// @param filename - output file
+    /// @param pBuckets - bucket descriptions, indexed by bucket id
+    /// @param numBuckets - number of bucket descriptions
+    void WriteTrace(const std::string& filename, const BUCKET_DESC* pBuckets, uint32_t numBuckets);
+
+    INLINE bool IsCapturing() const
+    {
+        return mCapturing;
+    }
+
+    // open a span for a bucket
+    INLINE void BeginSpan(uint32_t id)
+    {
+        TRACE_THREAD* pThread = tlsTraceThread ? tlsTraceThread : GetThread();
+
+        // spans are only closed while capturing, forget those left open by the last capture
+        if (pThread->captureId != mCaptureId)
+        {
+            pThread->captureId = mCaptureId;
+            pThread->depth = 0;
+        }
+
+        if (pThread->depth < TRACE_THREAD::MaxDepth)
+        {
+            pThread->stack[pThread->depth].id = id;
+            pThread->stack[pThread->depth].start = __rdtsc();
+        }
+        pThread->depth++;
+    }
+
+    // close the innermost open span of the bucket and record it
+    INLINE void EndSpan(uint32_t id, uint64_t drawId)
+    {
+        TRACE_THREAD* pThread = tlsTraceThread;
+        if (pThread == nullptr || pThread->depth == 0) return;
+
+        // spans opened before the capture started have no begin, skip them
+        uint32_t depth = (pThread->depth < TRACE_THREAD::MaxDepth) ? pThread->depth : TRACE_THREAD::MaxDepth;
+        while (depth > 0 && pThread->stack[depth - 1].id != id)
+        {
+            depth--;
+        }
+        if (depth == 0) return;
+
+        pThread->depth = depth - 1;
+
+        uint64_t start = pThread->stack[depth - 1].start;
+        if (start < mCaptureStartTsc || pThread->capacity == 0) return;
+
+        // announce the write before checking the capture is still on, so
+        // StopCapture either sees the flag or we see the capture stopped
+        pThread->recording = true;
+        _mm_mfence();
+
+        if (mCapturing)
+        {
+            TRACE_EVENT& event = pThread->pEvents[pThread->numEvents % pThread->capacity];
+            event.start = start;
+            event.end = __rdtsc();
+            event.drawId = drawId;
+            event.id = id;
+
+            _ReadWriteBarrier();
+            pThread->numEvents++;
+        }
+
+        _ReadWriteBarrier();
+        pThread->recording = false;
+    }
+
+private:
+    TRACE_THREAD* GetThread();
+
+    std::mutex mThreadMutex;
+    std::vector<TRACE_THREAD*> mThreads;
+
+    volatile bool mCapturing{ false };
+    uint32_t mCaptureId{ 0 };
+    uint32_t mEventsPerThread{ 0 };
+
+    // rdtsc to wall clock conversion, measured over the capture
+    uint64_t mCaptureStartTsc{ 0 };
+    uint64_t mCaptureStopTsc{ 0 };
+    std::chrono::steady_clock::time_point mCaptureStartTime;
+    std::chrono::steady_clock::time_point mCaptureStopTime;
+};
@@ -65,6 +65,17 @@ HANDLE SwrCreateContext(
     pContext->driverType = pCreateInfo->driver;
     pContext->privateStateSize = pCreateInfo->privateStateSize;
 
+    if (!KNOB_SINGLE_THREADED)
+    {
+        // Attach to the worker threads shared by all contexts of the process
+        if (!CreateThreadPool(pContext, pCreateInfo->maxWorkerThreads))
+        {
+            pContext->~SWR_CONTEXT();
+            _aligned_free(pContextMem);
+            return nullptr;
+        }
+    }
+
     pContext->dcRing = (DRAW_CONTEXT*)_aligned_malloc(sizeof(DRAW_CONTEXT)*KNOB_MAX_DRAWS_IN_FLIGHT, 64);
     memset(pContext->dcRing, 0, sizeof(DRAW_CONTEXT)*KNOB_MAX_DRAWS_IN_FLIGHT);
 
@@ -81,20 +92,19 @@ HANDLE SwrCreateContext(
         pContext->dsRing[dc].arena.Init();
     }
 
-    if (!KNOB_SINGLE_THREADED)
-    {
-        memset(&pContext->WaitLock, 0, sizeof(pContext->WaitLock));
-        memset(&pContext->FifosNotEmpty, 0, sizeof(pContext->FifosNotEmpty));
-        new (&pContext->WaitLock) std::mutex();
-        new (&pContext->FifosNotEmpty) std::condition_variable();
-
-        CreateThreadPool(pContext, &pContext->threadPool);
-    }
-
     // Calling createThreadPool() above can set SINGLE_THREADED
     if (KNOB_SINGLE_THREADED)
     {
         pContext->NumWorkerThreads = 1;
+        pContext->NumNumaNodes = 1;
+        pContext->numaNodeIds[0] = 0;
+        pContext->workerNumaNode[0] = 0;
+    }
+
+    // Per worker state for chunked draws
+    for (uint32_t dc = 0; dc < KNOB_MAX_DRAWS_IN_FLIGHT; ++dc)
+    {
+        pContext->dcRing[dc].pFeChunkWorkers = new FE_CHUNK_WORKER[pContext->NumWorkerThreads];
     }
 
     // Allocate scratch space for workers.
@@ -121,7 +131,11 @@ HANDLE SwrCreateContext(
     SetupDefaultState(pContext);
 
     // initialize hot tile manager
-    pContext->pHotTileMgr = new HotTileMgr();
+    pContext->pHotTileMgr = new HotTileMgr(pContext->NumNumaNodes, pContext->numaNodeIds);
+
+    // initialize BE macrotile scheduler
+    pContext->pTileScheduler = new MacroTileScheduler(pContext->NumWorkerThreads,
+        pContext->NumNumaNodes, pContext->workerNumaNode);
 
     // initialize function pointer tables
     InitClearTilesTable();
@@ -131,21 +145,40 @@ HANDLE SwrCreateContext(
     pContext->pfnStoreTile = pCreateInfo->pfnStoreTile;
     pContext->pfnClearTile = pCreateInfo->pfnClearTile;
 
+    // Let the shared workers pick up draws from this context
+    PublishThreadPoolContext(pContext);
+
     return (HANDLE)pContext;
 }
 
 void SwrDestroyContext(HANDLE hContext)
 {
     SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
-    DestroyThreadPool(pContext, &pContext->threadPool);
+    DestroyThreadPool(pContext);
 
     // free the fifos
     for (uint32_t i = 0; i < KNOB_MAX_DRAWS_IN_FLIGHT; ++i)
     {
         delete(pContext->dcRing[i].pTileMgr);
         delete(pContext->dcRing[i].pDispatch);
+
+        for (uint32_t w = 0; w < pContext->NumWorkerThreads; ++w)
+        {
+            pContext->dcRing[i].pFeChunkWorkers[w].arena.Reset(true);
+        }
+        delete[](pContext->dcRing[i].pFeChunkWorkers);
+
+        // return arena blocks to the block cache
+        pContext->dcRing[i].arena.Reset(true);
+        pContext->dsRing[i].arena.Reset(true);
     }
 
+    // don't strand the blocks the api thread cached for itself, nor the vertex
+    // cache and resolve scratch it used if it ran the pipeline
+    gArenaBlockCache.FlushThreadCache();
+    FreeVertexCache();
+    HotTileMgr::FreeThreadResolveBuffer();
+
     // Free scratch space.
     for (uint32_t i = 0; i < pContext->NumWorkerThreads; ++i)
     {
@@ -156,6 +189,7 @@ void SwrDestroyContext(HANDLE hContext)
     _aligned_free(pContext->dsRing);
 
     delete(pContext->pHotTileMgr);
+    delete(pContext->pTileScheduler);
 
     pContext->~SWR_CONTEXT();
     _aligned_free((SWR_CONTEXT*)hContext);
@@ -163,8 +197,9 @@ void SwrDestroyContext(HANDLE hContext)
 
 void WakeAllThreads(SWR_CONTEXT *pContext)
 {
-    std::unique_lock<std::mutex> lock(pContext->WaitLock);
-    pContext->FifosNotEmpty.notify_all();
+    THREAD_POOL *pPool = pContext->pThreadPool;
+    std::unique_lock<std::mutex> lock(pPool->WaitLock);
+    pPool->FifosNotEmpty.notify_all();
     lock.unlock();
 }
 
@@ -256,9 +291,8 @@ void QueueDraw(SWR_CONTEXT *pContext)
         uint32_t mxcsr = _mm_getcsr();
         _mm_setcsr(mxcsr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
 
-        std::unordered_set<uint32_t> lockedTiles;
         WorkOnFifoFE(pContext, 0, pContext->WorkerFE[0], 0);
-        WorkOnFifoBE(pContext, 0, pContext->WorkerBE[0], lockedTiles);
+        WorkOnFifoBE(pContext, 0, pContext->WorkerBE[0]);
 
         // restore csr
         _mm_setcsr(mxcsr);
@@ -381,6 +415,21 @@ DRAW_CONTEXT* GetDrawContext(SWR_CONTEXT *pContext, bool isSplitDraw = false)
 
         pCurDrawContext->pTileMgr->initialize();
 
+        // Return blocks binned by chunks of the previous draw to the block cache
+        if (pCurDrawContext->numFeChunks)
+        {
+            for (uint32_t w = 0; w < pContext->NumWorkerThreads; ++w)
+            {
+                FE_CHUNK_WORKER& chunkWorker = pCurDrawContext->pFeChunkWorkers[w];
+                if (chunkWorker.used)
+                {
+                    chunkWorker.arena.Reset(true);
+                    chunkWorker.used = false;
+                }
+            }
+        }
+        pCurDrawContext->numFeChunks = 0;
+
         // Assign unique drawId for this DC
         pCurDrawContext->drawId = pContext->nextDrawId++;
     }
@@ -597,6 +646,29 @@ void SwrSetBackendState(
     pState->backendState = *pBEState;
 }
 
+SWR_FORMAT SwrGetColorHotTileFormat(
+    SWR_FORMAT renderTargetFormat)
+{
+    if (!KNOB_LOW_PRECISION_HOT_TILES)
+    {
+        return KNOB_COLOR_HOT_TILE_FORMAT;
+    }
+
+    switch (renderTargetFormat)
+    {
+    case B8G8R8A8_UNORM:
+    case B8G8R8X8_UNORM:
+    case R8G8B8A8_UNORM:
+    case R8G8B8X8_UNORM:
+        return KNOB_COLOR_HOT_TILE_FORMAT_UNORM8;
+    case R16G16B16A16_FLOAT:
+    case R16G16B16X16_FLOAT:
+        return KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16;
+    default:
+        return KNOB_COLOR_HOT_TILE_FORMAT;
+    }
+}
+
 void SwrSetPixelShaderState(
     HANDLE hContext,
     SWR_PS_STATE *pPSState)
@@ -973,6 +1045,57 @@ uint32_t MaxVertsPerDraw(
     return vertsPerDraw;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Number of vertices (indices) per draw context. Draws split by
+///        MaxVertsPerDraw get up to FE_CHUNKS_PER_DRAW splits per draw
+///        context, which workers then bin concurrently as FE chunks.
+/// @param totalVerts - Total vertices for draw
+/// @param vertsPerChunk - Result of MaxVertsPerDraw
+uint32_t MaxVertsPerDrawContext(
+    uint32_t totalVerts,
+    uint32_t vertsPerChunk)
+{
+    if (vertsPerChunk >= totalVerts)
+    {
+        return totalVerts;
+    }
+
+    uint64_t vertsPerDC = (uint64_t)vertsPerChunk * std::max(KNOB_FE_CHUNKS_PER_DRAW, 1u);
+    return (uint32_t)std::min<uint64_t>(vertsPerDC, totalVerts);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Splits the FE of a draw context into chunks.
+/// @param pDC - Draw context to split.
+/// @param numVerts - Vertices (indices) of the draw context.
+/// @param vertsPerChunk - Vertices (indices) per chunk.
+/// @param topology - Topology used for draw
+/// @param indexSize - Index size of indexed draws, 0 if not indexed.
+void SetupFeChunks(
+    DRAW_CONTEXT *pDC,
+    uint32_t numVerts,
+    uint32_t vertsPerChunk,
+    PRIMITIVE_TOPOLOGY topology,
+    uint32_t indexSize)
+{
+    uint32_t numChunks = (numVerts + vertsPerChunk - 1) / vertsPerChunk;
+    if (numChunks < 2)
+    {
+        pDC->numFeChunks = 0;
+        return;
+    }
+
+    pDC->feChunkVerts = vertsPerChunk;
+    pDC->feChunkPrims = GetNumPrims(topology, vertsPerChunk);
+    pDC->feChunkIndexSize = indexSize;
+    pDC->pFeChunks = (FE_CHUNK*)pDC->arena.AllocAligned(numChunks * sizeof(FE_CHUNK), 64);
+    memset(pDC->pFeChunks, 0, numChunks * sizeof(FE_CHUNK));
+    pDC->nextFeChunk = 0;
+    pDC->feMergeLock = 0;
+    pDC->nextFeChunkToMerge = 0;
+    pDC->numFeChunks = numChunks;
+}
+
 // Recursive template used to auto-nest conditionals.  Converts dynamic boolean function
 // arguments to static template arguments.
 template <bool... ArgsB>
@@ -1038,7 +1161,8 @@ void DrawInstanced(
     SWR_CONTEXT *pContext = GetContext(hContext);
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
 
-    int32_t maxVertsPerDraw = MaxVertsPerDraw(pDC, numVertices, topology);
+    uint32_t vertsPerChunk = MaxVertsPerDraw(pDC, numVertices, topology);
+    int32_t maxVertsPerDraw = MaxVertsPerDrawContext(numVertices, vertsPerChunk);
     uint32_t primsPerDraw = GetNumPrims(topology, maxVertsPerDraw);
     int32_t remainingVerts = numVertices;
 
@@ -1077,6 +1201,8 @@ void DrawInstanced(
         pDC->FeWork.desc.draw.startInstance = startInstance;
         pDC->FeWork.desc.draw.startPrimID = draw * primsPerDraw;
 
+        SetupFeChunks(pDC, numVertsForDraw, vertsPerChunk, topology, 0);
+
         //enqueue DC
         QueueDraw(pContext);
 
@@ -1150,7 +1276,8 @@ void DrawIndexedInstance(
     DRAW_CONTEXT* pDC = GetDrawContext(pContext);
     API_STATE* pState = &pDC->pState->state;
 
-    int32_t maxIndicesPerDraw = MaxVertsPerDraw(pDC, numIndices, topology);
+    uint32_t indicesPerChunk = MaxVertsPerDraw(pDC, numIndices, topology);
+    int32_t maxIndicesPerDraw = MaxVertsPerDrawContext(numIndices, indicesPerChunk);
     uint32_t primsPerDraw = GetNumPrims(topology, maxIndicesPerDraw);
     int32_t remainingIndices = numIndices;
 
@@ -1206,6 +1333,8 @@ void DrawIndexedInstance(
         pDC->FeWork.desc.draw.baseVertex = baseVertex;
         pDC->FeWork.desc.draw.startPrimID = draw * primsPerDraw;
 
+        SetupFeChunks(pDC, numIndicesForDraw, indicesPerChunk, topology, indexSize);
+
         //enqueue DC
         QueueDraw(pContext);
 
@@ -1317,6 +1446,25 @@ void SwrStoreTiles(
     HANDLE hContext,
     SWR_RENDERTARGET_ATTACHMENT attachment,
     SWR_TILE_STATE postStoreTileState) // TODO: Implement postStoreTileState
+{
+    SWR_CONTEXT *pContext = (SWR_CONTEXT*)hContext;
+    API_STATE* pState = GetDrawState(pContext);
+
+    // store everything covered by the current viewport
+    SWR_RECT rect;
+    rect.left = 0;
+    rect.top = 0;
+    rect.right = (uint32_t)pState->vp[0].width + (uint32_t)pState->vp[0].x;
+    rect.bottom = (uint32_t)pState->vp[0].height + (uint32_t)pState->vp[0].y;
+
+    SwrStoreTilesRect(hContext, 1 << attachment, postStoreTileState, &rect);
+}
+
+void SwrStoreTilesRect(
+    HANDLE hContext,
+    uint32_t attachmentMask,
+    SWR_TILE_STATE postStoreTileState,
+    const SWR_RECT *pRect)
 {
     RDTSC_START(APIStoreTiles);
 
@@ -1328,17 +1476,19 @@ void SwrStoreTiles(
 
     pDC->FeWork.type = STORETILES;
     pDC->FeWork.pfnWork = ProcessStoreTiles;
-    pDC->FeWork.desc.storeTiles.attachment = attachment;
+    pDC->FeWork.desc.storeTiles.attachmentMask = attachmentMask;
     pDC->FeWork.desc.storeTiles.postStoreTileState = postStoreTileState;
+    pDC->FeWork.desc.storeTiles.rect = *pRect;
 
     //enqueue
     QueueDraw(pContext);
 
     RDTSC_STOP(APIStoreTiles, 0, 0);
-    if (attachment == SWR_ATTACHMENT_COLOR0)
-    {
-        RDTSC_ENDFRAME();
-    }
+}
+
+void SwrEndFrame()
+{
+    RDTSC_ENDFRAME();
 }
 
 void SwrClearRenderTarget(
@@ -1446,6 +1596,73 @@ void SwrGetStats(
     QueueDraw(pContext);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns backend scheduler statistics.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - SWR will fill this out for caller.
+void SwrGetSchedulerStats(
+    HANDLE hContext,
+    SWR_SCHEDULER_STATS* pStats)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+    pContext->pTileScheduler->getStats(*pStats);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns arena block cache statistics.
+/// @param pStats - SWR will fill this out for caller.
+void SwrGetArenaCacheStats(
+    SWR_ARENA_CACHE_STATS* pStats)
+{
+    gArenaBlockCache.GetStats(*pStats);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Samples the always-on driver counters.
+/// @note Worker counters are read while workers update them, so a sample
+///       may miss the work item currently being processed.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pCounters - SWR will fill this out for caller.
+void SwrGetDriverCounters(
+    HANDLE hContext,
+    SWR_DRIVER_COUNTERS* pCounters)
+{
+    SWR_CONTEXT *pContext = GetContext(hContext);
+
+    memset(pCounters, 0, sizeof(*pCounters));
+    pCounters->Timestamp = __rdtsc();
+
+    for (uint32_t i = 0; i < pContext->NumWorkerThreads; ++i)
+    {
+        const WORKER_COUNTERS &counters = pContext->workerCounters[i];
+        pCounters->MacroTiles += counters.macroTiles;
+        pCounters->FeTicks += counters.feTicks;
+        pCounters->BeTicks += counters.beTicks;
+    }
+    pCounters->HotTileLoads = pContext->hotTileLoads;
+    pCounters->HotTileStores = pContext->hotTileStores;
+    pCounters->LayerAllocs = pContext->hotTileLayerAllocs;
+    pCounters->LayerReloads = pContext->hotTileLayerReloads;
+    pCounters->NumWorkers = pContext->NumWorkerThreads;
+
+    THREAD_POOL *pPool = pContext->pThreadPool;
+    if (pPool)
+    {
+        for (uint32_t i = 0; i < pPool->numThreads; ++i)
+        {
+            pCounters->IdleTicks += pPool->idleTicks[i];
+        }
+        pCounters->NumPoolWorkers = pPool->numThreads;
+    }
+
+    UpdateLastRetiredId(pContext);
+    pCounters->DrawsInFlight = pContext->DrawEnqueued - 1 - pContext->LastRetiredId;
+
+    SWR_ARENA_CACHE_STATS arenaStats;
+    gArenaBlockCache.GetStats(arenaStats);
+    pCounters->ArenaBytesInUse = arenaStats.BytesInUse;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Enables stats counting
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -92,6 +92,10 @@ struct SWR_CREATECONTEXT_INFO
     PFN_LOAD_TILE pfnLoadTile;
     PFN_STORE_TILE pfnStoreTile;
     PFN_CLEAR_TILE pfnClearTile;
+
+    // Max # of worker threads of the shared pool this context uses.
+    // 0 == KNOB_MAX_WORKERS_PER_CONTEXT
+    uint32_t maxWorkerThreads;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -271,6 +275,16 @@ void SWR_API SwrSetBackendState(
     HANDLE hContext,
     SWR_BACKEND_STATE *pState);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the color hot tile format to use for a render target.
+///        8-bit UNORM targets use RGBA8 UNORM hot tiles and 16-bit float
+///        targets use RGBA16 FLOAT hot tiles, everything else RGBA32 FLOAT.
+///        The result is used for SWR_BACKEND_STATE::colorHotTileFormat and
+///        BLEND_COMPILE_STATE::hotTileFormat.
+/// @param renderTargetFormat - format of the bound render target surface.
+SWR_FORMAT SWR_API SwrGetColorHotTileFormat(
+    SWR_FORMAT renderTargetFormat);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Set pixel shader state
 /// @param hContext - Handle passed back from SwrCreateContext
@@ -404,6 +418,27 @@ void SWR_API SwrStoreTiles(
     SWR_RENDERTARGET_ATTACHMENT attachment,
     SWR_TILE_STATE postStoreTileState);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Stores the hot tiles of the given attachments that intersect a
+///        rectangle. Only tiles that have been rendered to since they were
+///        last stored are written back; clean tiles are skipped.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param attachmentMask - Mask of (1 << SWR_RENDERTARGET_ATTACHMENT) to store.
+/// @param postStoreTileState - State of the stored hot tiles after the store.
+/// @param pRect - Region to store in pixels, right/bottom exclusive.
+void SWR_API SwrStoreTilesRect(
+    HANDLE hContext,
+    uint32_t attachmentMask,
+    SWR_TILE_STATE postStoreTileState,
+    const SWR_RECT *pRect);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Marks the end of a presented frame, or of an end of frame flush
+///        when there is nothing to present. Frames of the RDTSC bucket
+///        report and the trace capture are counted by this call, not by
+///        tile stores, which also happen for readbacks and resolves.
+void SWR_API SwrEndFrame();
+
 void SWR_API SwrClearRenderTarget(
     HANDLE hContext,
     uint32_t clearMask,
@@ -472,6 +507,33 @@ void SWR_API SwrGetStats(
     HANDLE hContext,
     SWR_STATS* pStats);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns backend scheduler statistics.
+/// @note The counters are incremented by multiple threads and are not
+///       synchronized with rendering.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pStats - SWR will fill this out for caller.
+void SWR_API SwrGetSchedulerStats(
+    HANDLE hContext,
+    SWR_SCHEDULER_STATS* pStats);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns arena block cache statistics. The cache is shared by
+///        all contexts, so these are process wide.
+/// @param pStats - SWR will fill this out for caller.
+void SWR_API SwrGetArenaCacheStats(
+    SWR_ARENA_CACHE_STATS* pStats);
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Samples the always-on driver counters. Returns immediately
+///        without waiting for queued work, so it is cheap enough to call
+///        every frame.
+/// @param hContext - Handle passed back from SwrCreateContext
+/// @param pCounters - SWR will fill this out for caller.
+void SWR_API SwrGetDriverCounters(
+    HANDLE hContext,
+    SWR_DRIVER_COUNTERS* pCounters);
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Enables stats counting
 /// @param hContext - Handle passed back from SwrCreateContext
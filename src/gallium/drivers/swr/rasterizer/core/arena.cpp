@@ -36,9 +36,193 @@
 
 #include <cmath>
 
+ArenaBlockCache gArenaBlockCache;
+
+static THREAD uint32_t tlsArenaNumaNode = 0;
+
+// Blocks this thread recycles without locking, all from tlsArenaNumaNode.
+struct ArenaThreadCache
+{
+    ArenaBlock* pBlocks[ArenaBlockCache::NumSizeClasses];
+    uint32_t    numBlocks[ArenaBlockCache::NumSizeClasses];
+};
+
+static THREAD ArenaThreadCache tlsArenaCache;
+
+ArenaBlockCache::ArenaBlockCache()
+{
+    for (uint32_t n = 0; n < MaxNumaNodes; ++n)
+    {
+        NodeCache& node = mNodes[n];
+        memset(node.pFreeBlocks, 0, sizeof(node.pFreeBlocks));
+        node.bytesCached = 0;
+        node.bytesInUse = 0;
+        node.blocksAllocated = 0;
+        node.blocksReused = 0;
+        node.blocksTrimmed = 0;
+    }
+}
+
+VOID ArenaBlockCache::SetThreadNumaNode(uint32_t numaNode)
+{
+    tlsArenaNumaNode = numaNode % MaxNumaNodes;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Reserves room for a block under the node's high-water mark.
+/// @return false if the block has to be trimmed instead.
+bool ArenaBlockCache::CacheBytes(NodeCache& node, uint32_t blockSize)
+{
+    uint64_t maxBytes = uint64_t(KNOB_ARENA_CACHE_MAX_SIZE_MB) * 1024 * 1024;
+    uint64_t bytesCached = node.bytesCached.load(std::memory_order_relaxed);
+
+    do
+    {
+        if (bytesCached + blockSize > maxBytes)
+        {
+            return false;
+        }
+    } while (!node.bytesCached.compare_exchange_weak(bytesCached, bytesCached + blockSize, std::memory_order_relaxed));
+
+    return true;
+}
+
+ArenaBlock* ArenaBlockCache::AllocBlock(uint32_t size)
+{
+    uint32_t sizeClass = 0;
+    while (sizeClass < NumSizeClasses && (BlockSize << sizeClass) < size)
+    {
+        ++sizeClass;
+    }
+
+    NodeCache& node = mNodes[tlsArenaNumaNode];
+    uint32_t blockSize = (sizeClass < NumSizeClasses) ? (BlockSize << sizeClass) : AlignUp(size, KNOB_SIMD_WIDTH*4);
+
+    if (sizeClass < NumSizeClasses)
+    {
+        // Try this thread's own blocks before locking the node.
+        ArenaBlock* pBlock = tlsArenaCache.pBlocks[sizeClass];
+        if (pBlock)
+        {
+            tlsArenaCache.pBlocks[sizeClass] = pBlock->pNext;
+            tlsArenaCache.numBlocks[sizeClass]--;
+        }
+        else
+        {
+            std::lock_guard<std::mutex> guard(node.lock);
+
+            // Take the smallest cached block that fits.
+            for (uint32_t c = sizeClass; c < NumSizeClasses; ++c)
+            {
+                pBlock = node.pFreeBlocks[c];
+                if (pBlock)
+                {
+                    node.pFreeBlocks[c] = pBlock->pNext;
+                    break;
+                }
+            }
+        }
+
+        if (pBlock)
+        {
+            node.bytesCached -= pBlock->blockSize;
+            node.bytesInUse += pBlock->blockSize;
+            node.blocksReused++;
+            pBlock->pNext = nullptr;
+            return pBlock;
+        }
+        node.blocksAllocated++;
+    }
+    node.bytesInUse += blockSize;
+
+    VOID *pMem = _aligned_malloc(blockSize, KNOB_SIMD_WIDTH*4);    // Arena blocks are always simd byte aligned.
+    SWR_ASSERT(pMem != nullptr);
+
+    ArenaBlock* pBlock = (ArenaBlock*)malloc(sizeof(ArenaBlock));
+    SWR_ASSERT(pBlock != nullptr);
+
+    pBlock->pMem = pMem;
+    pBlock->blockSize = blockSize;
+    pBlock->offset = 0;
+    pBlock->sizeClass = sizeClass;
+    pBlock->numaNode = tlsArenaNumaNode;
+    pBlock->pNext = nullptr;
+
+    return pBlock;
+}
+
+VOID ArenaBlockCache::FreeBlock(ArenaBlock* pBlock)
+{
+    // Return the block to the node it was first touched on.
+    NodeCache& node = mNodes[pBlock->numaNode];
+    uint32_t sizeClass = pBlock->sizeClass;
+
+    node.bytesInUse -= pBlock->blockSize;
+
+    if (sizeClass < NumSizeClasses)
+    {
+        if (CacheBytes(node, pBlock->blockSize))
+        {
+            pBlock->offset = 0;
+
+            if (pBlock->numaNode == tlsArenaNumaNode &&
+                tlsArenaCache.numBlocks[sizeClass] < MaxThreadCachedBlocks)
+            {
+                pBlock->pNext = tlsArenaCache.pBlocks[sizeClass];
+                tlsArenaCache.pBlocks[sizeClass] = pBlock;
+                tlsArenaCache.numBlocks[sizeClass]++;
+                return;
+            }
+
+            std::lock_guard<std::mutex> guard(node.lock);
+            pBlock->pNext = node.pFreeBlocks[sizeClass];
+            node.pFreeBlocks[sizeClass] = pBlock;
+            return;
+        }
+        node.blocksTrimmed++;
+    }
+
+    _aligned_free(pBlock->pMem);
+    free(pBlock);
+}
+
+VOID ArenaBlockCache::FlushThreadCache()
+{
+    // The blocks stay counted as cached, they only move to the node list.
+    for (uint32_t c = 0; c < NumSizeClasses; ++c)
+    {
+        while (tlsArenaCache.pBlocks[c])
+        {
+            ArenaBlock* pBlock = tlsArenaCache.pBlocks[c];
+            tlsArenaCache.pBlocks[c] = pBlock->pNext;
+
+            NodeCache& node = mNodes[pBlock->numaNode];
+            std::lock_guard<std::mutex> guard(node.lock);
+            pBlock->pNext = node.pFreeBlocks[c];
+            node.pFreeBlocks[c] = pBlock;
+        }
+        tlsArenaCache.numBlocks[c] = 0;
+    }
+}
+
+VOID ArenaBlockCache::GetStats(SWR_ARENA_CACHE_STATS& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+
+    for (uint32_t n = 0; n < MaxNumaNodes; ++n)
+    {
+        NodeCache& node = mNodes[n];
+
+        stats.BytesCached += node.bytesCached;
+        stats.BytesInUse += node.bytesInUse;
+        stats.BlocksAllocated += node.blocksAllocated;
+        stats.BlocksReused += node.blocksReused;
+        stats.BlocksTrimmed += node.blocksTrimmed;
+    }
+}
+
 VOID Arena::Init()
 {
-    m_memUsed = 0;
     m_pCurBlock = nullptr;
     m_pUsedBlocks = nullptr;
 }
@@ -63,34 +247,10 @@ VOID* Arena::AllocAligned(uint32_t size, uint32_t align)
         m_pCurBlock = nullptr;
     }
 
-    static const uint32_t ArenaBlockSize = 1024*1024;
-    uint32_t defaultBlockSize = ArenaBlockSize;
-    if (m_pUsedBlocks == nullptr)
-    {
-        // First allocation after reset. Let's make the first block be the total
-        // memory allocated during last set of allocations prior to reset.
-        defaultBlockSize = std::max(m_memUsed, defaultBlockSize);
-        m_memUsed = 0;
-    }
-
-    uint32_t blockSize = std::max(size, defaultBlockSize);
-    blockSize = AlignUp(blockSize, KNOB_SIMD_WIDTH*4);
-
-    VOID *pMem = _aligned_malloc(blockSize, KNOB_SIMD_WIDTH*4);    // Arena blocks are always simd byte aligned.
-    SWR_ASSERT(pMem != nullptr);
-
-    m_pCurBlock = (ArenaBlock*)malloc(sizeof(ArenaBlock));
-    SWR_ASSERT(m_pCurBlock != nullptr);
-
-    if (m_pCurBlock != nullptr)
-    {
-        m_pCurBlock->pMem = pMem;
-        m_pCurBlock->blockSize = blockSize;
-        m_pCurBlock->offset = size;
-        m_memUsed += blockSize;
-    }
+    m_pCurBlock = gArenaBlockCache.AllocBlock(size);
+    m_pCurBlock->offset = size;
 
-    return pMem;
+    return m_pCurBlock->pMem;
 }
 
 VOID* Arena::Alloc(uint32_t size)
@@ -98,19 +258,17 @@ VOID* Arena::Alloc(uint32_t size)
     return AllocAligned(size, 1);
 }
 
-VOID Arena::Reset()
+VOID Arena::Reset(bool removeAll)
 {
+    // Keep the current block for the next set of allocations and hand
+    // everything else back to the block cache.
     if (m_pCurBlock)
     {
         m_pCurBlock->offset = 0;
 
-        // If we needed to allocate used blocks then reset current.
-        // The next time we allocate we'll grow the current block
-        // to match all the memory allocated this for this frame.
-        if (m_pUsedBlocks)
+        if (removeAll)
         {
-            m_pCurBlock->pNext = m_pUsedBlocks;
-            m_pUsedBlocks = m_pCurBlock;
+            gArenaBlockCache.FreeBlock(m_pCurBlock);
             m_pCurBlock = nullptr;
         }
     }
@@ -120,7 +278,6 @@ VOID Arena::Reset()
         ArenaBlock* pBlock = m_pUsedBlocks;
         m_pUsedBlocks = pBlock->pNext;
 
-        _aligned_free(pBlock->pMem);
-        free(pBlock);
+        gArenaBlockCache.FreeBlock(pBlock);
     }
 }
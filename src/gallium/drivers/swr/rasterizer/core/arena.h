@@ -32,32 +32,88 @@
 ******************************************************************************/
 #pragma once
 
+#include <mutex>
+#include <atomic>
+
+struct ArenaBlock
+{
+    ArenaBlock() : pMem(nullptr), blockSize(0), pNext(nullptr) {}
+
+    VOID        *pMem;
+    uint32_t    blockSize;
+    uint32_t    offset;
+    uint32_t    sizeClass;      // ArenaBlockCache bin, NumSizeClasses if uncached.
+    uint32_t    numaNode;       // node of the thread that first allocated the block.
+    ArenaBlock *pNext;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// ArenaBlockCache
+/// @brief Process wide cache of arena blocks. Arenas hand their blocks
+///        back here on Reset instead of freeing them and pull blocks from
+///        the calling thread's NUMA node before going to the system
+///        allocator. Blocks are binned by power of two size class; each
+///        node keeps at most KNOB_ARENA_CACHE_MAX_SIZE_MB cached and frees
+///        (trims) anything returned beyond that.
+///
+///        In front of the node lists every thread keeps a few blocks per
+///        size class that it recycles without taking a lock. Only blocks
+///        from the thread's own node go there.
+class ArenaBlockCache
+{
+public:
+    static const uint32_t BlockSize = 1024 * 1024;
+    static const uint32_t NumSizeClasses = 8;       // 1MB - 128MB
+    static const uint32_t MaxNumaNodes = 8;
+    static const uint32_t MaxThreadCachedBlocks = 4;    // per size class
+
+    ArenaBlockCache();
+
+    ArenaBlock* AllocBlock(uint32_t size);
+    VOID        FreeBlock(ArenaBlock* pBlock);
+    VOID        GetStats(SWR_ARENA_CACHE_STATS& stats);
+
+    // Worker threads call this once so their allocations come from,
+    // and fresh blocks get first touched on, their own node.
+    static VOID SetThreadNumaNode(uint32_t numaNode);
+
+    // Hands the calling thread's blocks back to their node lists. Threads
+    // that used arenas call this before they exit.
+    VOID        FlushThreadCache();
+
+private:
+    struct NodeCache
+    {
+        std::mutex  lock;               // guards pFreeBlocks
+        ArenaBlock* pFreeBlocks[NumSizeClasses];
+        std::atomic<uint64_t> bytesCached;
+        std::atomic<uint64_t> bytesInUse;
+        std::atomic<uint64_t> blocksAllocated;
+        std::atomic<uint64_t> blocksReused;
+        std::atomic<uint64_t> blocksTrimmed;
+    };
+
+    bool        CacheBytes(NodeCache& node, uint32_t blockSize);
+
+    NodeCache mNodes[MaxNumaNodes];
+};
+
+extern ArenaBlockCache gArenaBlockCache;
+
 class Arena
 {
 public:
-    Arena() : m_pCurBlock(nullptr), m_pUsedBlocks(nullptr), m_memUsed(0) { }
+    Arena() : m_pCurBlock(nullptr), m_pUsedBlocks(nullptr) { }
     ~Arena() { }
 
     VOID    Init();
 
     VOID*   AllocAligned(uint32_t  size, uint32_t  align);
     VOID*   Alloc(uint32_t  size);
-    VOID    Reset();
+    VOID    Reset(bool removeAll = false);
 
 private:
 
-    struct ArenaBlock
-    {
-        ArenaBlock() : pMem(nullptr), blockSize(0), pNext(nullptr) {}
-
-        VOID        *pMem;
-        uint32_t    blockSize;
-        uint32_t    offset;
-        ArenaBlock *pNext;
-    };
-
     ArenaBlock      *m_pCurBlock;
     ArenaBlock      *m_pUsedBlocks;
-
-    uint32_t        m_memUsed;      // total bytes allocated since last reset.
 };
@@ -217,6 +217,7 @@ INLINE void ClearMacroTile(DRAW_CONTEXT *pDC, SWR_RENDERTARGET_ATTACHMENT rt, ui
     const uint32_t pitch = (FormatTraits<format>::bpp * KNOB_MACROTILE_X_DIM / 8);
 
     HOTTILE *pHotTile = pDC->pContext->pHotTileMgr->GetHotTile(pDC->pContext, pDC, macroTile, rt, true, numSamples);
+    SWR_ASSERT(pHotTile->format == format, "Clearing hot tile with mismatched format");
     uint32_t rasterTileStartOffset = (ComputeTileOffset2D< TilingTraits<SWR_TILE_SWRZ, FormatTraits<format>::bpp > >(pitch, left, top)) * numSamples;
     uint8_t* pRasterTileRow = pHotTile->pBuffer + rasterTileStartOffset; //(ComputeTileOffset2D< TilingTraits<SWR_TILE_SWRZ, FormatTraits<format>::bpp > >(pitch, x, y)) * numSamples;
 
@@ -231,6 +232,12 @@ INLINE void ClearMacroTile(DRAW_CONTEXT *pDC, SWR_RENDERTARGET_ATTACHMENT rt, ui
                 ClearRasterTile<format>(pRasterTile, vClear);
                 pRasterTile += rasterTileSampleStep;
             }
+
+            if (pHotTile->pHiZ != nullptr)
+            {
+                HIZ_TILE& hiZ = pHotTile->pHiZ[y * KNOB_MACROTILE_X_DIM_IN_TILES + x];
+                hiZ.zMin = hiZ.zMax = *(float*)&clear[0];
+            }
         }
         pRasterTileRow += macroTileRowStep;
     }
@@ -300,7 +307,7 @@ void ProcessClearBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, vo
             clearData[2] = *(DWORD*)&clearFloat[2];
             clearData[3] = *(DWORD*)&clearFloat[3];
 
-            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[KNOB_COLOR_HOT_TILE_FORMAT];
+            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[GetApiState(pDC).backendState.colorHotTileFormat[0]];
             SWR_ASSERT(pfnClearTiles != nullptr);
 
             pfnClearTiles(pDC, SWR_ATTACHMENT_COLOR0, macroTile, clearData);
@@ -340,51 +347,59 @@ void ProcessStoreTileBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile
 #ifdef KNOB_ENABLE_RDTSC
     uint32_t numTiles = 0;
 #endif
-    SWR_FORMAT srcFormat;
-    switch (pDesc->attachment)
-    {
-    case SWR_ATTACHMENT_COLOR0:
-    case SWR_ATTACHMENT_COLOR1:
-    case SWR_ATTACHMENT_COLOR2:
-    case SWR_ATTACHMENT_COLOR3:
-    case SWR_ATTACHMENT_COLOR4:
-    case SWR_ATTACHMENT_COLOR5:
-    case SWR_ATTACHMENT_COLOR6:
-    case SWR_ATTACHMENT_COLOR7: srcFormat = KNOB_COLOR_HOT_TILE_FORMAT; break;
-    case SWR_ATTACHMENT_DEPTH: srcFormat = KNOB_DEPTH_HOT_TILE_FORMAT; break;
-    case SWR_ATTACHMENT_STENCIL: srcFormat = KNOB_STENCIL_HOT_TILE_FORMAT; break;
-    default: SWR_ASSERT(false, "Unknown attachment: %d", pDesc->attachment); srcFormat = KNOB_COLOR_HOT_TILE_FORMAT; break;
-    }
-
     uint32_t x, y;
     MacroTileMgr::getTileIndices(macroTile, x, y);
 
-    // Only need to store the hottile if it's been rendered to...
-    HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, pDesc->attachment, false);
-    if (pHotTile)
+    for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; ++i)
     {
-        // clear if clear is pending (i.e., not rendered to), then mark as dirty for store.
-        if (pHotTile->state == HOTTILE_CLEAR)
+        if (!(pDesc->attachmentMask & (1 << i)))
         {
-            PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[srcFormat];
-            SWR_ASSERT(pfnClearTiles != nullptr);
-
-            pfnClearTiles(pDC, pDesc->attachment, macroTile, pHotTile->clearData);
+            continue;
         }
 
-        if (pHotTile->state == HOTTILE_DIRTY || pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_DIRTY)
+        // Only need to store the hottile if it's been rendered to...
+        // Every resident array slice of the attachment is stored.
+        SWR_RENDERTARGET_ATTACHMENT attachment = (SWR_RENDERTARGET_ATTACHMENT)i;
+        HOTTILE *pFirstLayer = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, attachment, false);
+        for (HOTTILE *pHotTile = pFirstLayer; pHotTile != nullptr; pHotTile = pHotTile->pNextLayer)
         {
-            int destX = KNOB_MACROTILE_X_DIM * x;
-            int destY = KNOB_MACROTILE_Y_DIM * y;
+            if (pHotTile->pBuffer == nullptr)
+            {
+                continue;
+            }
 
-            pContext->pfnStoreTile(GetPrivateState(pDC), srcFormat,
-                pDesc->attachment, destX, destY, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
-        }
-        
+            SWR_FORMAT srcFormat = pHotTile->format;
 
-        if (pHotTile->state == HOTTILE_DIRTY || pHotTile->state == HOTTILE_RESOLVED)
-        {
-            pHotTile->state = (HOTTILE_STATE)pDesc->postStoreTileState;
+            // clear if clear is pending (i.e., not rendered to), then mark as dirty for store.
+            if (pHotTile->state == HOTTILE_CLEAR)
+            {
+                PFN_CLEAR_TILES pfnClearTiles = sClearTilesTable[srcFormat];
+                SWR_ASSERT(pfnClearTiles != nullptr);
+
+                pfnClearTiles(pDC, attachment, macroTile, pHotTile->clearData);
+            }
+
+            if (pHotTile->state == HOTTILE_DIRTY || pDesc->postStoreTileState == (SWR_TILE_STATE)HOTTILE_DIRTY)
+            {
+                int destX = KNOB_MACROTILE_X_DIM * x;
+                int destY = KNOB_MACROTILE_Y_DIM * y;
+
+                HotTileMgr::StoreHotTile(pContext, pDC, attachment, destX, destY, pHotTile);
+#ifdef KNOB_ENABLE_RDTSC
+                numTiles++;
+#endif
+            }
+
+            if (pHotTile->state == HOTTILE_DIRTY || pHotTile->state == HOTTILE_RESOLVED)
+            {
+                pHotTile->state = (HOTTILE_STATE)pDesc->postStoreTileState;
+            }
+
+            // the surface is going away, don't keep its tiles pinned when memory is budgeted
+            if (pHotTile->state == HOTTILE_INVALID && pContext->pHotTileMgr->HasBudget())
+            {
+                pContext->pHotTileMgr->ReleaseHotTile(*pHotTile);
+            }
         }
     }
     RDTSC_STOP(BEStoreTiles, numTiles, pDC->drawId);
@@ -400,8 +415,8 @@ void ProcessInvalidateTilesBE(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t mac
     {
         if (pDesc->attachmentMask & (1 << i))
         {
-            HOTTILE *pHotTile = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, (SWR_RENDERTARGET_ATTACHMENT)i, false);
-            if (pHotTile)
+            HOTTILE *pFirstLayer = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroTile, (SWR_RENDERTARGET_ATTACHMENT)i, false);
+            for (HOTTILE *pHotTile = pFirstLayer; pHotTile != nullptr; pHotTile = pHotTile->pNextLayer)
             {
                 pHotTile->state = HOTTILE_INVALID;
             }
@@ -449,6 +464,84 @@ simdmask ComputeUserClipMask(uint8_t clipMask, float* pUserClipBuffer, simdscala
     return _simd_movemask_ps(vClipMask);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Writes shaded color to a simd tile of a color hot tile in a
+///        format other than RGBA32_FLOAT. Destination is converted to float,
+///        merged under the pixel and color write masks, and converted back.
+template<SWR_FORMAT HotTileFormat>
+INLINE void OutputMergerConvert(const SWR_RENDER_TARGET_BLEND_STATE *pRTBlend, simdscalar mask, const simdvector &src, uint8_t *pColorSample)
+{
+    simdvector dst;
+    LoadSOA<HotTileFormat>(pColorSample, dst);
+
+    if (!pRTBlend->writeDisableRed)
+    {
+        dst.x = _simd_blendv_ps(dst.x, src.x, mask);
+    }
+    if (!pRTBlend->writeDisableGreen)
+    {
+        dst.y = _simd_blendv_ps(dst.y, src.y, mask);
+    }
+    if (!pRTBlend->writeDisableBlue)
+    {
+        dst.z = _simd_blendv_ps(dst.z, src.z, mask);
+    }
+    if (!pRTBlend->writeDisableAlpha)
+    {
+        dst.w = _simd_blendv_ps(dst.w, src.w, mask);
+    }
+
+    StoreSOA<HotTileFormat>(dst, pColorSample);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Writes shaded color to a simd tile of a color hot tile, honoring
+///        the pixel mask and the per-channel color write masks.
+/// @param hotTileFormat - format of the color hot tile
+/// @param pRTBlend - render target blend state
+/// @param mask - pixel coverage mask
+/// @param src - shaded color
+/// @param pColorSample - simd tile in the hot tile
+INLINE void OutputMerger(SWR_FORMAT hotTileFormat, const SWR_RENDER_TARGET_BLEND_STATE *pRTBlend, simdscalari mask, const simdvector &src, uint8_t *pColorSample)
+{
+    switch (hotTileFormat)
+    {
+    case KNOB_COLOR_HOT_TILE_FORMAT: break;
+    case KNOB_COLOR_HOT_TILE_FORMAT_UNORM8:
+        OutputMergerConvert<KNOB_COLOR_HOT_TILE_FORMAT_UNORM8>(pRTBlend, _simd_castsi_ps(mask), src, pColorSample);
+        return;
+    case KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16:
+        OutputMergerConvert<KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16>(pRTBlend, _simd_castsi_ps(mask), src, pColorSample);
+        return;
+    default:
+        SWR_ASSERT(false, "Unsupported hot tile format: %d", hotTileFormat);
+        return;
+    }
+
+    ///@todo can only use maskstore fast path if bpc is 32. Assuming hot tile is RGBA32_FLOAT.
+    static_assert(KNOB_COLOR_HOT_TILE_FORMAT == R32G32B32A32_FLOAT, "Unsupported hot tile format");
+
+    const uint32_t simd = KNOB_SIMD_WIDTH * sizeof(float);
+
+    // store with color mask
+    if (!pRTBlend->writeDisableRed)
+    {
+        _simd_maskstore_ps((float*)pColorSample, mask, src.x);
+    }
+    if (!pRTBlend->writeDisableGreen)
+    {
+        _simd_maskstore_ps((float*)(pColorSample + simd), mask, src.y);
+    }
+    if (!pRTBlend->writeDisableBlue)
+    {
+        _simd_maskstore_ps((float*)(pColorSample + simd * 2), mask, src.z);
+    }
+    if (!pRTBlend->writeDisableAlpha)
+    {
+        _simd_maskstore_ps((float*)(pColorSample + simd * 3), mask, src.w);
+    }
+}
+
 template<uint32_t MaxRT, SWR_MULTISAMPLE_COUNT sampleCount>
 void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t y, SWR_TRIANGLE_DESC &work, RenderOutputBuffers &renderBuffers)
 {
@@ -480,9 +573,15 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
     simdscalar vCOneOverW = _simd_broadcast_ss(&work.OneOverW[2]);
 
     uint8_t *pColorBase[SWR_NUM_RENDERTARGETS];
+    SWR_FORMAT colorHotTileFormat[SWR_NUM_RENDERTARGETS];
+    uint32_t colorSimdTileStep[SWR_NUM_RENDERTARGETS];
+    uint32_t colorRasterTileStep[SWR_NUM_RENDERTARGETS];
     for(uint32_t rt = 0; rt <= MaxRT; ++rt)
     {
         pColorBase[rt] = renderBuffers.pColor[rt];
+        colorHotTileFormat[rt] = state.backendState.colorHotTileFormat[rt];
+        colorSimdTileStep[rt] = KNOB_SIMD_WIDTH * GetFormatInfo(colorHotTileFormat[rt]).Bpp;
+        colorRasterTileStep[rt] = KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * GetFormatInfo(colorHotTileFormat[rt]).Bpp;
     }
     uint8_t *pDepthBase = renderBuffers.pDepth, *pStencilBase = renderBuffers.pStencil;
     RDTSC_STOP(BESetup, 0, 0);
@@ -600,7 +699,7 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
                     // execute pixel shader
                     RDTSC_START(BEPixelShader);
                     state.psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
-                    RDTSC_STOP(BEPixelShader, 0, 0);
+                    RDTSC_STOP(BEPixelShader, 0, pDC->drawId);
 
                     depthPassMask = _simd_castsi_ps(psContext.mask);
 
@@ -636,7 +735,6 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
                         }
                     }
 
-                    uint32_t rasterTileColorOffset = MultisampleTraits<sampleCount>::RasterTileColorOffset(sample);
                     for (uint32_t rt = 0; rt <= MaxRT; ++rt)
                     {
                         uint8_t *pColorSample;
@@ -646,7 +744,7 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
                         }
                         else
                         {
-                            pColorSample = pColorBase[rt] + rasterTileColorOffset;
+                            pColorSample = pColorBase[rt] + sample * colorRasterTileStep[rt];
                         }
 
                         const SWR_RENDER_TARGET_BLEND_STATE *pRTBlend = &pBlendState->renderTarget[rt];
@@ -657,28 +755,7 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
                             state.pfnBlendFunc[rt](pBlendState, psContext.shaded[rt], psContext.shaded[1], pColorSample, psContext.shaded[rt]);
                         }
 
-                        ///@todo can only use maskstore fast path if bpc is 32. Assuming hot tile is RGBA32_FLOAT.
-                        static_assert(KNOB_COLOR_HOT_TILE_FORMAT == R32G32B32A32_FLOAT, "Unsupported hot tile format");
-
-                        const uint32_t simd = KNOB_SIMD_WIDTH * sizeof(float);
-
-                        // store with color mask
-                        if (!pRTBlend->writeDisableRed)
-                        {
-                            _simd_maskstore_ps((float*)pColorSample, mask, psContext.shaded[rt].x);
-                        }
-                        if (!pRTBlend->writeDisableGreen)
-                        {
-                            _simd_maskstore_ps((float*)(pColorSample + simd), mask, psContext.shaded[rt].y);
-                        }
-                        if (!pRTBlend->writeDisableBlue)
-                        {
-                            _simd_maskstore_ps((float*)(pColorSample + simd * 2), mask, psContext.shaded[rt].z);
-                        }
-                        if (!pRTBlend->writeDisableAlpha)
-                        {
-                            _simd_maskstore_ps((float*)(pColorSample + simd * 3), mask, psContext.shaded[rt].w);
-                        }
+                        OutputMerger(colorHotTileFormat[rt], pRTBlend, mask, psContext.shaded[rt], pColorSample);
                     }
 
                     RDTSC_STOP(BEOutputMerger, 0, 0);
@@ -691,7 +768,7 @@ void BackendSampleRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_
 
             for (uint32_t rt = 0; rt <= MaxRT; ++rt)
             {
-                pColorBase[rt] += (KNOB_SIMD_WIDTH * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp) / 8;
+                pColorBase[rt] += colorSimdTileStep[rt];
             }
             RDTSC_STOP(BEEndTile, 0, 0);
         }
@@ -729,9 +806,15 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
     simdscalar vCOneOverW = _simd_broadcast_ss(&work.OneOverW[2]);
 
     uint8_t *pColorBase[SWR_NUM_RENDERTARGETS];
+    SWR_FORMAT colorHotTileFormat[SWR_NUM_RENDERTARGETS];
+    uint32_t colorSimdTileStep[SWR_NUM_RENDERTARGETS];
+    uint32_t colorRasterTileStep[SWR_NUM_RENDERTARGETS];
     for(uint32_t rt = 0; rt <= MaxRT; ++rt)
     {
         pColorBase[rt] = renderBuffers.pColor[rt];
+        colorHotTileFormat[rt] = state.backendState.colorHotTileFormat[rt];
+        colorSimdTileStep[rt] = KNOB_SIMD_WIDTH * GetFormatInfo(colorHotTileFormat[rt]).Bpp;
+        colorRasterTileStep[rt] = KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * GetFormatInfo(colorHotTileFormat[rt]).Bpp;
     }
     uint8_t *pDepthBase = renderBuffers.pDepth, *pStencilBase = renderBuffers.pStencil;
     RDTSC_STOP(BESetup, 0, 0);
@@ -789,7 +872,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
                 // execute pixel shader
                 RDTSC_START(BEPixelShader);
                 state.psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
-                RDTSC_STOP(BEPixelShader, 0, 0);
+                RDTSC_STOP(BEPixelShader, 0, pDC->drawId);
             }
             else
             {
@@ -886,7 +969,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
                 // execute pixel shader
                 RDTSC_START(BEPixelShader);
                 state.psState.pfnPixelShader(GetPrivateState(pDC), &psContext);
-                RDTSC_STOP(BEPixelShader, 0, 0);
+                RDTSC_STOP(BEPixelShader, 0, pDC->drawId);
             }
             else
             {
@@ -911,10 +994,9 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
                     continue;
                 }
                 simdscalari mask = _simd_castps_si(depthPassMask[sample]);
-                uint32_t rasterTileColorOffset = MultisampleTraits<sampleCount>::RasterTileColorOffset(sample);
                 for(uint32_t rt = 0; rt <= MaxRT; ++rt)
                 {
-                    uint8_t *pColorSample = pColorBase[rt] + rasterTileColorOffset;
+                    uint8_t *pColorSample = pColorBase[rt] + sample * colorRasterTileStep[rt];
 
                     const SWR_RENDER_TARGET_BLEND_STATE *pRTBlend = &pBlendState->renderTarget[rt];
 
@@ -924,28 +1006,7 @@ void BackendPixelRate(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t
                         state.pfnBlendFunc[rt](pBlendState, psContext.shaded[rt], psContext.shaded[1], pColorSample, psContext.shaded[rt]);
                     }
 
-                    ///@todo can only use maskstore fast path if bpc is 32. Assuming hot tile is RGBA32_FLOAT.
-                    static_assert(KNOB_COLOR_HOT_TILE_FORMAT == R32G32B32A32_FLOAT, "Unsupported hot tile format");
-
-                    const uint32_t simd = KNOB_SIMD_WIDTH * sizeof(float);
-
-                    // store with color mask
-                    if(!pRTBlend->writeDisableRed)
-                    {
-                        _simd_maskstore_ps((float*)pColorSample, mask, psContext.shaded[rt].x);
-                    }
-                    if(!pRTBlend->writeDisableGreen)
-                    {
-                        _simd_maskstore_ps((float*)(pColorSample + simd), mask, psContext.shaded[rt].y);
-                    }
-                    if(!pRTBlend->writeDisableBlue)
-                    {
-                        _simd_maskstore_ps((float*)(pColorSample + simd * 2), mask, psContext.shaded[rt].z);
-                    }
-                    if(!pRTBlend->writeDisableAlpha)
-                    {
-                        _simd_maskstore_ps((float*)(pColorSample + simd * 3), mask, psContext.shaded[rt].w);
-                    }
+                    OutputMerger(colorHotTileFormat[rt], pRTBlend, mask, psContext.shaded[rt], pColorSample);
                 }
                 RDTSC_STOP(BEOutputMerger, 0, 0);
             }
@@ -962,7 +1023,7 @@ Endtile:
 
             for(uint32_t rt = 0; rt <= MaxRT; ++rt)
             {
-                pColorBase[rt] += (KNOB_SIMD_WIDTH * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp) / 8;
+                pColorBase[rt] += colorSimdTileStep[rt];
             }
             RDTSC_STOP(BEEndTile, 0, 0);
         }
@@ -1046,6 +1107,7 @@ void InitClearTilesTable()
     sClearTilesTable[B8G8R8A8_UNORM] = ClearMacroTile<B8G8R8A8_UNORM>;
     sClearTilesTable[R32_FLOAT] = ClearMacroTile<R32_FLOAT>;
     sClearTilesTable[R32G32B32A32_FLOAT] = ClearMacroTile<R32G32B32A32_FLOAT>;
+    sClearTilesTable[R16G16B16A16_FLOAT] = ClearMacroTile<R16G16B16A16_FLOAT>;
     sClearTilesTable[R8_UINT] = ClearMacroTile<R8_UINT>;
 }
 
@@ -277,12 +277,12 @@ INLINE void Clamp(simdvector &src)
     }
 }
 
-template<SWR_TYPE type>
+template<SWR_TYPE type, SWR_FORMAT hotTileFormat = KNOB_COLOR_HOT_TILE_FORMAT>
 void Blend(const SWR_BLEND_STATE *pBlendState, const SWR_RENDER_TARGET_BLEND_STATE *pState, simdvector &src, simdvector& src1, BYTE *pDst, simdvector &result)
 {
     // load render target
     simdvector dst;
-    LoadSOA<KNOB_COLOR_HOT_TILE_FORMAT>(pDst, dst);
+    LoadSOA<hotTileFormat>(pDst, dst);
 
     simdvector constColor;
     constColor.x = _simd_broadcast_ss(&pBlendState->constantColor[0]);
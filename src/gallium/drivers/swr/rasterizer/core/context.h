@@ -129,8 +129,9 @@ struct QUERY_DESC
 
 struct STORE_TILES_DESC
 {
-    SWR_RENDERTARGET_ATTACHMENT attachment;
+    uint32_t attachmentMask;
     SWR_TILE_STATE postStoreTileState;
+    SWR_RECT rect;          // in pixels, right/bottom exclusive
 };
 
 struct COMPUTE_DESC
@@ -294,13 +295,22 @@ OSALIGNLINE(struct) API_STATE
 };
 
 class MacroTileMgr;
+class MacroTileScheduler;
 class DispatchQueue;
 
+// Conservative depth bounds of one raster tile of the depth hot tile, across all samples
+struct HIZ_TILE
+{
+    float zMin;
+    float zMax;
+};
+
 struct RenderOutputBuffers
 {
     uint8_t* pColor[SWR_NUM_RENDERTARGETS];
     uint8_t* pDepth;
     uint8_t* pStencil;
+    HIZ_TILE* pHiZ;
 };
 
 // pipeline function pointer types
@@ -320,6 +330,43 @@ struct DRAW_STATE
     Arena    arena;     // This should only be used by API thread.
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// FE chunks - large draws have their FE split into chunks of the draw's
+///   vertices (or indices) that workers claim one at a time. A chunk bins
+///   into a list of its own, and the lists are merged into the macrotile
+///   queues in chunk order, so per tile BE work stays in primitive order.
+//////////////////////////////////////////////////////////////////////////
+struct FE_BIN_ENTRY
+{
+    uint32_t x, y;      // macrotile
+    BE_WORK work;
+};
+
+struct FE_BIN_BLOCK
+{
+    static const uint32_t NumEntries = 64;
+
+    FE_BIN_BLOCK* pNext;
+    uint32_t numEntries;
+    FE_BIN_ENTRY entries[NumEntries];
+};
+
+struct FE_CHUNK
+{
+    FE_BIN_BLOCK* pFirstBlock;
+    FE_BIN_BLOCK* pLastBlock;
+    volatile bool done;         // binning finished, the chunk can be merged
+};
+
+// Per worker state of a chunked draw. Data binned by a worker's chunks lives
+// in the worker's arena until the draw context is reused.
+struct FE_CHUNK_WORKER
+{
+    Arena arena;
+    FE_CHUNK* pChunk;           // chunk the worker is binning
+    bool used;                  // arena needs to be reset
+};
+
 // Draw Context
 //    The api thread sets up a draw context that exists for the life of the draw.
 //    This draw context maintains all of the state needed for the draw operation.
@@ -346,8 +393,27 @@ struct DRAW_CONTEXT
 
     DRAW_STATE* pState;
     Arena    arena;
+
+    // The following fields are valid if numFeChunks is not 0.
+    uint32_t numFeChunks;                           // FE chunks of FeWork, 0 if not chunked.
+    uint32_t feChunkVerts;                          // Vertices (indices) per chunk.
+    uint32_t feChunkPrims;                          // Primitives per chunk.
+    uint32_t feChunkIndexSize;                      // Index size of indexed draws, 0 if not indexed.
+    FE_CHUNK* pFeChunks;                            // Allocated from arena by the API thread.
+    volatile OSALIGNLINE(LONG) nextFeChunk;         // Next chunk to claim.
+    volatile OSALIGNLINE(uint32_t) feMergeLock;     // Held by the worker merging chunk bins.
+    uint32_t nextFeChunkToMerge;                    // Guarded by feMergeLock.
+    FE_CHUNK_WORKER* pFeChunkWorkers;               // SWR_CONTEXT::NumWorkerThreads entries.
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Arena FE allocations for BE work go to. Chunked draws use the
+///        worker's arena since workers bin chunks of the draw concurrently.
+INLINE Arena& GetFeArena(DRAW_CONTEXT* pDC, uint32_t workerId)
+{
+    return pDC->numFeChunks ? pDC->pFeChunkWorkers[workerId].arena : pDC->arena;
+}
+
 INLINE const API_STATE& GetApiState(const DRAW_CONTEXT* pDC)
 {
     SWR_ASSERT(pDC != nullptr);
@@ -366,6 +432,18 @@ INLINE void* GetPrivateState(const DRAW_CONTEXT* pDC)
 
 class HotTileMgr;
 
+//////////////////////////////////////////////////////////////////////////
+/// WORKER_COUNTERS
+/// @brief Always-on per worker counters sampled by SwrGetDriverCounters.
+///        Each worker only writes its own entry, so they are kept on
+///        separate cache lines and read without synchronizing.
+OSALIGNLINE(struct) WORKER_COUNTERS
+{
+    volatile uint64_t macroTiles;   // Macrotiles worked on by the BE.
+    volatile uint64_t feTicks;      // rdtsc ticks spent in FE work.
+    volatile uint64_t beTicks;      // rdtsc ticks spent in BE and compute work.
+};
+
 struct SWR_CONTEXT
 {
     // Draw Context Ring
@@ -398,12 +476,19 @@ struct SWR_CONTEXT
 
     uint32_t curStateId;               // Current index to the next available entry in the DS ring.
 
+    // Number of pool workers working on this context. Workers are identified
+    // within the context by 0..NumWorkerThreads-1.
     uint32_t NumWorkerThreads;
 
-    THREAD_POOL threadPool; // Thread pool associated with this context
+    THREAD_POOL *pThreadPool;   // Process-wide thread pool shared with other contexts
+    uint32_t poolSlot;          // Index of this context in THREAD_POOL::contexts
+    uint32_t firstWorker;       // Pool workerId of this context's worker 0
 
-    std::condition_variable FifosNotEmpty;
-    std::mutex WaitLock;
+    // NUMA nodes the context's workers run on. Macrotiles are statically
+    // partitioned across them, see GetMacroTileNumaNode.
+    uint32_t NumNumaNodes;
+    uint32_t numaNodeIds[KNOB_MAX_NUMA_NODES_PER_CONTEXT];  // OS node id of each partition
+    uint8_t workerNumaNode[KNOB_MAX_NUM_THREADS];           // Partition of each context worker
 
     // Draw Contexts will get a unique drawId generated from this
     uint64_t nextDrawId;
@@ -424,6 +509,7 @@ struct SWR_CONTEXT
     uint32_t privateStateSize;
 
     HotTileMgr *pHotTileMgr;
+    MacroTileScheduler *pTileScheduler;
 
     // tile load/store functions, passed in at create context time
     PFN_LOAD_TILE pfnLoadTile;
@@ -433,6 +519,14 @@ struct SWR_CONTEXT
     // Global Stats
     SWR_STATS stats[KNOB_MAX_NUM_THREADS];
 
+    // Driver counters, see SwrGetDriverCounters. Hot tile loads and stores
+    // happen outside of any worker id so they are shared and atomic.
+    WORKER_COUNTERS workerCounters[KNOB_MAX_NUM_THREADS];
+    OSALIGNLINE(volatile int64_t) hotTileLoads;
+    OSALIGNLINE(volatile int64_t) hotTileStores;
+    OSALIGNLINE(volatile int64_t) hotTileLayerAllocs;
+    OSALIGNLINE(volatile int64_t) hotTileLayerReloads;
+
     // Scratch space for workers.
     uint8_t* pScratch[KNOB_MAX_NUM_THREADS];
 };
@@ -694,8 +694,39 @@ template<> struct TypeTraits<SWR_TYPE_FLOAT, 16> : PackTraits<16>
     static simdscalar unpack(const simdscalar &in)
     {
         // input is 8 packed float16, output is 8 packed float32
-        SWR_ASSERT(0); // @todo
-        return _simd_setzero_ps();
+#if KNOB_SIMD_WIDTH == 8
+#if (KNOB_ARCH == KNOB_ARCH_AVX)
+        simdscalar packed = in;
+        simdscalari src = _simd_castps_si(PackTraits<16>::unpack(packed));
+
+        static const uint32_t HALF_EXP_MASK = 0x7C00;
+        static const uint32_t HALF_MANTISSA_BITS = 10;
+        static const uint32_t FLOAT_MANTISSA_BITS = 23;
+        static const uint32_t EXP_REBIAS = (127 - 15) << FLOAT_MANTISSA_BITS;
+
+        simdscalari vSign   = _simd_slli_epi32(_simd_and_si(src, _simd_set1_epi32(0x8000)), 16);
+        simdscalari vExpMan = _simd_and_si(src, _simd_set1_epi32(0x7FFF));
+
+        // normals: shift exponent and mantissa into place and rebias the exponent
+        simdscalari vNorm = _simd_add_epi32(_simd_slli_epi32(vExpMan, FLOAT_MANTISSA_BITS - HALF_MANTISSA_BITS),
+                                            _simd_set1_epi32(EXP_REBIAS));
+
+        // infinities / NaN
+        simdscalari vInfMask = _simd_cmpgt_epi32(vExpMan, _simd_set1_epi32(HALF_EXP_MASK - 1));
+        vNorm = _simd_or_si(vNorm, _simd_and_si(vInfMask, _simd_set1_epi32(0x7F800000)));
+
+        // zero and denormals: mantissa * 2^-24
+        simdscalar vDenormMask = _simd_castsi_ps(_simd_cmplt_epi32(vExpMan, _simd_set1_epi32(1 << HALF_MANTISSA_BITS)));
+        simdscalar vDenorm = _simd_mul_ps(_simd_cvtepi32_ps(vExpMan), _simd_set1_ps(1.0f / 16777216.0f));
+
+        simdscalar vResult = _simd_blendv_ps(_simd_castsi_ps(vNorm), vDenorm, vDenormMask);
+        return _simd_or_ps(vResult, _simd_castsi_ps(vSign));
+#else
+        return _mm256_cvtph_ps(_mm_castps_si128(_mm256_castps256_ps128(in)));
+#endif
+#else
+#error Unsupported vector width
+#endif
     }
 };
 
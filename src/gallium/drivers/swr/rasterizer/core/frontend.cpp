@@ -143,7 +143,7 @@ void ProcessClear(
 }
 
 //////////////////////////////////////////////////////////////////////////
-/// @brief FE handler for SwrStoreTiles.
+/// @brief FE handler for SwrStoreTiles and SwrStoreTilesRect.
 /// @param pContext - pointer to SWR context.
 /// @param pDC - pointer to draw context.
 /// @param workerId - thread's worker id. Even thread has a unique id.
@@ -159,27 +159,30 @@ void ProcessStoreTiles(
     STORE_TILES_DESC *pStore = (STORE_TILES_DESC*)pUserData;
     MacroTileMgr *pTileMgr = pDC->pTileMgr;
 
-    const API_STATE& state = GetApiState(pDC);
-
-    // queue a store to each macro tile
-    // compute macro tile bounds for the current render target
+    // queue a store to each macro tile intersecting the store rect
     const uint32_t macroWidth = KNOB_MACROTILE_X_DIM;
     const uint32_t macroHeight = KNOB_MACROTILE_Y_DIM;
 
-    uint32_t numMacroTilesX = ((uint32_t)state.vp[0].width + (uint32_t)state.vp[0].x + (macroWidth - 1)) / macroWidth;
-    uint32_t numMacroTilesY = ((uint32_t)state.vp[0].height + (uint32_t)state.vp[0].y + (macroHeight - 1)) / macroHeight;
+    const SWR_RECT &rect = pStore->rect;
+    if (rect.right > rect.left && rect.bottom > rect.top)
+    {
+        uint32_t macroTileXMin = rect.left / macroWidth;
+        uint32_t macroTileYMin = rect.top / macroHeight;
+        uint32_t macroTileXMax = (rect.right - 1) / macroWidth;
+        uint32_t macroTileYMax = (rect.bottom - 1) / macroHeight;
 
-    // store tiles
-    BE_WORK work;
-    work.type = STORETILES;
-    work.pfnWork = ProcessStoreTileBE;
-    work.desc.storeTiles = *pStore;
+        // store tiles
+        BE_WORK work;
+        work.type = STORETILES;
+        work.pfnWork = ProcessStoreTileBE;
+        work.desc.storeTiles = *pStore;
 
-    for (uint32_t x = 0; x < numMacroTilesX; ++x)
-    {
-        for (uint32_t y = 0; y < numMacroTilesY; ++y)
+        for (uint32_t x = macroTileXMin; x <= macroTileXMax; ++x)
         {
-            pTileMgr->enqueue(x, y, &work);
+            for (uint32_t y = macroTileYMin; y <= macroTileYMax; ++y)
+            {
+                pTileMgr->enqueue(x, y, &work);
+            }
         }
     }
 
@@ -670,10 +673,11 @@ static void GeometryShaderStage(
 //////////////////////////////////////////////////////////////////////////
 /// @brief Allocate GS buffers
 /// @param pDC - pointer to draw context.
+/// @param workerId - thread's worker id.
 /// @param state - API state
 /// @param ppGsOut - pointer to GS output buffer allocation
 /// @param ppCutBuffer - pointer to GS output cut buffer allocation
-static INLINE void AllocateGsBuffers(DRAW_CONTEXT* pDC, const API_STATE& state, void** ppGsOut, void** ppCutBuffer)
+static INLINE void AllocateGsBuffers(DRAW_CONTEXT* pDC, uint32_t workerId, const API_STATE& state, void** ppGsOut, void** ppCutBuffer)
 {
     SWR_ASSERT(state.gsState.gsEnable);
     // allocate arena space to hold GS output verts
@@ -682,13 +686,13 @@ static INLINE void AllocateGsBuffers(DRAW_CONTEXT* pDC, const API_STATE& state,
     const uint32_t vertexStride = sizeof(simdvertex);
     const uint32_t numSimdBatches = (state.gsState.maxNumVerts + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH;
     uint32_t size = state.gsState.instanceCount * numSimdBatches * vertexStride * KNOB_SIMD_WIDTH;
-    *ppGsOut = pDC->arena.AllocAligned(size, KNOB_SIMD_WIDTH * sizeof(float));
+    *ppGsOut = GetFeArena(pDC, workerId).AllocAligned(size, KNOB_SIMD_WIDTH * sizeof(float));
 
     // allocate arena space to hold cut buffer, which is essentially a bitfield sized to the
     // maximum vertex output as defined by the GS state, per SIMD lane, per GS instance
     const uint32_t cutPrimStride = (state.gsState.maxNumVerts + 7) / 8;
     const uint32_t cutBufferSize = cutPrimStride * state.gsState.instanceCount * KNOB_SIMD_WIDTH;
-    *ppCutBuffer = pDC->arena.AllocAligned(cutBufferSize, KNOB_SIMD_WIDTH * sizeof(float));
+    *ppCutBuffer = GetFeArena(pDC, workerId).AllocAligned(cutBufferSize, KNOB_SIMD_WIDTH * sizeof(float));
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -911,6 +915,240 @@ static void TessellationStages(
     TSDestroyCtx(tsCtx);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Post-transform vertex cache for indexed draws. Indices are resolved
+///        a window at a time ahead of the PA: indices seen recently reuse the
+///        vertex shaded for them, the rest are fetched and shaded packed into
+///        full SIMDs. Shaded vertices are kept in SOA form and every vertex
+///        shader invocation fills one KNOB_SIMD_WIDTH aligned block of entries.
+struct VertexCacheThreadLocalData
+{
+    static const uint32_t NUM_ENTRIES = 256;                    // shaded vertices kept
+    static const uint32_t NUM_TAGS = 512;                       // direct mapped index -> entry table
+    static const uint32_t WINDOW_SIZE = 8 * KNOB_SIMD_WIDTH;    // indices resolved ahead of the PA
+    static_assert(NUM_ENTRIES >= 2 * WINDOW_SIZE, "Window must not evict its own vertices");
+
+    // shaded attributes, indexed by [(slot * 4 + component) * NUM_ENTRIES + entry]
+    float attribs[KNOB_NUM_ATTRIBUTES * 4 * NUM_ENTRIES];
+    uint8_t cut[NUM_ENTRIES];                       // entry's index is the cut index
+
+    // entry = seq % NUM_ENTRIES, where seq is the allocation sequence number of the entry
+    uint32_t tagIndex[NUM_TAGS];
+    uint32_t tagSeq[NUM_TAGS];
+    uint32_t nextSeq;
+
+    // entries for the indices of the current window and the packed indices shaded for it
+    uint32_t windowStart;
+    uint32_t windowEnd;
+    OSALIGNSIMD(uint32_t) windowEntries[WINDOW_SIZE];
+    OSALIGNSIMD(uint32_t) missIndices[WINDOW_SIZE + KNOB_SIMD_WIDTH];
+
+    simdvertex vout;
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Drops every cached vertex. Called whenever the vertex shader
+    ///        inputs change, i.e. per draw and per instance.
+    void Reset()
+    {
+        // advancing a whole cache's worth of entries ages out every tag
+        nextSeq += NUM_ENTRIES;
+        if (nextSeq >= 0x80000000)
+        {
+            memset(tagSeq, 0, sizeof(tagSeq));
+            nextSeq = NUM_ENTRIES;
+        }
+        windowStart = windowEnd = 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Resolves the next window of indices to cache entries, shading
+    ///        the indices that miss.
+    /// @param start - first index of the window, relative to the draw
+    /// @param end - end of the indices of the draw
+    void ResolveWindow(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t workerId, const DRAW_WORK& work,
+        SWR_FETCH_CONTEXT fetchInfo, SWR_VS_CONTEXT& vsContext, uint32_t indexSize, uint64_t slotMask,
+        uint32_t start, uint32_t end)
+    {
+        const API_STATE& state = GetApiState(pDC);
+        const uint8_t* pIndices = (const uint8_t*)work.pIB + start * indexSize;
+        const uint32_t numIndices = std::min(end - start, WINDOW_SIZE);
+
+        // tags allocated at or after seqLo are guaranteed to survive the allocations of this window
+        const uint32_t seqLo = nextSeq + WINDOW_SIZE - NUM_ENTRIES;
+        uint32_t numMisses = 0;
+
+        for (uint32_t lane = 0; lane < numIndices; ++lane)
+        {
+            // indices past the end of the index buffer fetch vertex 0, like the fetch shader
+            const uint8_t* pIndex = pIndices + lane * indexSize;
+            uint32_t index = 0;
+            if (pIndex < (const uint8_t*)fetchInfo.pLastIndex)
+            {
+                switch (indexSize)
+                {
+                case sizeof(uint32_t): index = *(const uint32_t*)pIndex; break;
+                case sizeof(uint16_t): index = *(const uint16_t*)pIndex; break;
+                default:               index = *pIndex; break;
+                }
+            }
+
+            uint32_t tag = index & (NUM_TAGS - 1);
+            uint32_t seq = tagSeq[tag];
+            if (tagIndex[tag] != index || (seq - seqLo) >= (nextSeq + numMisses - seqLo))
+            {
+                seq = nextSeq + numMisses;
+                tagIndex[tag] = index;
+                tagSeq[tag] = seq;
+
+                switch (indexSize)
+                {
+                case sizeof(uint32_t): ((uint32_t*)missIndices)[numMisses] = index; break;
+                case sizeof(uint16_t): ((uint16_t*)missIndices)[numMisses] = (uint16_t)index; break;
+                default:               ((uint8_t*)missIndices)[numMisses] = (uint8_t)index; break;
+                }
+                numMisses++;
+            }
+            windowEntries[lane] = seq % NUM_ENTRIES;
+        }
+
+        for (uint32_t lane = numIndices; lane < WINDOW_SIZE; ++lane)
+        {
+            windowEntries[lane] = 0;
+        }
+
+        // shade the misses a SIMD at a time into consecutive blocks of entries
+        fetchInfo.pLastIndex = (const int32_t*)((const uint8_t*)missIndices + numMisses * indexSize);
+        vsContext.pVout = &vout;
+        for (uint32_t m = 0; m < numMisses; m += KNOB_SIMD_WIDTH)
+        {
+            fetchInfo.pIndices = (const int32_t*)((const uint8_t*)missIndices + m * indexSize);
+
+            RDTSC_START(FEFetchShader);
+            state.pfnFetchFunc(fetchInfo, *vsContext.pVin);
+            RDTSC_STOP(FEFetchShader, 0, 0);
+
+            vsContext.VertexID = fetchInfo.VertexID;
+            vsContext.mask = GenerateMask(numMisses - m);
+
+            RDTSC_START(FEVertexShader);
+            state.pfnVertexFunc(GetPrivateState(pDC), &vsContext);
+            RDTSC_STOP(FEVertexShader, 0, 0);
+
+            UPDATE_STAT(VsInvocations, GetNumInvocations(m, numMisses));
+
+            uint32_t entry = (nextSeq + m) % NUM_ENTRIES;
+            DWORD slot;
+            uint64_t slots = slotMask;
+            while (_BitScanForward64(&slot, slots))
+            {
+                slots &= ~(1ULL << slot);
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    _simd_store_ps(&attribs[(slot * 4 + c) * NUM_ENTRIES + entry], vout.attrib[slot].v[c]);
+                }
+            }
+
+            uint32_t cutMask = _simd_movemask_ps(_simd_castsi_ps(fetchInfo.CutMask));
+            for (uint32_t lane = 0; lane < KNOB_SIMD_WIDTH; ++lane)
+            {
+                cut[entry + lane] = (cutMask >> lane) & 1;
+            }
+        }
+
+        nextSeq += AlignUp(numMisses, KNOB_SIMD_WIDTH);
+        windowStart = start;
+        windowEnd = start + numIndices;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Gathers the shaded vertices of a SIMD of indices of the current
+    ///        window for the PA.
+    /// @param index - first index of the SIMD, relative to the draw
+    /// @param vOut - PA vertex store
+    /// @param cutMask - cut mask of the SIMD for the PA
+    void Gather(uint32_t index, uint64_t slotMask, simdvertex& vOut, simdmask& cutMask)
+    {
+        const uint32_t* pEntries = &windowEntries[index - windowStart];
+        simdscalari vEntries = _simd_load_si((const simdscalari*)pEntries);
+
+        DWORD slot;
+        while (_BitScanForward64(&slot, slotMask))
+        {
+            slotMask &= ~(1ULL << slot);
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                vOut.attrib[slot].v[c] = _simd_i32gather_ps(&attribs[(slot * 4 + c) * NUM_ENTRIES], vEntries, 4);
+            }
+        }
+
+        cutMask = 0;
+        for (uint32_t lane = 0; lane < KNOB_SIMD_WIDTH; ++lane)
+        {
+            cutMask |= cut[pEntries[lane]] << lane;
+        }
+    }
+};
+
+THREAD VertexCacheThreadLocalData* gt_pVertexCacheThreadData = nullptr;
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Allocate the vertex cache for this worker thread.
+INLINE
+static void AllocateVertexCache()
+{
+    if (gt_pVertexCacheThreadData == nullptr)
+    {
+        gt_pVertexCacheThreadData = (VertexCacheThreadLocalData*)
+            _aligned_malloc(sizeof(VertexCacheThreadLocalData), 64);
+        memset(gt_pVertexCacheThreadData, 0, sizeof(*gt_pVertexCacheThreadData));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Free the vertex cache of the calling thread, if it has one.
+void FreeVertexCache()
+{
+    _aligned_free(gt_pVertexCacheThreadData);
+    gt_pVertexCacheThreadData = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the mask of vertex attribute slots read downstream of the
+///        vertex shader when there is no GS or tessellation, i.e. the slots
+///        the vertex cache has to keep.
+static uint64_t GetVertexCacheSlotMask(const API_STATE& state)
+{
+    uint64_t slotMask = 1ULL << VERTEX_POSITION_SLOT;
+
+    // attributes routed to the PS
+    for (uint32_t i = 0; i < state.linkageCount; ++i)
+    {
+        slotMask |= 1ULL << (VERTEX_ATTRIB_START_SLOT + state.linkageMap[i]);
+    }
+
+    // streamout
+    if (state.soState.soEnable)
+    {
+        for (uint32_t i = 0; i < MAX_SO_STREAMS; ++i)
+        {
+            slotMask |= (uint64_t)state.soState.streamMasks[i] << VERTEX_ATTRIB_START_SLOT;
+        }
+    }
+
+    if (state.rastState.clipDistanceMask || state.rastState.cullDistanceMask)
+    {
+        slotMask |= 1ULL << VERTEX_CLIPCULL_DIST_LO_SLOT;
+        slotMask |= 1ULL << VERTEX_CLIPCULL_DIST_HI_SLOT;
+    }
+
+    if (state.rastState.pointParam)
+    {
+        slotMask |= 1ULL << state.rastState.pointSizeAttrib;
+    }
+
+    return slotMask & ((1ULL << KNOB_NUM_ATTRIBUTES) - 1);
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief FE handler for SwrDraw.
 /// @tparam IsIndexedT - Is indexed drawing enabled
@@ -1009,7 +1247,7 @@ void ProcessDraw(
     void* pCutBuffer = nullptr;
     if (HasGeometryShaderT)
     {
-        AllocateGsBuffers(pDC, state, &pGsOut, &pCutBuffer);
+        AllocateGsBuffers(pDC, workerId, state, &pGsOut, &pCutBuffer);
     }
 
     if (HasTessellationT)
@@ -1031,7 +1269,17 @@ void ProcessDraw(
     uint32_t* pSoPrimData = nullptr;
     if (HasStreamOutT)
     {
-        pSoPrimData = (uint32_t*)pDC->arena.AllocAligned(4096, 16);
+        pSoPrimData = (uint32_t*)GetFeArena(pDC, workerId).AllocAligned(4096, 16);
+    }
+
+    // indexed draws without GS or tessellation shade each index of a window once
+    bool useVertexCache = false;
+    uint64_t vertexCacheSlotMask = 0;
+    if (IsIndexedT && !HasTessellationT && !HasGeometryShaderT && KNOB_VERTEX_CACHE)
+    {
+        AllocateVertexCache();
+        useVertexCache = true;
+        vertexCacheSlotMask = GetVertexCacheSlotMask(state);
     }
 
     // choose primitive assembler
@@ -1057,6 +1305,11 @@ void ProcessDraw(
         fetchInfo.CurInstance = instanceNum;
         vsContext.InstanceID = instanceNum;
 
+        if (useVertexCache)
+        {
+            gt_pVertexCacheThreadData->Reset();
+        }
+
         while (pa.HasWork())
         {
             // PaGetNextVsOutput currently has the side effect of updating some PA state machine state.
@@ -1070,7 +1323,20 @@ void ProcessDraw(
             simdvertex& vout = pa.GetNextVsOutput();
             vsContext.pVout = &vout;
 
-            if (i < endVertex)
+            if (useVertexCache && i < endVertex)
+            {
+                // 1. Gather a SIMD of shaded vertices from the vertex cache, shading the next window if needed.
+                VertexCacheThreadLocalData* pCache = gt_pVertexCacheThreadData;
+                if ((uint32_t)i >= pCache->windowEnd)
+                {
+                    pCache->ResolveWindow(pContext, pDC, workerId, work, fetchInfo, vsContext, indexSize,
+                        vertexCacheSlotMask, i, endVertex);
+                }
+                pCache->Gather(i, vertexCacheSlotMask, vout, *pvCutIndices);
+
+                UPDATE_STAT(IaVertices, GetNumInvocations(i, endVertex));
+            }
+            else if (i < endVertex)
             {
 
                 // 1. Execute FS/VS for a single SIMD.
@@ -1168,8 +1434,12 @@ void ProcessDraw(
         pa.Reset();
     }
 
-    _ReadWriteBarrier();
-    pDC->doneFE = true;
+    // chunked draws are done once all chunks have been merged
+    if (pDC->numFeChunks == 0)
+    {
+        _ReadWriteBarrier();
+        pDC->doneFE = true;
+    }
     RDTSC_STOP(FEProcessDraw, numPrims * work.numInstances, pDC->drawId);
 }
 // Explicit Instantiation of all combinations
@@ -1206,6 +1476,109 @@ template void ProcessDraw<true,  true,  true,  false, true >(SWR_CONTEXT *pConte
 template void ProcessDraw<true,  true,  true,  true,  false>(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint32_t workerId, void *pUserData);
 template void ProcessDraw<true,  true,  true,  true,  true >(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint32_t workerId, void *pUserData);
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Queues the bins of completed chunks to the macrotiles, in chunk
+///        order. Only one worker merges at a time; a worker that finds the
+///        merge lock taken leaves its chunk to the lock holder, which checks
+///        for newly completed chunks after releasing the lock.
+/// @param pDC - pointer to draw context.
+static void MergeFeChunks(DRAW_CONTEXT *pDC)
+{
+    while (true)
+    {
+        if (InterlockedCompareExchange(&pDC->feMergeLock, 1, 0) != 0)
+        {
+            return;
+        }
+
+        uint32_t chunk = pDC->nextFeChunkToMerge;
+        while (chunk < pDC->numFeChunks && pDC->pFeChunks[chunk].done)
+        {
+            for (FE_BIN_BLOCK* pBlock = pDC->pFeChunks[chunk].pFirstBlock; pBlock != nullptr; pBlock = pBlock->pNext)
+            {
+                for (uint32_t e = 0; e < pBlock->numEntries; ++e)
+                {
+                    FE_BIN_ENTRY& entry = pBlock->entries[e];
+                    pDC->pTileMgr->enqueue(entry.x, entry.y, &entry.work);
+                }
+            }
+            chunk++;
+        }
+        pDC->nextFeChunkToMerge = chunk;
+
+        if (chunk == pDC->numFeChunks)
+        {
+            _ReadWriteBarrier();
+            pDC->doneFE = true;
+        }
+
+        _mm_mfence();
+        pDC->feMergeLock = 0;
+        _mm_mfence();
+
+        // a chunk finishing while we held the lock couldn't merge itself
+        if (chunk == pDC->numFeChunks || !pDC->pFeChunks[chunk].done)
+        {
+            return;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief FE for chunked draws. Claims chunks of the draw until none are
+///        left and runs the draw's FE on each.
+/// @param pContext - pointer to SWR context.
+/// @param pDC - pointer to draw context.
+/// @param workerId - thread's worker id.
+void ProcessDrawChunks(
+    SWR_CONTEXT *pContext,
+    DRAW_CONTEXT *pDC,
+    uint32_t workerId)
+{
+    const DRAW_WORK& drawWork = pDC->FeWork.desc.draw;
+    FE_CHUNK_WORKER& chunkWorker = pDC->pFeChunkWorkers[workerId];
+
+    while (true)
+    {
+        uint32_t chunk = (uint32_t)InterlockedExchangeAdd(&pDC->nextFeChunk, 1);
+        if (chunk >= pDC->numFeChunks)
+        {
+            return;
+        }
+
+        if (chunk == pDC->numFeChunks - 1)
+        {
+            // all chunks claimed, other workers can skip this draw
+            pDC->FeLock = 1;
+        }
+
+        uint32_t firstVert = chunk * pDC->feChunkVerts;
+
+        DRAW_WORK work = drawWork;
+        work.numVerts = std::min(pDC->feChunkVerts, drawWork.numVerts - firstVert);
+        work.startPrimID = drawWork.startPrimID + chunk * pDC->feChunkPrims;
+        if (pDC->feChunkIndexSize)
+        {
+            work.pIB = (const int32_t*)((const uint8_t*)drawWork.pIB + (uint64_t)firstVert * pDC->feChunkIndexSize);
+        }
+        else
+        {
+            work.startVertex = drawWork.startVertex + firstVert;
+        }
+
+        chunkWorker.pChunk = &pDC->pFeChunks[chunk];
+        chunkWorker.used = true;
+
+        pDC->FeWork.pfnWork(pContext, pDC, workerId, &work);
+
+        _ReadWriteBarrier();
+        pDC->pFeChunks[chunk].done = true;
+        _mm_mfence();
+
+        MergeFeChunks(pDC);
+    }
+}
+
 
 //////////////////////////////////////////////////////////////////////////
 /// @brief Expland points to give them area.
@@ -1323,6 +1696,48 @@ void ProcessUserClipDist(PA_STATE& pa, uint32_t primIndex, uint8_t clipDistMask,
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Queues BE work to a macrotile. Chunked draws record the work in
+///        the chunk's bin list instead, see MergeFeChunks.
+/// @param pDC - pointer to draw context.
+/// @param workerId - thread's worker id.
+/// @param x, y - macrotile
+/// @param pWork - work to queue, copied
+static INLINE void BinWork(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t x, uint32_t y, BE_WORK *pWork)
+{
+    if (pDC->numFeChunks == 0)
+    {
+        pDC->pTileMgr->enqueue(x, y, pWork);
+        return;
+    }
+
+    FE_CHUNK_WORKER& chunkWorker = pDC->pFeChunkWorkers[workerId];
+    FE_CHUNK* pChunk = chunkWorker.pChunk;
+
+    FE_BIN_BLOCK* pBlock = pChunk->pLastBlock;
+    if (pBlock == nullptr || pBlock->numEntries == FE_BIN_BLOCK::NumEntries)
+    {
+        FE_BIN_BLOCK* pNewBlock = (FE_BIN_BLOCK*)chunkWorker.arena.AllocAligned(sizeof(FE_BIN_BLOCK), 16);
+        pNewBlock->pNext = nullptr;
+        pNewBlock->numEntries = 0;
+
+        if (pBlock)
+        {
+            pBlock->pNext = pNewBlock;
+        }
+        else
+        {
+            pChunk->pFirstBlock = pNewBlock;
+        }
+        pChunk->pLastBlock = pBlock = pNewBlock;
+    }
+
+    FE_BIN_ENTRY& entry = pBlock->entries[pBlock->numEntries++];
+    entry.x = x;
+    entry.y = y;
+    entry.work = *pWork;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Bin triangle primitives to macro tiles. Performs setup, clipping
 ///        culling, viewport transform, etc.
@@ -1576,13 +1991,13 @@ void BinTriangles(
         work.pfnWork = gRasterizerTable[rastState.sampleCount];
 
         // store active attribs
-        float *pAttribs = (float*)pDC->arena.AllocAligned(numScalarAttribs*3*sizeof(float), 16);
+        float *pAttribs = (float*)GetFeArena(pDC, workerId).AllocAligned(numScalarAttribs*3*sizeof(float), 16);
         desc.pAttribs = pAttribs;
         desc.numAttribs = linkageCount;
         ProcessAttributes<3>(pDC, pa, linkageMask, state.linkageMap, triIndex, desc.pAttribs);
 
         // store triangle vertex data
-        desc.pTriBuffer = (float*)pDC->arena.AllocAligned(4*4*sizeof(float), 16);
+        desc.pTriBuffer = (float*)GetFeArena(pDC, workerId).AllocAligned(4*4*sizeof(float), 16);
 
         _mm_store_ps(&desc.pTriBuffer[0], vHorizX[triIndex]);
         _mm_store_ps(&desc.pTriBuffer[4], vHorizY[triIndex]);
@@ -1593,11 +2008,10 @@ void BinTriangles(
         if (rastState.clipDistanceMask)
         {
             uint32_t numClipDist = _mm_popcnt_u32(rastState.clipDistanceMask);
-            desc.pUserClipBuffer = (float*)pDC->arena.Alloc(numClipDist * 3 * sizeof(float));
+            desc.pUserClipBuffer = (float*)GetFeArena(pDC, workerId).Alloc(numClipDist * 3 * sizeof(float));
             ProcessUserClipDist<3>(pa, triIndex, rastState.clipDistanceMask, desc.pUserClipBuffer);
         }
 
-        MacroTileMgr *pTileMgr = pDC->pTileMgr;
         for (uint32_t y = aMTTop[triIndex]; y <= aMTBottom[triIndex]; ++y)
         {
             for (uint32_t x = aMTLeft[triIndex]; x <= aMTRight[triIndex]; ++x)
@@ -1606,7 +2020,7 @@ void BinTriangles(
                 if (!KNOB_TOSS_SETUP_TRIS)
 #endif
                 {
-                    pTileMgr->enqueue(x, y, &work);
+                    BinWork(pDC, workerId, x, y, &work);
                 }
             }
         }
@@ -1733,14 +2147,14 @@ void BinPoints(
         work.pfnWork = rastPoint;
 
         // store attributes
-        float *pAttribs = (float*)pDC->arena.AllocAligned(3 * numScalarAttribs * sizeof(float), 16);
+        float *pAttribs = (float*)GetFeArena(pDC, workerId).AllocAligned(3 * numScalarAttribs * sizeof(float), 16);
         desc.pAttribs = pAttribs;
         desc.numAttribs = linkageCount;
 
         ProcessAttributes<1>(pDC, pa, linkageMask, state.linkageMap, primIndex, pAttribs);
 
         // store raster tile aligned x, y, perspective correct z
-        float *pTriBuffer = (float*)pDC->arena.AllocAligned(4 * sizeof(float), 16);
+        float *pTriBuffer = (float*)GetFeArena(pDC, workerId).AllocAligned(4 * sizeof(float), 16);
         desc.pTriBuffer = pTriBuffer;
         *(uint32_t*)pTriBuffer++ = aTileAlignedX[primIndex];
         *(uint32_t*)pTriBuffer++ = aTileAlignedY[primIndex];
@@ -1754,12 +2168,11 @@ void BinPoints(
         work.desc.tri.triFlags.coverageMask = tX | (tY << 4);
 
         // bin it
-        MacroTileMgr *pTileMgr = pDC->pTileMgr;
 #if KNOB_ENABLE_TOSS_POINTS
         if (!KNOB_TOSS_SETUP_TRIS)
 #endif
         {
-            pTileMgr->enqueue(aMacroX[primIndex], aMacroY[primIndex], &work);
+            BinWork(pDC, workerId, aMacroX[primIndex], aMacroY[primIndex], &work);
         }
         primMask &= ~(1 << primIndex);
     }
@@ -1930,12 +2343,12 @@ void BinLines(
         work.pfnWork = RasterizeLine;
 
         // store active attribs
-        desc.pAttribs = (float*)pDC->arena.AllocAligned(numScalarAttribs * 3 * sizeof(float), 16);
+        desc.pAttribs = (float*)GetFeArena(pDC, workerId).AllocAligned(numScalarAttribs * 3 * sizeof(float), 16);
         desc.numAttribs = linkageCount;
         ProcessAttributes<2>(pDC, pa, linkageMask, state.linkageMap, primIndex, desc.pAttribs);
 
         // store line vertex data
-        desc.pTriBuffer = (float*)pDC->arena.AllocAligned(4 * 4 * sizeof(float), 16);
+        desc.pTriBuffer = (float*)GetFeArena(pDC, workerId).AllocAligned(4 * 4 * sizeof(float), 16);
         _mm_store_ps(&desc.pTriBuffer[0], vHorizX[primIndex]);
         _mm_store_ps(&desc.pTriBuffer[4], vHorizY[primIndex]);
         _mm_store_ps(&desc.pTriBuffer[8], vHorizZ[primIndex]);
@@ -1945,11 +2358,10 @@ void BinLines(
         if (rastState.clipDistanceMask)
         {
             uint32_t numClipDist = _mm_popcnt_u32(rastState.clipDistanceMask);
-            desc.pUserClipBuffer = (float*)pDC->arena.Alloc(numClipDist * 2 * sizeof(float));
+            desc.pUserClipBuffer = (float*)GetFeArena(pDC, workerId).Alloc(numClipDist * 2 * sizeof(float));
             ProcessUserClipDist<2>(pa, primIndex, rastState.clipDistanceMask, desc.pUserClipBuffer);
         }
 
-        MacroTileMgr *pTileMgr = pDC->pTileMgr;
         for (uint32_t y = aMTTop[primIndex]; y <= aMTBottom[primIndex]; ++y)
         {
             for (uint32_t x = aMTLeft[primIndex]; x <= aMTRight[primIndex]; ++x)
@@ -1958,7 +2370,7 @@ void BinLines(
                 if (!KNOB_TOSS_SETUP_TRIS)
 #endif
                 {
-                    pTileMgr->enqueue(x, y, &work);
+                    BinWork(pDC, workerId, x, y, &work);
                 }
             }
         }
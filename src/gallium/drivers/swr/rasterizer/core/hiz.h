@@ -0,0 +1,189 @@
+/****************************************************************************
+* Copyright (C) 2014-2015 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file hiz.h
+*
+* @brief Hierarchical Z: per raster tile depth bounds of the depth hot tile
+*        and the tests the rasterizer runs against them.
+*
+******************************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "context.h"
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Screen space depth plane of a primitive, used to bound the depth it
+///        can produce over a raster tile for the hierarchical Z test.
+struct HIZ_PLANE
+{
+    float zA, zB, zC;       // z = zA * x + zB * y + zC, x and y in pixels
+    float epsilon;          // slack for the rounding of the backend's barycentric interpolation
+    float vpMinZ, vpMaxZ;   // depth test clamps interpolated z to the viewport depth range
+    bool valid;
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @param xMax, yMax - largest pixel coordinates the backend evaluates the plane at
+    HIZ_PLANE(const SWR_TRIANGLE_DESC &triDesc, const SWR_VIEWPORT &vp, float xMax, float yMax)
+    {
+        // the backend evaluates z = Z0 * i + Z1 * j + Z2 with i, j = (I|J plane)(x, y) * recipDet
+        zA = (triDesc.Z[0] * triDesc.I[0] + triDesc.Z[1] * triDesc.J[0]) * triDesc.recipDet;
+        zB = (triDesc.Z[0] * triDesc.I[1] + triDesc.Z[1] * triDesc.J[1]) * triDesc.recipDet;
+        zC = (triDesc.Z[0] * triDesc.I[2] + triDesc.Z[1] * triDesc.J[2]) * triDesc.recipDet + triDesc.Z[2];
+
+        float errI = fabsf(triDesc.I[0]) * xMax + fabsf(triDesc.I[1]) * yMax + fabsf(triDesc.I[2]);
+        float errJ = fabsf(triDesc.J[0]) * xMax + fabsf(triDesc.J[1]) * yMax + fabsf(triDesc.J[2]);
+        epsilon = ((fabsf(triDesc.Z[0]) * errI + fabsf(triDesc.Z[1]) * errJ) * fabsf(triDesc.recipDet) + fabsf(triDesc.Z[2])) *
+            (16.0f * FLT_EPSILON);
+
+        vpMinZ = vp.minZ;
+        vpMaxZ = vp.maxZ;
+        valid = std::isfinite(zA) && std::isfinite(zB) && std::isfinite(zC) && std::isfinite(epsilon);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Conservative depth range of the plane over the raster tile at x, y
+    /// @param x, y - upper left corner of the raster tile in pixels
+    INLINE void TileRange(uint32_t x, uint32_t y, float &zMin, float &zMax) const
+    {
+        if (!valid)
+        {
+            zMin = std::min(vpMinZ, vpMaxZ);
+            zMax = std::max(vpMinZ, vpMaxZ);
+            return;
+        }
+
+        float zUL = zA * x + zB * y + zC;
+        float dX = zA * KNOB_TILE_X_DIM;
+        float dY = zB * KNOB_TILE_Y_DIM;
+        zMin = zUL + std::min(dX, 0.0f) + std::min(dY, 0.0f) - epsilon;
+        zMax = zUL + std::max(dX, 0.0f) + std::max(dY, 0.0f) + epsilon;
+
+        zMin = std::min(vpMaxZ, std::max(vpMinZ, zMin));
+        zMax = std::min(vpMaxZ, std::max(vpMinZ, zMax));
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if the depth state allows raster tiles to be rejected
+///        against their depth bounds: an ordered depth test, no stencil ops
+///        that could react to a depth failure and interpolated z.
+INLINE bool CanHiZReject(const API_STATE &state)
+{
+    const SWR_DEPTH_STENCIL_STATE &dsState = state.depthStencilState;
+
+    if (!KNOB_HIZ || !dsState.depthTestEnable || dsState.stencilTestEnable || dsState.stencilWriteEnable ||
+        state.psState.writesODepth)
+    {
+        return false;
+    }
+
+    switch (dsState.depthTestFunc)
+    {
+    case ZFUNC_LT:
+    case ZFUNC_LE:
+    case ZFUNC_GT:
+    case ZFUNC_GE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if no sample of a raster tile with depth bounds hiZ
+///        can pass the depth test for depth in [zMin, zMax].
+INLINE bool HiZReject(uint32_t depthTestFunc, const HIZ_TILE &hiZ, float zMin, float zMax)
+{
+    switch (depthTestFunc)
+    {
+    case ZFUNC_LT: return zMin >= hiZ.zMax;
+    case ZFUNC_LE: return zMin > hiZ.zMax;
+    case ZFUNC_GT: return zMax <= hiZ.zMin;
+    case ZFUNC_GE: return zMax < hiZ.zMin;
+    default: return false;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Grows the depth bounds of a raster tile to cover depth writes in
+///        [zMin, zMax].
+INLINE void HiZUpdate(HIZ_TILE &hiZ, float zMin, float zMax)
+{
+    hiZ.zMin = std::min(hiZ.zMin, zMin);
+    hiZ.zMax = std::max(hiZ.zMax, zMax);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Updates the depth bounds of a raster tile after the backend ran on it
+///        for the primitive with depth plane zPlane.
+/// @param fullyCovered - every sample of the raster tile was covered
+INLINE void HiZUpdateTile(const API_STATE &state, const HIZ_PLANE &zPlane, HIZ_TILE &hiZ, uint32_t x, uint32_t y,
+    bool fullyCovered)
+{
+    const SWR_DEPTH_STENCIL_STATE &dsState = state.depthStencilState;
+
+    float zMin, zMax;
+    if (state.psState.writesODepth)
+    {
+        // shader depth is only known to be clamped to the viewport depth range
+        zMin = std::min(zPlane.vpMinZ, zPlane.vpMaxZ);
+        zMax = std::max(zPlane.vpMinZ, zPlane.vpMaxZ);
+        HiZUpdate(hiZ, zMin, zMax);
+        return;
+    }
+
+    zPlane.TileRange(x, y, zMin, zMax);
+
+    // if anything besides the depth test could have kept a sample from being written, the
+    // old depth of that sample may be anywhere in the old bounds
+    if (!fullyCovered || !zPlane.valid || state.psState.killsPixel || dsState.stencilTestEnable)
+    {
+        HiZUpdate(hiZ, zMin, zMax);
+        return;
+    }
+
+    // every sample now holds whichever of its old depth and the primitive's won the test
+    switch (dsState.depthTestEnable ? (uint32_t)dsState.depthTestFunc : (uint32_t)ZFUNC_ALWAYS)
+    {
+    case ZFUNC_ALWAYS:
+        hiZ.zMin = zMin;
+        hiZ.zMax = zMax;
+        break;
+    case ZFUNC_LT:
+    case ZFUNC_LE:
+        hiZ.zMin = std::min(hiZ.zMin, zMin);
+        hiZ.zMax = std::min(hiZ.zMax, zMax);
+        break;
+    case ZFUNC_GT:
+    case ZFUNC_GE:
+        hiZ.zMin = std::max(hiZ.zMin, zMin);
+        hiZ.zMax = std::max(hiZ.zMax, zMax);
+        break;
+    default:
+        HiZUpdate(hiZ, zMin, zMax);
+        break;
+    }
+}
@@ -65,6 +65,12 @@
 ///////////////////////////////////////////////////////////////////////////////
 #define KNOB_MAX_NUM_THREADS                256 // Supports up to dual-HSW-Xeon.
 
+// Maximum number of contexts sharing the process-wide worker thread pool
+#define KNOB_MAX_NUM_CONTEXTS               64
+
+// Maximum number of NUMA nodes a context partitions its macrotiles across
+#define KNOB_MAX_NUMA_NODES_PER_CONTEXT     8
+
 // Maximum supported number of active vertex buffer streams
 #define KNOB_NUM_STREAMS                    32
 
@@ -104,6 +110,8 @@
 #define KNOB_NUM_HOT_TILES_X                 256
 #define KNOB_NUM_HOT_TILES_Y                 256
 #define KNOB_COLOR_HOT_TILE_FORMAT           R32G32B32A32_FLOAT
+#define KNOB_COLOR_HOT_TILE_FORMAT_UNORM8    R8G8B8A8_UNORM
+#define KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16   R16G16B16A16_FLOAT
 #define KNOB_DEPTH_HOT_TILE_FORMAT           R32_FLOAT
 #define KNOB_STENCIL_HOT_TILE_FORMAT         R8_UINT
 
@@ -36,13 +36,14 @@
 #include "utils.h"
 #include "frontend.h"
 #include "tilemgr.h"
+#include "hiz.h"
 #include "memory/tilingtraits.h"
 
 void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t x, uint32_t y, RenderOutputBuffers &renderBuffers, 
     uint32_t numSamples, uint32_t renderTargetArrayIndex);
-void StepRasterTileX(uint32_t MaxRT, RenderOutputBuffers &buffers, uint32_t colorTileStep, uint32_t depthTileStep, uint32_t stencilTileStep);
+void StepRasterTileX(uint32_t MaxRT, RenderOutputBuffers &buffers, const uint32_t colorTileStep[], uint32_t depthTileStep, uint32_t stencilTileStep);
 void StepRasterTileY(uint32_t MaxRT, RenderOutputBuffers &buffers, RenderOutputBuffers &startBufferRow, 
-                     uint32_t colorRowStep, uint32_t depthRowStep, uint32_t stencilRowStep);
+                     const uint32_t colorRowStep[], uint32_t depthRowStep, uint32_t stencilRowStep);
 
 #define MASKTOVEC(i3,i2,i1,i0) {-i0,-i1,-i2,-i3}
 const __m128 gMaskToVec[] = {
@@ -586,7 +587,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     if (numTilesX == 0 || numTilesY == 0) 
     {
         RDTSC_EVENT(BEEmptyTriangle, 1, 0);
-        RDTSC_STOP(BERasterizeTriangle, 1, 0);
+        RDTSC_STOP(BERasterizeTriangle, 1, pDC->drawId);
         return;
     }
 
@@ -713,8 +714,14 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
     triDesc.pSamplePos = pDC->pState->state.samplePos;
 
     // compute steps between raster tiles for render output buffers
-    static const uint32_t colorRasterTileStep{(KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8)) * MultisampleTraits<sampleCount>::numSamples};
-    static const uint32_t colorRasterTileRowStep{(KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM) * colorRasterTileStep};
+    // color hot tile format is per render target
+    uint32_t colorRasterTileStep[SWR_NUM_RENDERTARGETS];
+    uint32_t colorRasterTileRowStep[SWR_NUM_RENDERTARGETS];
+    for (uint32_t rt = 0; rt <= state.psState.maxRTSlotUsed; ++rt)
+    {
+        colorRasterTileStep[rt] = (KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * GetFormatInfo(state.backendState.colorHotTileFormat[rt]).Bpp) * MultisampleTraits<sampleCount>::numSamples;
+        colorRasterTileRowStep[rt] = (KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM) * colorRasterTileStep[rt];
+    }
     static const uint32_t depthRasterTileStep{(KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_DEPTH_HOT_TILE_FORMAT>::bpp / 8)) * MultisampleTraits<sampleCount>::numSamples};
     static const uint32_t depthRasterTileRowStep{(KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM)* depthRasterTileStep};
     static const uint32_t stencilRasterTileStep{(KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * (FormatTraits<KNOB_STENCIL_HOT_TILE_FORMAT>::bpp / 8)) * MultisampleTraits<sampleCount>::numSamples};
@@ -725,6 +732,13 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
         triDesc.triFlags.renderTargetArrayIndex);
     currentRenderBufferRow = renderBuffers;
 
+    // hierarchical Z: reject raster tiles the triangle can't pass the depth test in and keep
+    // the depth bounds of the tiles it writes conservative
+    const HIZ_PLANE zPlane(triDesc, state.vp[0], (float)((intersect.right >> FIXED_POINT_SHIFT) + 1),
+        (float)((intersect.bottom >> FIXED_POINT_SHIFT) + 1));
+    const bool hiZTest = CanHiZReject(state);
+    const bool hiZUpdate = KNOB_HIZ && state.depthStencilState.depthWriteEnable;
+
     // rasterize and generate coverage masks per sample
     uint32_t maxSamples = MultisampleTraits<sampleCount>::numSamples;
     for (uint32_t tileY = tY; tileY <= maxY; ++tileY)
@@ -736,6 +750,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
         for (uint32_t tileX = tX; tileX <= maxX; ++tileX)
         {
             uint64_t anyCoveredSamples = 0;
+            bool allSamplesCovered = true;
 
             // is the corner of the edge outside of the raster tile? (vEdge < 0)
             int mask0, mask1, mask2;
@@ -776,6 +791,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
                     }
                     else
                     {
+                        allSamplesCovered = false;
                         __m256d vEdge0AtSample, vEdge1AtSample, vEdge2AtSample; 
                         if(sampleCount == SWR_MULTISAMPLE_1X)
                         {
@@ -822,6 +838,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
                 }
                 else
                 {
+                    allSamplesCovered = false;
                     if(sampleCount > SWR_MULTISAMPLE_1X)
                     {
                         triDesc.coverageMask[sampleNum] = 0;
@@ -839,9 +856,31 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
 #endif
             if(anyCoveredSamples)
             {
-                RDTSC_START(BEPixelBackend);
-                pDC->pState->pfnBackend(pDC, workerId, tileX << KNOB_TILE_X_DIM_SHIFT, tileY << KNOB_TILE_Y_DIM_SHIFT, triDesc, renderBuffers);
-                RDTSC_STOP(BEPixelBackend, 0, 0);
+                uint32_t x = tileX << KNOB_TILE_X_DIM_SHIFT;
+                uint32_t y = tileY << KNOB_TILE_Y_DIM_SHIFT;
+                bool hiZRejected = false;
+                if (hiZTest)
+                {
+                    float zMin, zMax;
+                    zPlane.TileRange(x, y, zMin, zMax);
+                    hiZRejected = HiZReject(state.depthStencilState.depthTestFunc, *renderBuffers.pHiZ, zMin, zMax);
+                }
+
+                if (hiZRejected)
+                {
+                    RDTSC_EVENT(BEHiZReject, 1, 0);
+                }
+                else
+                {
+                    RDTSC_START(BEPixelBackend);
+                    pDC->pState->pfnBackend(pDC, workerId, x, y, triDesc, renderBuffers);
+                    RDTSC_STOP(BEPixelBackend, 0, 0);
+
+                    if (hiZUpdate)
+                    {
+                        HiZUpdateTile(state, zPlane, *renderBuffers.pHiZ, x, y, allSamplesCovered);
+                    }
+                }
             }
 
             // step to the next tile in X
@@ -860,7 +899,7 @@ void RasterizeTriangle(DRAW_CONTEXT* pDC, uint32_t workerId, uint32_t macroTile,
         StepRasterTileY(state.psState.maxRTSlotUsed, renderBuffers, currentRenderBufferRow, colorRasterTileRowStep, depthRasterTileRowStep, stencilRasterTileRowStep);
     }
 
-    RDTSC_STOP(BERasterizeTriangle, 1, 0);
+    RDTSC_STOP(BERasterizeTriangle, 1, pDC->drawId);
 }
 
 void RasterizePoint(DRAW_CONTEXT *pDC, uint32_t workerId, const TRIANGLE_WORK_DESC &workDesc, uint32_t macroTile)
@@ -917,9 +956,27 @@ void RasterizePoint(DRAW_CONTEXT *pDC, uint32_t workerId, const TRIANGLE_WORK_DE
     GetRenderHotTiles(pDC, macroTile, tileAlignedX >> KNOB_TILE_X_DIM_SHIFT , tileAlignedY >> KNOB_TILE_Y_DIM_SHIFT, 
         renderBuffers, 1, triDesc.triFlags.renderTargetArrayIndex);
 
+    const API_STATE &state = GetApiState(pDC);
+    const HIZ_PLANE zPlane(triDesc, state.vp[0], (float)(tileAlignedX + KNOB_TILE_X_DIM), (float)(tileAlignedY + KNOB_TILE_Y_DIM));
+    if (CanHiZReject(state))
+    {
+        float zMin, zMax;
+        zPlane.TileRange(tileAlignedX, tileAlignedY, zMin, zMax);
+        if (HiZReject(state.depthStencilState.depthTestFunc, *renderBuffers.pHiZ, zMin, zMax))
+        {
+            RDTSC_EVENT(BEHiZReject, 1, 0);
+            return;
+        }
+    }
+
     RDTSC_START(BEPixelBackend);
     pDC->pState->pfnBackend(pDC, workerId, tileAlignedX, tileAlignedY, triDesc, renderBuffers);
     RDTSC_STOP(BEPixelBackend, 0, 0);
+
+    if (KNOB_HIZ && state.depthStencilState.depthWriteEnable)
+    {
+        HiZUpdateTile(state, zPlane, *renderBuffers.pHiZ, tileAlignedX, tileAlignedY, false);
+    }
 }
 
 void rastPoint(DRAW_CONTEXT *pDC, uint32_t workerId, uint32_t macroTile, void *pData)
@@ -937,6 +994,8 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
     const SWR_DEPTH_STENCIL_STATE *pDSState = &state.depthStencilState;
     const uint32_t MaxRT = state.psState.maxRTSlotUsed;
 
+    renderBuffers.pHiZ = nullptr;
+
     uint32_t mx, my;
     MacroTileMgr::getTileIndices(macroID, mx, my);
     tileX -= KNOB_MACROTILE_X_DIM_IN_TILES * mx;
@@ -944,15 +1003,15 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
 
     if(state.psState.pfnPixelShader != NULL)
     {
-        // compute tile offset for active hottile buffers
-        const uint32_t pitch = KNOB_MACROTILE_X_DIM * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8;
-        uint32_t offset = ComputeTileOffset2D<TilingTraits<SWR_TILE_SWRZ, FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp> >(pitch, tileX, tileY);
-        offset*=numSamples;
+        // compute tile offset for active hottile buffers, color hot tile format is per render target
+        uint32_t tileID = tileY * KNOB_MACROTILE_X_DIM_IN_TILES + tileX;
         for(uint32_t rt = 0; rt <= MaxRT; ++rt)
         {
             HOTTILE *pColor = pContext->pHotTileMgr->GetHotTile(pContext, pDC, macroID, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rt), true, 
                 numSamples, renderTargetArrayIndex);
             pColor->state = HOTTILE_DIRTY;
+            uint32_t offset = tileID * KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * GetFormatInfo(pColor->format).Bpp;
+            offset*=numSamples;
             renderBuffers.pColor[rt] = pColor->pBuffer + offset;
         }
     }
@@ -966,6 +1025,7 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
         pDepth->state = HOTTILE_DIRTY;
         SWR_ASSERT(pDepth->pBuffer != nullptr);
         renderBuffers.pDepth = pDepth->pBuffer + offset;
+        renderBuffers.pHiZ = pDepth->pHiZ + tileY * KNOB_MACROTILE_X_DIM_IN_TILES + tileX;
     }
     if(pDSState->stencilTestEnable)
     {
@@ -981,23 +1041,24 @@ void GetRenderHotTiles(DRAW_CONTEXT *pDC, uint32_t macroID, uint32_t tileX, uint
 }
 
 INLINE
-void StepRasterTileX(uint32_t MaxRT, RenderOutputBuffers &buffers, uint32_t colorTileStep, uint32_t depthTileStep, uint32_t stencilTileStep)
+void StepRasterTileX(uint32_t MaxRT, RenderOutputBuffers &buffers, const uint32_t colorTileStep[], uint32_t depthTileStep, uint32_t stencilTileStep)
 {
     for(uint32_t rt = 0; rt <= MaxRT; ++rt)
     {
-        buffers.pColor[rt] += colorTileStep;
+        buffers.pColor[rt] += colorTileStep[rt];
     }
     
     buffers.pDepth += depthTileStep;
     buffers.pStencil += stencilTileStep;
+    buffers.pHiZ += (buffers.pHiZ != nullptr) ? 1 : 0;
 }
 
 INLINE
-void StepRasterTileY(uint32_t MaxRT, RenderOutputBuffers &buffers, RenderOutputBuffers &startBufferRow, uint32_t colorRowStep, uint32_t depthRowStep, uint32_t stencilRowStep)
+void StepRasterTileY(uint32_t MaxRT, RenderOutputBuffers &buffers, RenderOutputBuffers &startBufferRow, const uint32_t colorRowStep[], uint32_t depthRowStep, uint32_t stencilRowStep)
 {
     for(uint32_t rt = 0; rt <= MaxRT; ++rt)
     {
-        startBufferRow.pColor[rt] += colorRowStep;
+        startBufferRow.pColor[rt] += colorRowStep[rt];
         buffers.pColor[rt] = startBufferRow.pColor[rt];
     }
     startBufferRow.pDepth += depthRowStep;
@@ -1005,6 +1066,9 @@ void StepRasterTileY(uint32_t MaxRT, RenderOutputBuffers &buffers, RenderOutputB
 
     startBufferRow.pStencil += stencilRowStep;
     buffers.pStencil = startBufferRow.pStencil;
+
+    startBufferRow.pHiZ += (startBufferRow.pHiZ != nullptr) ? KNOB_MACROTILE_X_DIM_IN_TILES : 0;
+    buffers.pHiZ = startBufferRow.pHiZ;
 }
 
 // initialize rasterizer function table
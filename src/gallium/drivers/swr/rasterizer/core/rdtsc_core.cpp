@@ -70,6 +70,7 @@ BUCKET_DESC gCoreBuckets[] = {
     { "BEEmptyTriangle", "", false, 0xffffffff },
     { "BETrivialAccept", "", false, 0xffffffff },
     { "BETrivialReject", "", false, 0xffffffff },
+    { "BEHiZReject", "", false, 0xffffffff },
     { "BERasterizePartial", "", false, 0xffffffff },
     { "BEPixelBackend", "", false, 0xffffffff },
     { "BESetup", "", false, 0xffffffff },
@@ -88,3 +89,6 @@ std::vector<uint32_t> gBucketMap;
 BucketManager gBucketMgr(false);
 
 uint32_t gCurrentFrame = 0;
+
+TraceManager gTraceMgr;
+uint32_t gCurrentTraceFrame = 0;
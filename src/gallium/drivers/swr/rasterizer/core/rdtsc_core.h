@@ -26,6 +26,7 @@
 
 #include "common/os.h"
 #include "common/rdtsc_buckets.h"
+#include "common/rdtsc_trace.h"
 
 #include <vector>
 
@@ -75,6 +76,7 @@ enum CORE_BUCKETS
     BEEmptyTriangle,
     BETrivialAccept,
     BETrivialReject,
+    BEHiZReject,
     BERasterizePartial,
     BEPixelBackend,
     BESetup,
@@ -97,6 +99,11 @@ void rdtscStop(uint32_t bucketId, uint32_t count, uint64_t drawId);
 void rdtscEvent(uint32_t bucketId, uint32_t count1, uint32_t count2);
 void rdtscEndFrame();
 
+void traceInit(int threadId);
+void traceStart(uint32_t bucketId);
+void traceStop(uint32_t bucketId, uint64_t drawId);
+void traceEndFrame();
+
 #ifdef KNOB_ENABLE_RDTSC
 #define RDTSC_RESET() rdtscReset()
 #define RDTSC_INIT(threadId) rdtscInit(threadId)
@@ -105,18 +112,63 @@ void rdtscEndFrame();
 #define RDTSC_EVENT(bucket, count1, count2) rdtscEvent(bucket, count1, count2)
 #define RDTSC_ENDFRAME() rdtscEndFrame()
 #else
+// Buckets are only traced, see KNOB_TRACE_FILE
 #define RDTSC_RESET()
-#define RDTSC_INIT(threadId)
-#define RDTSC_START(bucket)
-#define RDTSC_STOP(bucket, count, draw)
+#define RDTSC_INIT(threadId) traceInit(threadId)
+#define RDTSC_START(bucket) traceStart(bucket)
+#define RDTSC_STOP(bucket, count, draw) traceStop(bucket, draw)
 #define RDTSC_EVENT(bucket, count1, count2)
-#define RDTSC_ENDFRAME()
+#define RDTSC_ENDFRAME() traceEndFrame()
 #endif
 
 extern std::vector<uint32_t> gBucketMap;
 extern BucketManager gBucketMgr;
 extern BUCKET_DESC gCoreBuckets[];
 extern uint32_t gCurrentFrame;
+extern TraceManager gTraceMgr;
+extern uint32_t gCurrentTraceFrame;
+
+INLINE void traceInit(int threadId)
+{
+    gTraceMgr.RegisterThread(threadId == 0 ? "API" : "WORKER");
+}
+
+INLINE void traceStart(uint32_t bucketId)
+{
+    if (gTraceMgr.IsCapturing())
+    {
+        gTraceMgr.BeginSpan(bucketId);
+    }
+}
+
+INLINE void traceStop(uint32_t bucketId, uint64_t drawId)
+{
+    if (gTraceMgr.IsCapturing())
+    {
+        gTraceMgr.EndSpan(bucketId, drawId);
+    }
+}
+
+INLINE void traceEndFrame()
+{
+    if (KNOB_TRACE_FILE.empty())
+    {
+        return;
+    }
+
+    gCurrentTraceFrame++;
+
+    if (gCurrentTraceFrame == KNOB_TRACE_START_FRAME)
+    {
+        gTraceMgr.StartCapture(KNOB_TRACE_EVENTS_PER_THREAD);
+    }
+
+    if (gCurrentTraceFrame == KNOB_TRACE_START_FRAME + KNOB_TRACE_NUM_FRAMES)
+    {
+        gTraceMgr.StopCapture();
+        gTraceMgr.WriteTrace(KNOB_TRACE_FILE, gCoreBuckets, NumBuckets);
+    }
+}
 
 INLINE void rdtscReset()
 {
@@ -139,16 +191,22 @@ INLINE void rdtscInit(int threadId)
 
     std::string name = threadId == 0 ? "API" : "WORKER";
     gBucketMgr.RegisterThread(name);
+
+    traceInit(threadId);
 }
 
 INLINE void rdtscStart(uint32_t bucketId)
 {
     uint32_t id = gBucketMap[bucketId];
     gBucketMgr.StartBucket(id);
+
+    traceStart(bucketId);
 }
 
 INLINE void rdtscStop(uint32_t bucketId, uint32_t count, uint64_t drawId)
 {
+    traceStop(bucketId, drawId);
+
     uint32_t id = gBucketMap[bucketId];
     gBucketMgr.StopBucket(id);
 }
@@ -160,6 +218,8 @@ INLINE void rdtscEvent(uint32_t bucketId, uint32_t count1, uint32_t count2)
 
 INLINE void rdtscEndFrame()
 {
+    traceEndFrame();
+
     gCurrentFrame++;
 
     if (gCurrentFrame == KNOB_BUCKETS_START_FRAME)
@@ -535,6 +535,57 @@ struct SWR_STATS
     uint64_t SoNumPrimsWritten[4];
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// SWR_SCHEDULER_STATS
+///
+/// @brief Backend macrotile scheduler statistics.
+/////////////////////////////////////////////////////////////////////////
+struct SWR_SCHEDULER_STATS
+{
+    uint64_t Steals;            // Macrotiles taken from another worker's deque.
+    uint64_t RemoteSteals;      // Steals from a worker on another NUMA node.
+    uint64_t IdleSpins;         // Times a worker looked for BE work and found none ready.
+    uint64_t TileMigrations;    // Macrotiles worked on by a different worker than last time.
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// SWR_ARENA_CACHE_STATS
+///
+/// @brief Process wide arena block cache statistics.
+/////////////////////////////////////////////////////////////////////////
+struct SWR_ARENA_CACHE_STATS
+{
+    uint64_t BytesCached;       // Bytes currently held in the cache.
+    uint64_t BytesInUse;        // Bytes currently handed out to arenas.
+    uint64_t BlocksAllocated;   // Blocks that had to come from the system allocator.
+    uint64_t BlocksReused;      // Blocks handed out from the cache.
+    uint64_t BlocksTrimmed;     // Blocks freed because the cache was full.
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// SWR_DRIVER_COUNTERS
+///
+/// @brief Always-on counters for driver HUDs. Unlike SWR_STATS these are
+///        sampled without waiting for the pipeline to drain, so the values
+///        include work of draws still in flight.
+/////////////////////////////////////////////////////////////////////////
+struct SWR_DRIVER_COUNTERS
+{
+    uint64_t Timestamp;         // rdtsc when the counters were sampled.
+    uint64_t MacroTiles;        // Macrotiles worked on by the BE.
+    uint64_t HotTileLoads;      // Hot tiles loaded from render targets.
+    uint64_t HotTileStores;     // Hot tiles stored to render targets.
+    uint64_t LayerAllocs;       // Hot tiles added for another array slice of a macrotile.
+    uint64_t LayerReloads;      // Array slices stored and reloaded because all hot tile layers were in use.
+    uint64_t FeTicks;           // rdtsc ticks workers spent in FE work.
+    uint64_t BeTicks;           // rdtsc ticks workers spent in BE and compute work.
+    uint64_t IdleTicks;         // rdtsc ticks pool workers spent without work.
+    uint64_t DrawsInFlight;     // Draws enqueued but not yet retired.
+    uint64_t ArenaBytesInUse;   // Process wide arena memory handed out.
+    uint32_t NumWorkers;        // Workers budgeted to this context.
+    uint32_t NumPoolWorkers;    // Workers in the shared thread pool.
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// STREAMOUT_BUFFERS
 /////////////////////////////////////////////////////////////////////////
@@ -858,6 +909,9 @@ struct SWR_BACKEND_STATE
     uint32_t constantInterpolationMask;
     uint8_t numAttributes;
     uint8_t numComponents[KNOB_NUM_ATTRIBUTES];
+
+    // format of the color hot tiles for each render target, see SwrGetColorHotTileFormat
+    SWR_FORMAT colorHotTileFormat[SWR_NUM_RENDERTARGETS];   // @llvm_enum
 };
 
 union SWR_DEPTH_STENCIL_STATE
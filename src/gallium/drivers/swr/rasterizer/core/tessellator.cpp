@@ -0,0 +1,753 @@
+/****************************************************************************
+* Copyright (C) 2014-2015 Intel Corporation.   All Rights Reserved.
+*
+* Permission is hereby granted, free of charge, to any person obtaining a
+* copy of this software and associated documentation files (the "Software"),
+* to deal in the Software without restriction, including without limitation
+* the rights to use, copy, modify, merge, publish, distribute, sublicense,
+* and/or sell copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice (including the next
+* paragraph) shall be included in all copies or substantial portions of the
+* Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+* THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+* IN THE SOFTWARE.
+*
+* @file tessellator.cpp
+*
+* @brief Implementation of the tessellator fixed function unit.
+*
+*        Domain points are generated ring by ring, from the outer edges of
+*        the domain inwards, and neighboring rings are stitched together.
+*        Points and indices are written into arrays owned by the
+*        tessellation context. The domain point arrays are SIMD aligned
+*        and padded to a multiple of KNOB_SIMD_WIDTH so the domain shader
+*        can consume them directly as simdscalars.
+*
+******************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "context.h"
+#include "tessellator.h"
+
+// Largest tessellation factor supported by any partitioning mode.
+static const uint32_t TS_MAX_TESS_FACTOR = 64;
+
+// Worst case is a quad domain with all factors at TS_MAX_TESS_FACTOR.
+static const uint32_t TS_MAX_DOMAIN_POINTS =
+    (((TS_MAX_TESS_FACTOR + 1) * (TS_MAX_TESS_FACTOR + 1) + KNOB_SIMD_WIDTH - 1) / KNOB_SIMD_WIDTH) * KNOB_SIMD_WIDTH;
+static const uint32_t TS_MAX_PRIMS = 2 * TS_MAX_TESS_FACTOR * TS_MAX_TESS_FACTOR;
+
+static_assert((TS_MAX_PRIMS % KNOB_SIMD_WIDTH) == 0, "PA_TESS loads full SIMDs of indices");
+static_assert((TS_MAX_TESS_FACTOR % KNOB_SIMD_WIDTH) == 0, "edge parameters are generated in full SIMDs");
+
+// Index of each SIMD lane, for generating KNOB_SIMD_WIDTH points at once.
+static const OSALIGNSIMD(float) TS_LANE_INDEX[16] =
+{
+    0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f,
+    8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f,
+};
+static_assert(KNOB_SIMD_WIDTH <= 16, "TS_LANE_INDEX too small for the SIMD width");
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Tessellation factor after clamping and rounding.
+struct TS_FACTOR
+{
+    float factor;           // clamped tessellation factor
+    uint32_t numSegments;   // number of segments the edge is split into
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief List of points along one edge of a ring, used for stitching.
+struct TS_EDGE
+{
+    uint32_t numPoints;
+    uint32_t index[TS_MAX_TESS_FACTOR + 1];
+    float pos[TS_MAX_TESS_FACTOR + 1];      // position along the edge direction
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Tessellation context. Holds the tessellator output.
+struct TS_CONTEXT
+{
+    OSALIGNSIMD(float) domainPointsU[TS_MAX_DOMAIN_POINTS];
+    OSALIGNSIMD(float) domainPointsV[TS_MAX_DOMAIN_POINTS];
+    OSALIGNSIMD(uint32_t) indices[3][TS_MAX_PRIMS];
+
+    SWR_TS_DOMAIN domain;
+    SWR_TS_PARTITIONING partitioning;
+    SWR_TS_OUTPUT_TOPOLOGY outputTopology;
+
+    uint32_t numDomainPoints;
+    uint32_t numPrims;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Clamps and rounds a tessellation factor for the given
+///        partitioning mode.
+/// @param factor - unprocessed tessellation factor
+/// @param partitioning - partitioning mode
+static TS_FACTOR ProcessTessFactor(float factor, SWR_TS_PARTITIONING partitioning)
+{
+    TS_FACTOR result;
+    float minFactor, maxFactor;
+
+    switch (partitioning)
+    {
+    case SWR_TS_INTEGER:
+        minFactor = 1.0f;
+        maxFactor = (float)std::min<uint32_t>(KNOB_MAX_INTEGER_TESS_FACTOR, TS_MAX_TESS_FACTOR);
+        break;
+    case SWR_TS_ODD_FRACTIONAL:
+        minFactor = 1.0f;
+        maxFactor = std::min<float>(KNOB_MAX_FRAC_ODD_TESS_FACTOR, float(TS_MAX_TESS_FACTOR - 1));
+        break;
+    case SWR_TS_EVEN_FRACTIONAL:
+        minFactor = 2.0f;
+        maxFactor = std::min<float>(KNOB_MAX_FRAC_EVEN_TESS_FACTOR, float(TS_MAX_TESS_FACTOR));
+        break;
+    default:
+        SWR_ASSERT(0, "Invalid tessellation partitioning: %d", partitioning);
+        minFactor = maxFactor = 1.0f;
+        break;
+    }
+    maxFactor = std::max(maxFactor, minFactor);
+
+    // written so NaN clamps to the minimum
+    factor = (factor > minFactor) ? factor : minFactor;
+    factor = std::min(factor, maxFactor);
+
+    switch (partitioning)
+    {
+    case SWR_TS_ODD_FRACTIONAL:
+        result.factor = factor;
+        result.numSegments = 2 * (uint32_t)ceilf((factor - 1.0f) * 0.5f) + 1;
+        break;
+    case SWR_TS_EVEN_FRACTIONAL:
+        result.factor = factor;
+        result.numSegments = 2 * (uint32_t)ceilf(factor * 0.5f);
+        break;
+    default:
+        result.factor = ceilf(factor);
+        result.numSegments = (uint32_t)result.factor;
+        break;
+    }
+
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Inner factors that round to a single segment are split anyway
+///        when any outer edge is subdivided, as if the factor were 1 + eps.
+static TS_FACTOR SplitInsideFactor(const TS_FACTOR& inside, SWR_TS_PARTITIONING partitioning)
+{
+    if (inside.numSegments > 1)
+    {
+        return inside;
+    }
+
+    TS_FACTOR result;
+    if (partitioning == SWR_TS_ODD_FRACTIONAL)
+    {
+        // two zero length segments around a full length one
+        result.factor = 1.0f;
+        result.numSegments = 3;
+    }
+    else
+    {
+        result.factor = 2.0f;
+        result.numSegments = 2;
+    }
+    return result;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Position of point i along an edge, for i <= numSegments / 2.
+///        All segments have length 1 / factor except for the two
+///        segments placed symmetrically around the middle of the edge,
+///        which share the remaining fractional length.
+static INLINE float EdgeParamHalf(const TS_FACTOR& tf, uint32_t i)
+{
+    uint32_t n = tf.numSegments;
+    uint32_t firstShort = (n & 1) ? (n - 3) / 2 : n / 2 - 1;
+    float shortLength = (tf.factor - float(n - 2)) * 0.5f;
+
+    if (i > firstShort)
+    {
+        return (float(i - 1) + shortLength) / tf.factor;
+    }
+    return float(i) / tf.factor;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the normalized position of point i along an edge split
+///        according to tf. Positions are symmetric, so a shared edge
+///        walked in opposite directions by two patches produces the same
+///        points.
+/// @param tf - processed tessellation factor for the edge
+/// @param i - point index in [0, numSegments]
+static INLINE float EdgeParam(const TS_FACTOR& tf, uint32_t i)
+{
+    if (i == 0)
+    {
+        return 0.0f;
+    }
+    if (i >= tf.numSegments)
+    {
+        return 1.0f;
+    }
+    if (2 * i > tf.numSegments)
+    {
+        return 1.0f - EdgeParamHalf(tf, tf.numSegments - i);
+    }
+    return EdgeParamHalf(tf, i);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief SIMD version of EdgeParam. Returns the positions of the
+///        KNOB_SIMD_WIDTH points starting at point i, computed exactly as
+///        EdgeParam does. Lanes past numSegments are undefined.
+static INLINE simdscalar EdgeParamSimd(const TS_FACTOR& tf, uint32_t i)
+{
+    uint32_t n = tf.numSegments;
+    uint32_t firstShort = (n & 1) ? (n - 3) / 2 : n / 2 - 1;
+    float shortLength = (tf.factor - float(n - 2)) * 0.5f;
+
+    simdscalar vN = _simd_set1_ps(float(n));
+    simdscalar vI = _simd_add_ps(_simd_set1_ps(float(i)), _simd_load_ps(TS_LANE_INDEX));
+
+    // points in the second half of the edge mirror the first half
+    simdscalar vMirror = _simd_cmpgt_ps(_simd_add_ps(vI, vI), vN);
+    simdscalar vJ = _simd_blendv_ps(vI, _simd_sub_ps(vN, vI), vMirror);
+
+    simdscalar vShort = _simd_cmpgt_ps(vJ, _simd_set1_ps(float(firstShort)));
+    simdscalar vLong = _simd_add_ps(_simd_sub_ps(vJ, _simd_set1_ps(1.0f)), _simd_set1_ps(shortLength));
+    simdscalar vT = _simd_div_ps(_simd_blendv_ps(vJ, vLong, vShort), _simd_set1_ps(tf.factor));
+
+    return _simd_blendv_ps(vT, _simd_sub_ps(_simd_set1_ps(1.0f), vT), vMirror);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Mask of the first count lanes, for storing a partial SIMD.
+static INLINE simdscalari LaneMask(uint32_t count)
+{
+    return _simd_castps_si(_simd_cmplt_ps(_simd_load_ps(TS_LANE_INDEX), _simd_set1_ps(float(count))));
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Writes up to KNOB_SIMD_WIDTH domain points at index first.
+///        Only the first count lanes are written.
+static INLINE void StorePoints(TS_CONTEXT* pCtx, uint32_t first, uint32_t count, simdscalar vU, simdscalar vV)
+{
+    simdscalari vMask = LaneMask(count);
+    _simd_maskstore_ps(&pCtx->domainPointsU[first], vMask, vU);
+    _simd_maskstore_ps(&pCtx->domainPointsV[first], vMask, vV);
+}
+
+static INLINE uint32_t AddPoint(TS_CONTEXT* pCtx, float u, float v)
+{
+    SWR_ASSERT(pCtx->numDomainPoints < TS_MAX_DOMAIN_POINTS);
+    uint32_t index = pCtx->numDomainPoints++;
+    pCtx->domainPointsU[index] = u;
+    pCtx->domainPointsV[index] = v;
+    return index;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Emits a triangle. Triangles are generated counter-clockwise in
+///        (u, v) and flipped here for clockwise output.
+static INLINE void AddTri(TS_CONTEXT* pCtx, uint32_t i0, uint32_t i1, uint32_t i2)
+{
+    if (pCtx->outputTopology == SWR_TS_OUTPUT_POINT)
+    {
+        return;
+    }
+
+    SWR_ASSERT(pCtx->numPrims < TS_MAX_PRIMS);
+    uint32_t prim = pCtx->numPrims++;
+    pCtx->indices[0][prim] = i0;
+    if (pCtx->outputTopology == SWR_TS_OUTPUT_TRI_CW)
+    {
+        pCtx->indices[1][prim] = i2;
+        pCtx->indices[2][prim] = i1;
+    }
+    else
+    {
+        pCtx->indices[1][prim] = i1;
+        pCtx->indices[2][prim] = i2;
+    }
+}
+
+static INLINE void AddLine(TS_CONTEXT* pCtx, uint32_t i0, uint32_t i1)
+{
+    if (pCtx->outputTopology == SWR_TS_OUTPUT_POINT)
+    {
+        return;
+    }
+
+    SWR_ASSERT(pCtx->numPrims < TS_MAX_PRIMS);
+    uint32_t prim = pCtx->numPrims++;
+    pCtx->indices[0][prim] = i0;
+    pCtx->indices[1][prim] = i1;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Triangulates the strip between an outer and an inner edge that
+///        run in the same direction, with the interior to their left.
+///        Always advances along the edge whose next point comes first.
+/// @param pCtx - tessellation context
+/// @param outer - points of the outer edge, corner to corner
+/// @param inner - points of the inner edge, may be a single point
+static void StitchEdge(TS_CONTEXT* pCtx, const TS_EDGE& outer, const TS_EDGE& inner)
+{
+    uint32_t i = 0;
+    uint32_t j = 0;
+    uint32_t lastOuter = outer.numPoints - 1;
+    uint32_t lastInner = inner.numPoints - 1;
+
+    while (i < lastOuter || j < lastInner)
+    {
+        bool advanceOuter;
+        if (j == lastInner)
+        {
+            advanceOuter = true;
+        }
+        else if (i == lastOuter)
+        {
+            advanceOuter = false;
+        }
+        else
+        {
+            advanceOuter = outer.pos[i + 1] <= inner.pos[j + 1];
+        }
+
+        if (advanceOuter)
+        {
+            AddTri(pCtx, outer.index[i], outer.index[i + 1], inner.index[j]);
+            ++i;
+        }
+        else
+        {
+            AddTri(pCtx, outer.index[i], inner.index[j + 1], inner.index[j]);
+            ++j;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Generates a closed ring of points between numEdges corners.
+///        Edge e runs from corner e to corner e + 1 and is split by
+///        pFactors[e]. The position of each point along its edge is the
+///        barycentric/domain coordinate of the edge's end corner, given
+///        by pEndAxis.
+/// @param pCtx - tessellation context
+/// @param numEdges - 3 for triangles, 4 for quads
+/// @param pCornerU - u coordinate of the corners
+/// @param pCornerV - v coordinate of the corners
+/// @param pFactors - per edge tessellation factors
+/// @param pEdges - receives the point lists of each edge
+static void GenerateRing(
+    TS_CONTEXT* pCtx,
+    uint32_t numEdges,
+    const float* pCornerU,
+    const float* pCornerV,
+    const TS_FACTOR* pFactors,
+    TS_EDGE* pEdges)
+{
+    uint32_t firstPoint = pCtx->numDomainPoints;
+
+    for (uint32_t e = 0; e < numEdges; ++e)
+    {
+        uint32_t next = (e + 1) % numEdges;
+        float du = pCornerU[next] - pCornerU[e];
+        float dv = pCornerV[next] - pCornerV[e];
+
+        TS_EDGE& edge = pEdges[e];
+        uint32_t numSegments = pFactors[e].numSegments;
+        uint32_t first = pCtx->numDomainPoints;
+        SWR_ASSERT(first + numSegments <= TS_MAX_DOMAIN_POINTS);
+
+        // the end corner is the next edge's first point and is not emitted
+        for (uint32_t i = 0; i < numSegments; i += KNOB_SIMD_WIDTH)
+        {
+            simdscalar vT = EdgeParamSimd(pFactors[e], i);
+            simdscalar vU = _simd_add_ps(_simd_set1_ps(pCornerU[e]), _simd_mul_ps(_simd_set1_ps(du), vT));
+            simdscalar vV = _simd_add_ps(_simd_set1_ps(pCornerV[e]), _simd_mul_ps(_simd_set1_ps(dv), vT));
+            StorePoints(pCtx, first + i, numSegments - i, vU, vV);
+            _simd_maskstore_ps(&edge.pos[i], LaneMask(numSegments - i), vT);
+        }
+        for (uint32_t i = 0; i < numSegments; ++i)
+        {
+            edge.index[i] = first + i;
+        }
+        pCtx->numDomainPoints += numSegments;
+
+        edge.numPoints = numSegments + 1;
+        edge.pos[numSegments] = 1.0f;
+    }
+
+    // the last point of each edge is the first point of the next edge
+    for (uint32_t e = 0; e < numEdges; ++e)
+    {
+        uint32_t next = (e + 1) % numEdges;
+        pEdges[e].index[pEdges[e].numPoints - 1] =
+            (next == 0) ? firstPoint : pEdges[next].index[0];
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Rescales the positions of an inner edge into the frame of the
+///        outer edge it is stitched to.
+static INLINE void RemapEdge(TS_EDGE& edge, float start, float end)
+{
+    for (uint32_t i = 0; i < edge.numPoints; ++i)
+    {
+        edge.pos[i] = start + (end - start) * edge.pos[i];
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Tessellates the triangle domain. Corners in (u, v) are
+///        W = (0, 0), U = (1, 0) and V = (0, 1).
+static void TessellateTri(TS_CONTEXT* pCtx, const SWR_TESSELLATION_FACTORS& tsTessFactors)
+{
+    // ring edges in counter-clockwise order W->U (v == 0), U->V (w == 0), V->W (u == 0)
+    TS_FACTOR outer[3] =
+    {
+        ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_V_EQ0_TRI_V_LINE_DENSITY], pCtx->partitioning),
+        ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_U_EQ1_TRI_W], pCtx->partitioning),
+        ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_U_EQ0_TRI_U_LINE_DETAIL], pCtx->partitioning),
+    };
+    TS_FACTOR inside = ProcessTessFactor(tsTessFactors.InnerTessFactors[SWR_QUAD_U_TRI_INSIDE], pCtx->partitioning);
+
+    if (outer[0].numSegments == 1 && outer[1].numSegments == 1 && outer[2].numSegments == 1 &&
+        inside.numSegments == 1)
+    {
+        uint32_t w = AddPoint(pCtx, 0.0f, 0.0f);
+        uint32_t u = AddPoint(pCtx, 1.0f, 0.0f);
+        uint32_t v = AddPoint(pCtx, 0.0f, 1.0f);
+        AddTri(pCtx, w, u, v);
+        return;
+    }
+
+    inside = SplitInsideFactor(inside, pCtx->partitioning);
+
+    static const float outerCornerU[3] = { 0.0f, 1.0f, 0.0f };
+    static const float outerCornerV[3] = { 0.0f, 0.0f, 1.0f };
+
+    TS_EDGE edges[2][3];
+    TS_EDGE* pOuterEdges = edges[0];
+    TS_EDGE* pInnerEdges = edges[1];
+    GenerateRing(pCtx, 3, outerCornerU, outerCornerV, outer, pOuterEdges);
+
+    // Inner ring k has numSegments - 2k segments per edge. Its corners are
+    // where the perpendiculars through the k-th points of the adjacent
+    // edges of an inside-factor ring meet.
+    for (uint32_t k = 1; 2 * k <= inside.numSegments; ++k)
+    {
+        float d = EdgeParam(inside, k);
+        float a = d * (2.0f / 3.0f);
+        float b = 1.0f - 2.0f * a;
+        uint32_t ringSegments = inside.numSegments - 2 * k;
+
+        if (ringSegments == 0)
+        {
+            TS_EDGE& center = pInnerEdges[0];
+            center.numPoints = 1;
+            center.index[0] = AddPoint(pCtx, 1.0f / 3.0f, 1.0f / 3.0f);
+            center.pos[0] = 0.5f;
+            for (uint32_t e = 0; e < 3; ++e)
+            {
+                StitchEdge(pCtx, pOuterEdges[e], center);
+            }
+            return;
+        }
+
+        const float cornerU[3] = { a, b, a };
+        const float cornerV[3] = { a, a, b };
+        TS_FACTOR ring[3];
+        ring[0].factor = inside.factor - float(2 * k);
+        ring[0].numSegments = ringSegments;
+        ring[1] = ring[2] = ring[0];
+
+        GenerateRing(pCtx, 3, cornerU, cornerV, ring, pInnerEdges);
+        for (uint32_t e = 0; e < 3; ++e)
+        {
+            // positions along each edge measured as the end corner's coordinate
+            RemapEdge(pInnerEdges[e], a, b);
+            StitchEdge(pCtx, pOuterEdges[e], pInnerEdges[e]);
+        }
+
+        if (ringSegments == 1)
+        {
+            AddTri(pCtx, pInnerEdges[0].index[0], pInnerEdges[1].index[0], pInnerEdges[2].index[0]);
+            return;
+        }
+
+        std::swap(pOuterEdges, pInnerEdges);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Tessellates the quad domain. The interior is a regular grid
+///        split by the inside factors; the outer ring is stitched to the
+///        boundary of that grid.
+static void TessellateQuad(TS_CONTEXT* pCtx, const SWR_TESSELLATION_FACTORS& tsTessFactors)
+{
+    // ring edges in counter-clockwise order v == 0, u == 1, v == 1, u == 0
+    TS_FACTOR outer[4] =
+    {
+        ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_V_EQ0_TRI_V_LINE_DENSITY], pCtx->partitioning),
+        ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_U_EQ1_TRI_W], pCtx->partitioning),
+        ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_V_EQ1], pCtx->partitioning),
+        ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_U_EQ0_TRI_U_LINE_DETAIL], pCtx->partitioning),
+    };
+    TS_FACTOR insideU = ProcessTessFactor(tsTessFactors.InnerTessFactors[SWR_QUAD_U_TRI_INSIDE], pCtx->partitioning);
+    TS_FACTOR insideV = ProcessTessFactor(tsTessFactors.InnerTessFactors[SWR_QUAD_V_INSIDE], pCtx->partitioning);
+
+    if (outer[0].numSegments == 1 && outer[1].numSegments == 1 &&
+        outer[2].numSegments == 1 && outer[3].numSegments == 1 &&
+        insideU.numSegments == 1 && insideV.numSegments == 1)
+    {
+        uint32_t p00 = AddPoint(pCtx, 0.0f, 0.0f);
+        uint32_t p10 = AddPoint(pCtx, 1.0f, 0.0f);
+        uint32_t p11 = AddPoint(pCtx, 1.0f, 1.0f);
+        uint32_t p01 = AddPoint(pCtx, 0.0f, 1.0f);
+        AddTri(pCtx, p00, p10, p11);
+        AddTri(pCtx, p00, p11, p01);
+        return;
+    }
+
+    insideU = SplitInsideFactor(insideU, pCtx->partitioning);
+    insideV = SplitInsideFactor(insideV, pCtx->partitioning);
+
+    static const float cornerU[4] = { 0.0f, 1.0f, 1.0f, 0.0f };
+    static const float cornerV[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+
+    TS_EDGE outerEdges[4];
+    GenerateRing(pCtx, 4, cornerU, cornerV, outer, outerEdges);
+
+    // interior grid excludes the first and last point in each direction
+    uint32_t numU = insideU.numSegments - 1;
+    uint32_t numV = insideV.numSegments - 1;
+    OSALIGNSIMD(float) gridU[TS_MAX_TESS_FACTOR];
+    OSALIGNSIMD(float) gridV[TS_MAX_TESS_FACTOR];
+    for (uint32_t i = 0; i < numU; i += KNOB_SIMD_WIDTH)
+    {
+        _simd_store_ps(&gridU[i], EdgeParamSimd(insideU, i + 1));
+    }
+    for (uint32_t j = 0; j < numV; j += KNOB_SIMD_WIDTH)
+    {
+        _simd_store_ps(&gridV[j], EdgeParamSimd(insideV, j + 1));
+    }
+
+    uint32_t gridBase = pCtx->numDomainPoints;
+    SWR_ASSERT(gridBase + numU * numV <= TS_MAX_DOMAIN_POINTS);
+    for (uint32_t j = 0; j < numV; ++j)
+    {
+        simdscalar vV = _simd_set1_ps(gridV[j]);
+        uint32_t rowBase = gridBase + j * numU;
+        for (uint32_t i = 0; i < numU; i += KNOB_SIMD_WIDTH)
+        {
+            StorePoints(pCtx, rowBase + i, numU - i, _simd_load_ps(&gridU[i]), vV);
+        }
+    }
+    pCtx->numDomainPoints += numU * numV;
+
+    for (uint32_t j = 0; j + 1 < numV; ++j)
+    {
+        for (uint32_t i = 0; i + 1 < numU; ++i)
+        {
+            uint32_t p00 = gridBase + j * numU + i;
+            uint32_t p10 = p00 + 1;
+            uint32_t p01 = p00 + numU;
+            uint32_t p11 = p01 + 1;
+            AddTri(pCtx, p00, p10, p11);
+            AddTri(pCtx, p00, p11, p01);
+        }
+    }
+
+    // boundary of the grid, walked in the same direction as the outer ring
+    TS_EDGE inner;
+
+    inner.numPoints = numU;
+    for (uint32_t i = 0; i < numU; ++i)
+    {
+        inner.index[i] = gridBase + i;
+        inner.pos[i] = gridU[i];
+    }
+    StitchEdge(pCtx, outerEdges[0], inner);
+
+    inner.numPoints = numV;
+    for (uint32_t j = 0; j < numV; ++j)
+    {
+        inner.index[j] = gridBase + j * numU + (numU - 1);
+        inner.pos[j] = gridV[j];
+    }
+    StitchEdge(pCtx, outerEdges[1], inner);
+
+    inner.numPoints = numU;
+    for (uint32_t i = 0; i < numU; ++i)
+    {
+        uint32_t gridI = numU - 1 - i;
+        inner.index[i] = gridBase + (numV - 1) * numU + gridI;
+        inner.pos[i] = 1.0f - gridU[gridI];
+    }
+    StitchEdge(pCtx, outerEdges[2], inner);
+
+    inner.numPoints = numV;
+    for (uint32_t j = 0; j < numV; ++j)
+    {
+        uint32_t gridJ = numV - 1 - j;
+        inner.index[j] = gridBase + gridJ * numU;
+        inner.pos[j] = 1.0f - gridV[gridJ];
+    }
+    StitchEdge(pCtx, outerEdges[3], inner);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Tessellates the isoline domain into lines of constant v. Line
+///        density always uses integer partitioning.
+static void TessellateIsoline(TS_CONTEXT* pCtx, const SWR_TESSELLATION_FACTORS& tsTessFactors)
+{
+    TS_FACTOR detail = ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_U_EQ0_TRI_U_LINE_DETAIL], pCtx->partitioning);
+    TS_FACTOR density = ProcessTessFactor(tsTessFactors.OuterTessFactors[SWR_QUAD_V_EQ0_TRI_V_LINE_DENSITY], SWR_TS_INTEGER);
+
+    uint32_t numLinePoints = detail.numSegments + 1;
+    OSALIGNSIMD(float) lineU[TS_MAX_TESS_FACTOR + KNOB_SIMD_WIDTH];
+    for (uint32_t i = 0; i < numLinePoints; i += KNOB_SIMD_WIDTH)
+    {
+        _simd_store_ps(&lineU[i], EdgeParamSimd(detail, i));
+    }
+
+    for (uint32_t line = 0; line < density.numSegments; ++line)
+    {
+        simdscalar vV = _simd_set1_ps(float(line) / density.factor);
+        uint32_t first = pCtx->numDomainPoints;
+        SWR_ASSERT(first + numLinePoints <= TS_MAX_DOMAIN_POINTS);
+        for (uint32_t i = 0; i < numLinePoints; i += KNOB_SIMD_WIDTH)
+        {
+            StorePoints(pCtx, first + i, numLinePoints - i, _simd_load_ps(&lineU[i]), vV);
+        }
+        pCtx->numDomainPoints += numLinePoints;
+        for (uint32_t i = 0; i < detail.numSegments; ++i)
+        {
+            AddLine(pCtx, first + i, first + i + 1);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Allocate and initialize a new tessellation context.
+///        Returns NULL and sets memSize to the required size if
+///        pContextMem is NULL or too small.
+HANDLE SWR_API TSInitCtx(
+    SWR_TS_DOMAIN tsDomain,
+    SWR_TS_PARTITIONING tsPartitioning,
+    SWR_TS_OUTPUT_TOPOLOGY tsOutputTopology,
+    void* pContextMem,
+    size_t& memSize)
+{
+    if (pContextMem == nullptr || memSize < sizeof(TS_CONTEXT))
+    {
+        memSize = sizeof(TS_CONTEXT);
+        return NULL;
+    }
+
+    SWR_ASSERT(((size_t)pContextMem & (sizeof(simdscalar) - 1)) == 0);
+    SWR_ASSERT(tsDomain < SWR_TS_DOMAIN_COUNT);
+    SWR_ASSERT(tsPartitioning < SWR_TS_PARTITIONING_COUNT);
+    SWR_ASSERT(tsDomain != SWR_TS_ISOLINE ||
+               tsOutputTopology == SWR_TS_OUTPUT_LINE || tsOutputTopology == SWR_TS_OUTPUT_POINT);
+    SWR_ASSERT(tsDomain == SWR_TS_ISOLINE || tsOutputTopology != SWR_TS_OUTPUT_LINE);
+
+    TS_CONTEXT* pCtx = (TS_CONTEXT*)pContextMem;
+    pCtx->domain = tsDomain;
+    pCtx->partitioning = tsPartitioning;
+    pCtx->outputTopology = tsOutputTopology;
+    pCtx->numDomainPoints = 0;
+    pCtx->numPrims = 0;
+
+    return pCtx;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Destroy a tessellation context. The context memory is owned by
+///        the caller and is not freed.
+void SWR_API TSDestroyCtx(HANDLE tsCtx)
+{
+    SWR_ASSERT(tsCtx);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Tessellate a single patch. Output arrays remain valid until
+///        the next call to TSTessellate on the same context.
+void SWR_API TSTessellate(
+    HANDLE tsCtx,
+    const SWR_TESSELLATION_FACTORS& tsTessFactors,
+    SWR_TS_TESSELLATED_DATA& tsTessellatedData)
+{
+    TS_CONTEXT* pCtx = (TS_CONTEXT*)tsCtx;
+    SWR_ASSERT(pCtx);
+
+    pCtx->numDomainPoints = 0;
+    pCtx->numPrims = 0;
+
+    tsTessellatedData.NumPrimitives = 0;
+    tsTessellatedData.NumDomainPoints = 0;
+
+    // patches with an outer factor <= 0 or NaN are culled
+    uint32_t numOuterFactors = (pCtx->domain == SWR_TS_QUAD) ? 4 : (pCtx->domain == SWR_TS_TRI) ? 3 : 2;
+    for (uint32_t i = 0; i < numOuterFactors; ++i)
+    {
+        if (!(tsTessFactors.OuterTessFactors[i] > 0.0f))
+        {
+            return;
+        }
+    }
+
+    switch (pCtx->domain)
+    {
+    case SWR_TS_QUAD:       TessellateQuad(pCtx, tsTessFactors); break;
+    case SWR_TS_TRI:        TessellateTri(pCtx, tsTessFactors); break;
+    case SWR_TS_ISOLINE:    TessellateIsoline(pCtx, tsTessFactors); break;
+    default:                SWR_ASSERT(0, "Invalid tessellation domain: %d", pCtx->domain); return;
+    }
+
+    uint32_t numPoints = pCtx->numDomainPoints;
+    SWR_ASSERT(numPoints > 0);
+
+    if (pCtx->outputTopology == SWR_TS_OUTPUT_POINT)
+    {
+        for (uint32_t i = 0; i < numPoints; ++i)
+        {
+            pCtx->indices[0][i] = i;
+        }
+        pCtx->numPrims = numPoints;
+    }
+
+    // replicate the last point so the DS can run full SIMDs
+    uint32_t numPaddedPoints = AlignUp(numPoints, KNOB_SIMD_WIDTH);
+    for (uint32_t i = numPoints; i < numPaddedPoints; ++i)
+    {
+        pCtx->domainPointsU[i] = pCtx->domainPointsU[numPoints - 1];
+        pCtx->domainPointsV[i] = pCtx->domainPointsV[numPoints - 1];
+    }
+
+    tsTessellatedData.NumPrimitives = pCtx->numPrims;
+    tsTessellatedData.NumDomainPoints = numPoints;
+    tsTessellatedData.ppIndices[0] = pCtx->indices[0];
+    tsTessellatedData.ppIndices[1] = pCtx->indices[1];
+    tsTessellatedData.ppIndices[2] = pCtx->indices[2];
+    tsTessellatedData.pDomainPointsU = pCtx->domainPointsU;
+    tsTessellatedData.pDomainPointsV = pCtx->domainPointsV;
+}
@@ -35,7 +35,7 @@ HANDLE SWR_API TSInitCtx(
     void* pContextMem,                          ///< [IN] Memory to use for the context
     size_t& memSize);                           ///< [INOUT] In: Amount of memory in pContextMem. Out: Mem required
 
-/// Destroy & de-allocate tessellation context
+/// Destroy tessellation context (pContextMem passed to TSInitCtx is owned by the caller)
 void SWR_API TSDestroyCtx(
     HANDLE tsCtx);  ///< [IN] Tessellation context to be destroyed
 
@@ -56,33 +56,3 @@ void SWR_API TSTessellate(
     const SWR_TESSELLATION_FACTORS& tsTessFactors,  ///< [IN] Tessellation Factors
     SWR_TS_TESSELLATED_DATA& tsTessellatedData);    ///< [OUT] Tessellated Data
 
-
-
-/// @TODO - Implement OSS tessellator
-
-INLINE HANDLE SWR_API TSInitCtx(
-    SWR_TS_DOMAIN tsDomain,
-    SWR_TS_PARTITIONING tsPartitioning,
-    SWR_TS_OUTPUT_TOPOLOGY tsOutputTopology,
-    void* pContextMem,
-    size_t& memSize)
-{
-    SWR_ASSERT(0, "%s: Not Implemented", __FUNCTION__);
-    return NULL;
-}
-
-
-INLINE void SWR_API TSDestroyCtx(HANDLE tsCtx)
-{
-    SWR_ASSERT(0, "%s: Not Implemented", __FUNCTION__);
-}
-
-
-INLINE void SWR_API TSTessellate(
-    HANDLE tsCtx,
-    const SWR_TESSELLATION_FACTORS& tsTessFactors,
-    SWR_TS_TESSELLATED_DATA& tsTessellatedData)
-{
-    SWR_ASSERT(0, "%s: Not Implemented", __FUNCTION__);
-}
-
@@ -46,6 +46,7 @@
 #include "rdtsc_core.h"
 #include "tilemgr.h"
 #include "core/multisample.h"
+#include "core/format_conversion.h"
 
 // ThreadId
 struct Core
@@ -261,8 +262,55 @@ bool CheckDependency(SWR_CONTEXT *pContext, DRAW_CONTEXT *pDC, uint64_t lastReti
     return (pDC->dependency > lastRetiredDraw);
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Clear a low precision color macro tile. The clear color is converted
+///        once into a single simd tile which is then replicated over the tile.
+template<SWR_FORMAT HotTileFormat>
+void ClearColorHotTile(const HOTTILE* pHotTile)
+{
+    static const uint32_t simdTileBytes = KNOB_SIMD_WIDTH * FormatTraits<HotTileFormat>::bpp / 8;
+    static_assert(simdTileBytes % sizeof(simdscalari) == 0, "Unsupported hot tile format");
+
+    // Convert clear color to hot tile format...
+    float *pClearData = (float*)(pHotTile->clearData);
+    simdvector vClear;
+    vClear.v[0] = _simd_broadcast_ss(&pClearData[0]);
+    vClear.v[1] = _simd_broadcast_ss(&pClearData[1]);
+    vClear.v[2] = _simd_broadcast_ss(&pClearData[2]);
+    vClear.v[3] = _simd_broadcast_ss(&pClearData[3]);
+
+    OSALIGNSIMD(BYTE) clearTile[simdTileBytes];
+    StoreSOA<HotTileFormat>(vClear, clearTile);
+
+    simdscalari vals[simdTileBytes / sizeof(simdscalari)];
+    for (uint32_t i = 0; i < simdTileBytes / sizeof(simdscalari); ++i)
+    {
+        vals[i] = _simd_load_si((const simdscalari*)&clearTile[i * sizeof(simdscalari)]);
+    }
+
+    simdscalari* pBuf = (simdscalari*)pHotTile->pBuffer;
+    uint32_t numSimdTiles = (KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * pHotTile->numSamples) / (SIMD_TILE_X_DIM * SIMD_TILE_Y_DIM);
+
+    for (uint32_t si = 0; si < numSimdTiles; ++si)
+    {
+        for (uint32_t i = 0; i < simdTileBytes / sizeof(simdscalari); ++i)
+        {
+            _simd_store_si(pBuf, vals[i]);
+            pBuf += 1;
+        }
+    }
+}
+
 void ClearColorHotTile(const HOTTILE* pHotTile)  // clear a macro tile from float4 clear data.
 {
+    switch (pHotTile->format)
+    {
+    case R32G32B32A32_FLOAT: break;
+    case R8G8B8A8_UNORM: ClearColorHotTile<R8G8B8A8_UNORM>(pHotTile); return;
+    case R16G16B16A16_FLOAT: ClearColorHotTile<R16G16B16A16_FLOAT>(pHotTile); return;
+    default: SWR_ASSERT(false, "Unsupported hot tile format: %d", pHotTile->format); return;
+    }
+
     // Load clear color into SIMD register...
     float *pClearData = (float*)(pHotTile->clearData);
     simdscalar valR = _simd_broadcast_ss(&pClearData[0]);
@@ -292,7 +340,7 @@ void ClearColorHotTile(const HOTTILE* pHotTile)  // clear a macro tile from floa
     }
 }
 
-void ClearDepthHotTile(const HOTTILE* pHotTile)  // clear a macro tile from float4 clear data.
+void ClearDepthHotTile(HOTTILE* pHotTile)  // clear a macro tile from float4 clear data.
 {
     // Load clear color into SIMD register...
     float *pClearData = (float*)(pHotTile->clearData);
@@ -312,6 +360,8 @@ void ClearDepthHotTile(const HOTTILE* pHotTile)  // clear a macro tile from floa
             }
         }
     }
+
+    HotTileMgr::ResetHiZ(pHotTile, pClearData[0], pClearData[0]);
 }
 
 void ClearStencilHotTile(const HOTTILE* pHotTile)
@@ -369,9 +419,9 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
             {
                 RDTSC_START(BELoadTiles);
                 // invalid hottile before draw requires a load from surface before we can draw to it
-                pContext->pfnLoadTile(GetPrivateState(pDC), KNOB_COLOR_HOT_TILE_FORMAT, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rt), x, y, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
+                HotTileMgr::LoadHotTile(pContext, pDC, (SWR_RENDERTARGET_ATTACHMENT)(SWR_ATTACHMENT_COLOR0 + rt), x, y, pHotTile);
                 pHotTile->state = HOTTILE_DIRTY;
-                RDTSC_STOP(BELoadTiles, 0, 0);
+                RDTSC_STOP(BELoadTiles, 0, pDC->drawId);
             }
             else if (pHotTile->state == HOTTILE_CLEAR)
             {
@@ -379,7 +429,7 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
                 // Clear the tile.
                 ClearColorHotTile(pHotTile);
                 pHotTile->state = HOTTILE_DIRTY;
-                RDTSC_STOP(BELoadTiles, 0, 0);
+                RDTSC_STOP(BELoadTiles, 0, pDC->drawId);
             }
         }
     }
@@ -392,9 +442,9 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
         {
             RDTSC_START(BELoadTiles);
             // invalid hottile before draw requires a load from surface before we can draw to it
-            pContext->pfnLoadTile(GetPrivateState(pDC), KNOB_DEPTH_HOT_TILE_FORMAT, SWR_ATTACHMENT_DEPTH, x, y, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
+            HotTileMgr::LoadHotTile(pContext, pDC, SWR_ATTACHMENT_DEPTH, x, y, pHotTile);
             pHotTile->state = HOTTILE_DIRTY;
-            RDTSC_STOP(BELoadTiles, 0, 0);
+            RDTSC_STOP(BELoadTiles, 0, pDC->drawId);
         }
         else if (pHotTile->state == HOTTILE_CLEAR)
         {
@@ -402,7 +452,7 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
             // Clear the tile.
             ClearDepthHotTile(pHotTile);
             pHotTile->state = HOTTILE_DIRTY;
-            RDTSC_STOP(BELoadTiles, 0, 0);
+            RDTSC_STOP(BELoadTiles, 0, pDC->drawId);
         }
     }
 
@@ -414,9 +464,9 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
         {
             RDTSC_START(BELoadTiles);
             // invalid hottile before draw requires a load from surface before we can draw to it
-            pContext->pfnLoadTile(GetPrivateState(pDC), KNOB_STENCIL_HOT_TILE_FORMAT, SWR_ATTACHMENT_STENCIL, x, y, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
+            HotTileMgr::LoadHotTile(pContext, pDC, SWR_ATTACHMENT_STENCIL, x, y, pHotTile);
             pHotTile->state = HOTTILE_DIRTY;
-            RDTSC_STOP(BELoadTiles, 0, 0);
+            RDTSC_STOP(BELoadTiles, 0, pDC->drawId);
         }
         else if (pHotTile->state == HOTTILE_CLEAR)
         {
@@ -424,7 +474,7 @@ void InitializeHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macro
             // Clear the tile.
             ClearStencilHotTile(pHotTile);
             pHotTile->state = HOTTILE_DIRTY;
-            RDTSC_STOP(BELoadTiles, 0, 0);
+            RDTSC_STOP(BELoadTiles, 0, pDC->drawId);
         }
     }
 }
@@ -464,18 +514,12 @@ INLINE bool FindFirstIncompleteDraw(SWR_CONTEXT* pContext, volatile uint64_t& cu
 /// @param curDrawBE - This tracks the draw contexts that this thread has processed. Each worker thread
 ///                    has its own curDrawBE counter and this ensures that each worker processes all the
 ///                    draws in order.
-/// @param lockedTiles - This is the set of tiles locked by other threads. Each thread maintains its
-///                      own set and each time it fails to lock a macrotile, because its already locked,
-///                      then it will add that tile to the lockedTiles set. As a worker begins to work
-///                      on future draws the lockedTiles ensure that it doesn't work on tiles that may
-///                      still have work pending in a previous draw. Additionally, the lockedTiles is
-///                      hueristic that can steer a worker back to the same macrotile that it had been
-///                      working on in a previous draw.
+/// @note Draw and per-macrotile ordering is handled by the MacroTileScheduler. Workers
+///       publish newly FE complete draws to it and then drain macrotiles it hands out.
 void WorkOnFifoBE(
     SWR_CONTEXT *pContext,
     uint32_t workerId,
-    volatile uint64_t &curDrawBE,
-    std::unordered_set<uint32_t>& lockedTiles)
+    volatile uint64_t &curDrawBE)
 {
     // Find the first incomplete draw that has pending work. If no such draw is found then
     // return. FindFirstIncompleteDraw is responsible for incrementing the curDrawBE.
@@ -484,94 +528,61 @@ void WorkOnFifoBE(
         return;
     }
 
-    uint64_t lastRetiredDraw = pContext->dcRing[curDrawBE % KNOB_MAX_DRAWS_IN_FLIGHT].drawId - 1;
+    MacroTileScheduler* pScheduler = pContext->pTileScheduler;
+    pScheduler->publishDraws(pContext, curDrawBE);
 
-    // Reset our history for locked tiles. We'll have to re-learn which tiles are locked.
-    lockedTiles.clear();
+    WORKER_COUNTERS &counters = pContext->workerCounters[workerId];
+    HotTileMgr* pHotTileMgr = pContext->pHotTileMgr;
+    bool budgeted = pHotTileMgr->HasBudget();
 
-    // Try to work on each draw in order of the available draws in flight.
-    //   1. If we're on curDrawBE, we can work on any macrotile that is available.
-    //   2. If we're trying to work on draws after curDrawBE, we are restricted to 
-    //      working on those macrotiles that are known to be complete in the prior draw to
-    //      maintain order. The locked tiles provides the history to ensures this.
-    for (uint64_t i = curDrawBE; i < GetEnqueuedDraw(pContext); ++i)
+    MacroTileWork tileWork;
+    while (pScheduler->getWork(workerId, tileWork))
     {
-        DRAW_CONTEXT *pDC = &pContext->dcRing[i % KNOB_MAX_DRAWS_IN_FLIGHT];
+        uint64_t tileStart = __rdtsc();
+        DRAW_CONTEXT *pDC = tileWork.pDC;
+        uint32_t tileID = tileWork.tileID;
+        MacroTileQueue &tile = pDC->pTileMgr->getMacroTileQueue(tileID);
+        BE_WORK *pWork;
 
-        if (pDC->isCompute) return; // We don't look at compute work.
+        RDTSC_START(WorkerFoundWork);
 
-        // First wait for FE to be finished with this draw. This keeps threading model simple
-        // but if there are lots of bubbles between draws then serializing FE and BE may
-        // need to be revisited.
-        if (!pDC->doneFE) break;
-        
-        // If this draw is dependent on a previous draw then we need to bail.
-        if (CheckDependency(pContext, pDC, lastRetiredDraw))
+        if (budgeted)
         {
-            return;
+            pHotTileMgr->LockTile(tileID);
         }
 
-        // Grab the list of all dirty macrotiles. A tile is dirty if it has work queued to it.
-        std::vector<uint32_t> &macroTiles = pDC->pTileMgr->getDirtyTiles();
+        uint32_t numWorkItems = tile.getNumQueued();
 
-        for (uint32_t tileID : macroTiles)
+        if (numWorkItems != 0)
         {
-            MacroTileQueue &tile = pDC->pTileMgr->getMacroTileQueue(tileID);
-            
-            // can only work on this draw if it's not in use by other threads
-            if (lockedTiles.find(tileID) == lockedTiles.end())
+            pWork = tile.peek();
+            SWR_ASSERT(pWork);
+            if (pWork->type == DRAW)
             {
-                if (tile.getNumQueued())
-                {
-                    if (tile.tryLock())
-                    {
-                        BE_WORK *pWork;
-
-                        RDTSC_START(WorkerFoundWork);
-
-                        uint32_t numWorkItems = tile.getNumQueued();
-
-                        if (numWorkItems != 0)
-                        {
-                            pWork = tile.peek();
-                            SWR_ASSERT(pWork);
-                            if (pWork->type == DRAW)
-                            {
-                                InitializeHotTiles(pContext, pDC, tileID, (const TRIANGLE_WORK_DESC*)&pWork->desc);
-                            }
-                        }
-
-                        while ((pWork = tile.peek()) != nullptr)
-                        {
-                            pWork->pfnWork(pDC, workerId, tileID, &pWork->desc);
-                            tile.dequeue();
-                        }
-                        RDTSC_STOP(WorkerFoundWork, numWorkItems, pDC->drawId);
-
-                        _ReadWriteBarrier();
-
-                        pDC->pTileMgr->markTileComplete(tileID);
-
-                        // Optimization: If the draw is complete and we're the last one to have worked on it then
-                        // we can reset the locked list as we know that all previous draws before the next are guaranteed to be complete.
-                        if ((curDrawBE == i) && pDC->pTileMgr->isWorkComplete())
-                        {
-                            // We can increment the current BE and safely move to next draw since we know this draw is complete.
-                            curDrawBE++;
-                            lastRetiredDraw++;
-
-                            lockedTiles.clear();
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        // This tile is already locked. So let's add it to our locked tiles set. This way we don't try locking this one again.
-                        lockedTiles.insert(tileID);
-                    }
-                }
+                InitializeHotTiles(pContext, pDC, tileID, (const TRIANGLE_WORK_DESC*)&pWork->desc);
             }
         }
+
+        while ((pWork = tile.peek()) != nullptr)
+        {
+            pWork->pfnWork(pDC, workerId, tileID, &pWork->desc);
+            tile.dequeue();
+        }
+        RDTSC_STOP(WorkerFoundWork, numWorkItems, pDC->drawId);
+
+        if (budgeted)
+        {
+            pHotTileMgr->UnlockTile(tileID);
+            pHotTileMgr->EvictHotTiles(pContext, pDC);
+        }
+
+        _ReadWriteBarrier();
+
+        pDC->pTileMgr->markTileComplete(tileID);
+        pScheduler->markTileComplete(workerId, tileWork);
+
+        counters.macroTiles++;
+        counters.beTicks += __rdtsc() - tileStart;
     }
 }
 
@@ -601,12 +612,22 @@ void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &c
 
         if (!pDC->isCompute && !pDC->FeLock)
         {
-            uint32_t initial = InterlockedCompareExchange((volatile uint32_t*)&pDC->FeLock, 1, 0);
-            if (initial == 0)
+            uint64_t feStart = __rdtsc();
+            if (pDC->numFeChunks)
             {
-                // successfully grabbed the DC, now run the FE
-                pDC->FeWork.pfnWork(pContext, pDC, workerId, &pDC->FeWork.desc);
+                // chunked draw, help with any chunks left
+                ProcessDrawChunks(pContext, pDC, workerId);
             }
+            else
+            {
+                uint32_t initial = InterlockedCompareExchange((volatile uint32_t*)&pDC->FeLock, 1, 0);
+                if (initial == 0)
+                {
+                    // successfully grabbed the DC, now run the FE
+                    pDC->FeWork.pfnWork(pContext, pDC, workerId, &pDC->FeWork.desc);
+                }
+            }
+            pContext->workerCounters[workerId].feTicks += __rdtsc() - feStart;
         }
         curDraw++;
     }
@@ -647,6 +668,7 @@ void WorkOnCompute(
     if (queue.getNumQueued() > 0)
     {
         bool lastToComplete = false;
+        uint64_t csStart = __rdtsc();
 
         uint32_t threadGroupId = 0;
         while (queue.getWork(threadGroupId))
@@ -656,6 +678,8 @@ void WorkOnCompute(
             lastToComplete = queue.finishedWork();
         }
 
+        pContext->workerCounters[workerId].beTicks += __rdtsc() - csStart;
+
         _ReadWriteBarrier();
 
         if (lastToComplete)
@@ -666,10 +690,83 @@ void WorkOnCompute(
     }
 }
 
+// Shared pool, created by the first context and destroyed with the last one.
+static std::mutex gThreadPoolLock;
+static THREAD_POOL *gpThreadPool = nullptr;
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the context in a pool slot and marks it as referenced by
+///        the worker, or nullptr if the slot is empty.
+INLINE
+SWR_CONTEXT* AcquirePoolContext(THREAD_POOL *pPool, uint32_t slot, uint32_t workerId)
+{
+    SWR_CONTEXT *pContext = pPool->contexts[slot];
+    if (pContext == nullptr)
+    {
+        return nullptr;
+    }
+
+    pPool->workerContext[workerId] = pContext;
+    _mm_mfence();
+
+    // the context may have been unregistered before the reference was visible
+    if (pPool->contexts[slot] != pContext)
+    {
+        pPool->workerContext[workerId] = nullptr;
+        return nullptr;
+    }
+
+    return pContext;
+}
+
+INLINE
+void ReleasePoolContext(THREAD_POOL *pPool, uint32_t workerId)
+{
+    _ReadWriteBarrier();
+    pPool->workerContext[workerId] = nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Maps a pool worker to the context's worker id.
+/// @return false if the worker isn't part of the context's budget.
+INLINE
+bool GetContextWorkerId(THREAD_POOL *pPool, SWR_CONTEXT *pContext, uint32_t workerId, uint32_t &contextWorkerId)
+{
+    contextWorkerId = (workerId + pPool->numThreads - pContext->firstWorker) % pPool->numThreads;
+    return contextWorkerId < pContext->NumWorkerThreads;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns true if any context served by the worker has draws the
+///        worker hasn't moved past.
+bool PoolHasWork(THREAD_POOL *pPool, uint32_t workerId)
+{
+    bool hasWork = false;
+    uint32_t numSlots = pPool->numSlots;
+    for (uint32_t slot = 0; slot < numSlots && !hasWork; ++slot)
+    {
+        SWR_CONTEXT *pContext = AcquirePoolContext(pPool, slot, workerId);
+        if (pContext == nullptr)
+        {
+            continue;
+        }
+
+        uint32_t contextWorkerId;
+        if (GetContextWorkerId(pPool, pContext, workerId, contextWorkerId))
+        {
+            hasWork = pContext->WorkerBE[contextWorkerId] != pContext->DrawEnqueued;
+        }
+
+        ReleasePoolContext(pPool, workerId);
+    }
+
+    return hasWork;
+}
+
 DWORD workerThread(LPVOID pData)
 {
     THREAD_DATA *pThreadData = (THREAD_DATA*)pData;
-    SWR_CONTEXT *pContext = pThreadData->pContext;
+    THREAD_POOL *pPool = pThreadData->pPool;
     uint32_t threadId = pThreadData->threadId;
     uint32_t workerId = pThreadData->workerId;
 
@@ -679,13 +776,11 @@ DWORD workerThread(LPVOID pData)
 
     int numaNode = (int)pThreadData->numaId;
 
+    ArenaBlockCache::SetThreadNumaNode(numaNode);
+
     // flush denormals to 0
     _mm_setcsr(_mm_getcsr() | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
 
-    // Track tiles locked by other threads. If we try to lock a macrotile and find its already
-    // locked then we'll add it to this list so that we don't try and lock it again.
-    std::unordered_set<uint32_t> lockedTiles;
-
     // each worker has the ability to work on any of the queued draws as long as certain
     // conditions are met. the data associated
     // with a draw is guaranteed to be active as long as a worker hasn't signaled that he 
@@ -703,27 +798,32 @@ DWORD workerThread(LPVOID pData)
     //    any work left by comparing the total # of binned work items and the total # of completed
     //    work items. If they are equal, then there is no more work to do for this draw, and
     //    the worker can safely increment its oldestDraw counter and move on to the next draw.
-    std::unique_lock<std::mutex> lock(pContext->WaitLock, std::defer_lock);
-    while (pContext->threadPool.inThreadShutdown == false)
+    // The pool is shared by all contexts. The worker makes one pass over each context it is
+    // budgeted for, starting one context further each time so no context starves the others.
+    // Progress is tracked per context, so each context still retires its draws in order.
+    std::unique_lock<std::mutex> lock(pPool->WaitLock, std::defer_lock);
+    uint32_t firstSlot = 0;
+    while (pPool->inThreadShutdown == false)
     {
+        uint64_t idleStart = __rdtsc();
         uint32_t loop = 0;
-        while (loop++ < KNOB_WORKER_SPIN_LOOP_COUNT && pContext->WorkerBE[workerId] == pContext->DrawEnqueued)
+        while (loop++ < KNOB_WORKER_SPIN_LOOP_COUNT && !PoolHasWork(pPool, workerId))
         {
             _mm_pause();
         }
 
-        if (pContext->WorkerBE[workerId] == pContext->DrawEnqueued)
+        if (!PoolHasWork(pPool, workerId))
         {
             lock.lock();
 
             // check for thread idle condition again under lock
-            if (pContext->WorkerBE[workerId] != pContext->DrawEnqueued)
+            if (PoolHasWork(pPool, workerId))
             {
                 lock.unlock();
                 continue;
             }
 
-            if (pContext->threadPool.inThreadShutdown)
+            if (pPool->inThreadShutdown)
             {
                 lock.unlock();
                 break;
@@ -731,30 +831,58 @@ DWORD workerThread(LPVOID pData)
 
             RDTSC_START(WorkerWaitForThreadEvent);
 
-            pContext->FifosNotEmpty.wait(lock);
+            pPool->FifosNotEmpty.wait(lock);
             lock.unlock();
 
             RDTSC_STOP(WorkerWaitForThreadEvent, 0, 0);
 
-            if (pContext->threadPool.inThreadShutdown)
+            if (pPool->inThreadShutdown)
             {
                 break;
             }
         }
 
-        RDTSC_START(WorkerWorkOnFifoBE);
-        WorkOnFifoBE(pContext, workerId, pContext->WorkerBE[workerId], lockedTiles);
-        RDTSC_STOP(WorkerWorkOnFifoBE, 0, 0);
+        pPool->idleTicks[workerId] += __rdtsc() - idleStart;
+
+        uint32_t numSlots = pPool->numSlots;
+        for (uint32_t i = 0; i < numSlots; ++i)
+        {
+            uint32_t slot = (firstSlot + i) % numSlots;
+            SWR_CONTEXT *pContext = AcquirePoolContext(pPool, slot, workerId);
+            if (pContext == nullptr)
+            {
+                continue;
+            }
+
+            uint32_t contextWorkerId;
+            if (GetContextWorkerId(pPool, pContext, workerId, contextWorkerId))
+            {
+                RDTSC_START(WorkerWorkOnFifoBE);
+                WorkOnFifoBE(pContext, contextWorkerId, pContext->WorkerBE[contextWorkerId]);
+                RDTSC_STOP(WorkerWorkOnFifoBE, 0, 0);
+
+                WorkOnCompute(pContext, contextWorkerId, pContext->WorkerBE[contextWorkerId]);
+
+                WorkOnFifoFE(pContext, contextWorkerId, pContext->WorkerFE[contextWorkerId], numaNode);
+            }
 
-        WorkOnCompute(pContext, workerId, pContext->WorkerBE[workerId]);
+            ReleasePoolContext(pPool, workerId);
+        }
 
-        WorkOnFifoFE(pContext, workerId, pContext->WorkerFE[workerId], numaNode);
+        firstSlot = numSlots ? (firstSlot + 1) % numSlots : 0;
     }
 
+    gArenaBlockCache.FlushThreadCache();
+    FreeVertexCache();
+    HotTileMgr::FreeThreadResolveBuffer();
+
     return 0;
 }
 
-void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Spawns the pool's worker threads over the processor topology.
+/// @return false if there are no HW threads to spare for workers.
+static bool StartWorkerThreads(THREAD_POOL *pPool)
 {
     // Bind application thread to HW thread 0
     bindThread(0);
@@ -813,9 +941,7 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
         }
         else
         {
-            pPool->numThreads = 0;
-            SET_KNOB(SINGLE_THREADED, true);
-            return;
+            return false;
         }
     }
     else
@@ -825,7 +951,6 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
     }
 
     pPool->numThreads = numThreads;
-    pContext->NumWorkerThreads = pPool->numThreads;
 
     pPool->inThreadShutdown = false;
     pPool->pThreadData = (THREAD_DATA *)malloc(pPool->numThreads * sizeof(THREAD_DATA));
@@ -851,34 +976,198 @@ void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
                 pPool->pThreadData[workerId].procGroupId = core.procGroup;
                 pPool->pThreadData[workerId].threadId = core.threadIds[t];
                 pPool->pThreadData[workerId].numaId = n;
-                pPool->pThreadData[workerId].pContext = pContext;
+                pPool->pThreadData[workerId].pPool = pPool;
                 pPool->threads[workerId] = new std::thread(workerThread, &pPool->pThreadData[workerId]);
 
                 ++workerId;
             }
         }
     }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Records the NUMA nodes the context's workers run on. Macrotiles
+///        are partitioned across these nodes only, so every partition has
+///        workers of its own.
+static void AssignContextNumaNodes(THREAD_POOL *pPool, SWR_CONTEXT *pContext)
+{
+    pContext->NumNumaNodes = 1;
+    pContext->numaNodeIds[0] = 0;
+    memset(pContext->workerNumaNode, 0, sizeof(pContext->workerNumaNode));
+
+    if (!KNOB_NUMA_MACROTILES)
+    {
+        return;
+    }
+
+    pContext->NumNumaNodes = 0;
+    for (uint32_t w = 0; w < pContext->NumWorkerThreads; ++w)
+    {
+        uint32_t poolWorker = (pContext->firstWorker + w) % pPool->numThreads;
+        uint32_t numaId = pPool->pThreadData[poolWorker].numaId;
+
+        uint32_t partition = 0;
+        while (partition < pContext->NumNumaNodes && pContext->numaNodeIds[partition] != numaId)
+        {
+            ++partition;
+        }
+
+        if (partition == pContext->NumNumaNodes)
+        {
+            if (partition == KNOB_MAX_NUMA_NODES_PER_CONTEXT)
+            {
+                // Too many nodes, share the last partition.
+                --partition;
+            }
+            else
+            {
+                pContext->numaNodeIds[partition] = numaId;
+                pContext->NumNumaNodes++;
+            }
+        }
+
+        pContext->workerNumaNode[w] = (uint8_t)partition;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Attaches the context to the process-wide thread pool, creating
+///        the pool for the first context. The context isn't worked on until
+///        PublishThreadPoolContext.
+/// @param maxWorkers - worker budget of the context, 0 falls back to
+///        KNOB_MAX_WORKERS_PER_CONTEXT, which 0 leaves unlimited.
+/// @return false if the pool has no free context slot.
+bool CreateThreadPool(SWR_CONTEXT *pContext, uint32_t maxWorkers)
+{
+    std::lock_guard<std::mutex> guard(gThreadPoolLock);
+
+    if (gpThreadPool == nullptr)
+    {
+        void* pPoolMem = _aligned_malloc(sizeof(THREAD_POOL), 64);
+        memset(pPoolMem, 0, sizeof(THREAD_POOL));
+        THREAD_POOL *pPool = new (pPoolMem) THREAD_POOL();
+
+        if (!StartWorkerThreads(pPool))
+        {
+            // no worker threads, render on the API thread
+            pPool->~THREAD_POOL();
+            _aligned_free(pPool);
+            SET_KNOB(SINGLE_THREADED, true);
+            return true;
+        }
+
+        gpThreadPool = pPool;
+    }
+
+    THREAD_POOL *pPool = gpThreadPool;
+
+    uint32_t slot = 0;
+    while (slot < KNOB_MAX_NUM_CONTEXTS && pPool->slotInUse[slot])
+    {
+        ++slot;
+    }
+
+    if (slot == KNOB_MAX_NUM_CONTEXTS)
+    {
+        SWR_ASSERT(0, "More than %u contexts share the thread pool", KNOB_MAX_NUM_CONTEXTS);
+        return false;
+    }
+
+    pPool->slotInUse[slot] = true;
+    if (slot >= pPool->numSlots)
+    {
+        pPool->numSlots = slot + 1;
+    }
+    pPool->refCount++;
+
+    if (maxWorkers == 0)
+    {
+        maxWorkers = KNOB_MAX_WORKERS_PER_CONTEXT;
+    }
+
+    uint32_t numWorkers = pPool->numThreads;
+    if (maxWorkers)
+    {
+        numWorkers = std::min(numWorkers, maxWorkers);
+    }
+
+    pContext->pThreadPool = pPool;
+    pContext->poolSlot = slot;
+    pContext->firstWorker = pPool->nextFirstWorker;
+    pContext->NumWorkerThreads = numWorkers;
+    AssignContextNumaNodes(pPool, pContext);
+
+    pPool->nextFirstWorker = (pPool->nextFirstWorker + numWorkers) % pPool->numThreads;
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Makes a fully initialized context visible to the pool workers.
+void PublishThreadPoolContext(SWR_CONTEXT *pContext)
+{
+    THREAD_POOL *pPool = pContext->pThreadPool;
+    if (pPool == nullptr)
+    {
+        return;
+    }
+
+    _mm_mfence();
+    pPool->contexts[pContext->poolSlot] = pContext;
 }
 
-void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool)
+//////////////////////////////////////////////////////////////////////////
+/// @brief Detaches the context from the pool once no worker references it.
+///        The last context shuts the pool down.
+void DestroyThreadPool(SWR_CONTEXT *pContext)
 {
-    if (!KNOB_SINGLE_THREADED)
+    THREAD_POOL *pPool = pContext->pThreadPool;
+    if (pPool == nullptr)
     {
-        // Inform threads to finish up
-        std::unique_lock<std::mutex> lock(pContext->WaitLock);
-        pPool->inThreadShutdown = true;
-        _mm_mfence();
-        pContext->FifosNotEmpty.notify_all();
-        lock.unlock();
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(gThreadPoolLock);
 
-        // Wait for threads to finish and destroy them
-        for (uint32_t t = 0; t < pPool->numThreads; ++t)
+    pPool->contexts[pContext->poolSlot] = nullptr;
+    _mm_mfence();
+
+    for (uint32_t t = 0; t < pPool->numThreads; ++t)
+    {
+        while (pPool->workerContext[t] == pContext)
         {
-            pPool->threads[t]->join();
-            delete(pPool->threads[t]);
+            _mm_pause();
         }
+    }
+
+    pPool->slotInUse[pContext->poolSlot] = false;
+    pContext->pThreadPool = nullptr;
 
-        // Clean up data used by threads
-        free(pPool->pThreadData);
+    if (--pPool->refCount > 0)
+    {
+        return;
     }
+
+    // Inform threads to finish up
+    std::unique_lock<std::mutex> lock(pPool->WaitLock);
+    pPool->inThreadShutdown = true;
+    _mm_mfence();
+    pPool->FifosNotEmpty.notify_all();
+    lock.unlock();
+
+    // Wait for threads to finish and destroy them
+    for (uint32_t t = 0; t < pPool->numThreads; ++t)
+    {
+        pPool->threads[t]->join();
+        delete(pPool->threads[t]);
+    }
+
+    // Clean up data used by threads
+    free(pPool->pThreadData);
+
+    pPool->~THREAD_POOL();
+    _aligned_free(pPool);
+    gpThreadPool = nullptr;
 }
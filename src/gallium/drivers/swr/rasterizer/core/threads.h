@@ -29,34 +29,63 @@
 
 #include "knobs.h"
 
-#include <unordered_set>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 typedef std::thread* THREAD_PTR;
 
 struct SWR_CONTEXT;
+struct THREAD_POOL;
 
 struct THREAD_DATA
 {
     uint32_t procGroupId;   // Will always be 0 for non-Windows OS
     uint32_t threadId;      // within the procGroup for Windows
     uint32_t numaId;        // NUMA node id
-    uint32_t workerId;
-    SWR_CONTEXT *pContext;
+    uint32_t workerId;      // within the pool, see SWR_CONTEXT::firstWorker for the context's id
+    THREAD_POOL *pPool;
 };
 
-
+//////////////////////////////////////////////////////////////////////////
+/// @brief Worker threads shared by all SWR contexts of the process.
+///        Workers visit the draw rings of the registered contexts round
+///        robin, and each context only accepts its budget of workers.
 struct THREAD_POOL
 {
     THREAD_PTR threads[KNOB_MAX_NUM_THREADS];
     uint32_t numThreads;
     volatile bool inThreadShutdown;
     THREAD_DATA *pThreadData;
+
+    std::condition_variable FifosNotEmpty;
+    std::mutex WaitLock;
+
+    // Number of contexts holding a reference to the pool, guarded by the pool creation lock.
+    uint32_t refCount;
+
+    // First worker handed to the next context, rotated so budgeted contexts
+    // land on different cores.
+    uint32_t nextFirstWorker;
+
+    // Registered contexts. Slots are reserved under the pool creation lock and
+    // a context is published once fully initialized.
+    bool slotInUse[KNOB_MAX_NUM_CONTEXTS];
+    SWR_CONTEXT* volatile contexts[KNOB_MAX_NUM_CONTEXTS];
+    volatile uint32_t numSlots;
+
+    // Context each worker is currently touching. A context being destroyed
+    // waits until no worker references it.
+    SWR_CONTEXT* volatile workerContext[KNOB_MAX_NUM_THREADS];
+
+    // rdtsc ticks each worker spent spinning or sleeping without work.
+    volatile uint64_t idleTicks[KNOB_MAX_NUM_THREADS];
 };
 
-void CreateThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
-void DestroyThreadPool(SWR_CONTEXT *pContext, THREAD_POOL *pPool);
+bool CreateThreadPool(SWR_CONTEXT *pContext, uint32_t maxWorkers);
+void PublishThreadPoolContext(SWR_CONTEXT *pContext);
+void DestroyThreadPool(SWR_CONTEXT *pContext);
 
 // Expose FE and BE worker functions to the API thread if single threaded
 void WorkOnFifoFE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawFE, UCHAR numaNode);
-void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawBE, std::unordered_set<uint32_t> &usedTiles);
+void WorkOnFifoBE(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawBE);
 void WorkOnCompute(SWR_CONTEXT *pContext, uint32_t workerId, volatile uint64_t &curDrawBE);
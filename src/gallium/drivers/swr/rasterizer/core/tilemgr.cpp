@@ -26,7 +26,10 @@
 *        for threads to work on an macro tile.
 *
 ******************************************************************************/
-#include <unordered_map>
+
+#if defined(__linux__) || defined(__gnu_linux__)
+#include <numa.h>
+#endif
 
 #include "fifo.hpp"
 #include "tilemgr.h"
@@ -54,8 +57,55 @@ void DispatchQueue::operator delete(void *p)
     _aligned_free(p);
 }
 
-MacroTileMgr::MacroTileMgr()
+void *MacroTileScheduler::operator new(size_t size)
+{
+    return _aligned_malloc(size, 64);
+}
+
+void MacroTileScheduler::operator delete(void *p)
 {
+    _aligned_free(p);
+}
+
+MacroTileMgr::MacroTileMgr() : mppTiles(nullptr), mTilesX(0), mTilesY(0)
+{
+}
+
+MacroTileMgr::~MacroTileMgr()
+{
+    for (uint32_t i = 0; i < mTilesX * mTilesY; ++i)
+    {
+        if (mppTiles[i] != nullptr)
+        {
+            mppTiles[i]->destroy();
+            delete mppTiles[i];
+        }
+    }
+
+    free(mppTiles);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Grow the tile grid so that it covers tile (x, y). Dimensions at
+///        least double to keep regrowth rare, and are clamped to the hot
+///        tile grid. Only called by the FE thread working on the draw.
+void MacroTileMgr::growTileGrid(uint32_t x, uint32_t y)
+{
+    uint32_t tilesX = std::max(mTilesX, std::min(std::max(x + 1, mTilesX * 2), (uint32_t)KNOB_NUM_HOT_TILES_X));
+    uint32_t tilesY = std::max(mTilesY, std::min(std::max(y + 1, mTilesY * 2), (uint32_t)KNOB_NUM_HOT_TILES_Y));
+
+    MacroTileQueue** ppTiles = (MacroTileQueue**)calloc(tilesX * tilesY, sizeof(MacroTileQueue*));
+    SWR_ASSERT(ppTiles != nullptr);
+
+    for (uint32_t ty = 0; ty < mTilesY; ++ty)
+    {
+        memcpy(&ppTiles[ty * tilesX], &mppTiles[ty * mTilesX], mTilesX * sizeof(MacroTileQueue*));
+    }
+
+    free(mppTiles);
+    mppTiles = ppTiles;
+    mTilesX = tilesX;
+    mTilesY = tilesY;
 }
 
 void MacroTileMgr::initialize()
@@ -74,7 +124,18 @@ void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK *pWork)
 
     uint32_t id = TILE_ID(x, y);
 
-    MacroTileQueue &tile = mTiles[id];
+    if (x >= mTilesX || y >= mTilesY)
+    {
+        growTileGrid(x, y);
+    }
+
+    MacroTileQueue*& pTile = mppTiles[y * mTilesX + x];
+    if (pTile == nullptr)
+    {
+        pTile = new MacroTileQueue();
+    }
+
+    MacroTileQueue &tile = *pTile;
     tile.mWorkItemsFE++;
 
     if (tile.mWorkItemsFE == 1)
@@ -89,8 +150,7 @@ void MacroTileMgr::enqueue(uint32_t x, uint32_t y, BE_WORK *pWork)
 
 void MacroTileMgr::markTileComplete(uint32_t id)
 {
-    SWR_ASSERT(mTiles.find(id) != mTiles.end());
-    MacroTileQueue &tile = mTiles[id];
+    MacroTileQueue &tile = getMacroTileQueue(id);
     uint32_t numTiles = tile.mWorkItemsFE;
     InterlockedExchangeAdd(&mWorkItemsConsumed, numTiles);
 
@@ -103,3 +163,652 @@ void MacroTileMgr::markTileComplete(uint32_t id)
     tile.mWorkItemsFE = 0;
     tile.mWorkItemsBE = 0;
 }
+
+static const uint32_t NUM_MACROTILES = KNOB_NUM_HOT_TILES_X * KNOB_NUM_HOT_TILES_Y;
+static const uint32_t INVALID_WORKER = 0xffffffff;
+
+MacroTileScheduler::MacroTileScheduler(uint32_t numWorkers, uint32_t numNodes, const uint8_t* pWorkerNodes) :
+    mNumWorkers(numWorkers), mNumNodes(numNodes), mNextDrawToPublish(1)
+{
+    mpQueues = new WorkerQueue[numWorkers];
+    for (uint32_t i = 0; i < numWorkers; ++i)
+    {
+        mpQueues[i].steals = 0;
+        mpQueues[i].remoteSteals = 0;
+        mpQueues[i].idleSpins = 0;
+        mpQueues[i].migrations = 0;
+    }
+
+    SWR_ASSERT(numNodes > 0);
+    mWorkerNode.resize(numWorkers);
+    mNodeWorkers.resize(numNodes);
+    for (uint32_t i = 0; i < numWorkers; ++i)
+    {
+        mWorkerNode[i] = pWorkerNodes[i];
+        mNodeWorkers[pWorkerNodes[i]].push_back(i);
+    }
+
+    mpTilePublished = (uint64_t*)_aligned_malloc(NUM_MACROTILES * sizeof(uint64_t), 64);
+    mpTileCompleted = (volatile uint64_t*)_aligned_malloc(NUM_MACROTILES * sizeof(uint64_t), 64);
+    mpTileOwner = (uint32_t*)_aligned_malloc(NUM_MACROTILES * sizeof(uint32_t), 64);
+
+    memset(mpTilePublished, 0, NUM_MACROTILES * sizeof(uint64_t));
+    memset((void*)mpTileCompleted, 0, NUM_MACROTILES * sizeof(uint64_t));
+    memset(mpTileOwner, 0xff, NUM_MACROTILES * sizeof(uint32_t));
+}
+
+MacroTileScheduler::~MacroTileScheduler()
+{
+    delete[] mpQueues;
+
+    _aligned_free(mpTilePublished);
+    _aligned_free((void*)mpTileCompleted);
+    _aligned_free(mpTileOwner);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Publish the dirty macrotiles of draws that are ready for BE work.
+///        Draws are published strictly in order; this stops at the first
+///        draw whose FE isn't done, whose dependency isn't met yet or that
+///        is an unfinished compute dispatch. Only one worker publishes at
+///        a time, others just move on to look for work.
+/// @param curDrawBE - The calling worker's first incomplete draw.
+void MacroTileScheduler::publishDraws(SWR_CONTEXT* pContext, uint64_t curDrawBE)
+{
+    if (!mPublishLock.try_lock())
+    {
+        return;
+    }
+
+    uint64_t lastRetiredDraw = pContext->dcRing[curDrawBE % KNOB_MAX_DRAWS_IN_FLIGHT].drawId - 1;
+
+    // Draws before curDrawBE are complete, and had nothing to publish if we
+    // haven't got to them. Their DCs may already have been recycled.
+    mNextDrawToPublish = std::max(mNextDrawToPublish, (uint64_t)curDrawBE);
+
+    uint64_t drawEnqueued = pContext->DrawEnqueued;
+    while (mNextDrawToPublish < drawEnqueued)
+    {
+        DRAW_CONTEXT* pDC = &pContext->dcRing[mNextDrawToPublish % KNOB_MAX_DRAWS_IN_FLIGHT];
+
+        if (pDC->isCompute)
+        {
+            // BE work of later draws can't start until the dispatch is done.
+            if (!pDC->pDispatch->isWorkComplete()) break;
+        }
+        else
+        {
+            if (!pDC->doneFE) break;
+            if (pDC->dependency > lastRetiredDraw) break;
+
+            for (uint32_t tileID : pDC->pTileMgr->getDirtyTiles())
+            {
+                uint32_t tileIndex = getTileIndex(tileID);
+
+                MacroTileWork work;
+                work.pDC = pDC;
+                work.tileID = tileID;
+                work.prevDrawId = mpTilePublished[tileIndex];
+                mpTilePublished[tileIndex] = pDC->drawId;
+
+                uint32_t owner = mpTileOwner[tileIndex];
+                if (owner == INVALID_WORKER)
+                {
+                    const std::vector<uint32_t>& nodeWorkers = mNodeWorkers[getTileNode(tileID)];
+                    owner = nodeWorkers[(tileIndex / mNumNodes) % nodeWorkers.size()];
+                }
+
+                WorkerQueue& queue = mpQueues[owner];
+                std::lock_guard<std::mutex> guard(queue.lock);
+                queue.work.push_back(work);
+            }
+        }
+
+        mNextDrawToPublish++;
+    }
+
+    mPublishLock.unlock();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Remove the oldest ready work item from a worker's deque.
+bool MacroTileScheduler::takeReadyWork(uint32_t queueId, MacroTileWork& work)
+{
+    WorkerQueue& queue = mpQueues[queueId];
+    std::lock_guard<std::mutex> guard(queue.lock);
+
+    for (auto it = queue.work.begin(); it != queue.work.end(); ++it)
+    {
+        if (isReady(*it))
+        {
+            work = *it;
+            queue.work.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Steal ready work from the workers on the same or on other NUMA
+///        nodes than the thief.
+bool MacroTileScheduler::stealWork(uint32_t workerId, bool sameNode, MacroTileWork& work)
+{
+    uint32_t node = mWorkerNode[workerId];
+
+    for (uint32_t i = 1; i < mNumWorkers; ++i)
+    {
+        uint32_t victim = (workerId + i) % mNumWorkers;
+        if ((mWorkerNode[victim] == node) != sameNode)
+        {
+            continue;
+        }
+
+        if (takeReadyWork(victim, work))
+        {
+            mpQueues[workerId].steals++;
+            if (!sameNode)
+            {
+                mpQueues[workerId].remoteSteals++;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Get the next macrotile to work on. Tries the worker's own deque,
+///        then steals from workers on the same NUMA node and finally from
+///        workers on other nodes.
+/// @param workerId - The worker asking for work.
+/// @param work - Returns the macrotile work.
+bool MacroTileScheduler::getWork(uint32_t workerId, MacroTileWork& work)
+{
+    if (takeReadyWork(workerId, work))
+    {
+        return true;
+    }
+
+    if (stealWork(workerId, true, work))
+    {
+        return true;
+    }
+
+    if (mNumNodes > 1 && stealWork(workerId, false, work))
+    {
+        return true;
+    }
+
+    mpQueues[workerId].idleSpins++;
+    return false;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Called once all of the work for a macrotile has been done.
+///        Releases work on the same tile in the following draws.
+void MacroTileScheduler::markTileComplete(uint32_t workerId, const MacroTileWork& work)
+{
+    uint32_t tileIndex = getTileIndex(work.tileID);
+
+    // Tiles stolen across nodes stay owned by their node.
+    uint32_t prevOwner = mpTileOwner[tileIndex];
+    if (prevOwner != workerId && mWorkerNode[workerId] == getTileNode(work.tileID))
+    {
+        if (prevOwner != INVALID_WORKER)
+        {
+            mpQueues[workerId].migrations++;
+        }
+        mpTileOwner[tileIndex] = workerId;
+    }
+
+    // Make sure all tile writes are done before the next draw can see the tile.
+    _ReadWriteBarrier();
+    mpTileCompleted[tileIndex] = work.pDC->drawId;
+}
+
+void MacroTileScheduler::getStats(SWR_SCHEDULER_STATS& stats)
+{
+    memset(&stats, 0, sizeof(stats));
+
+    for (uint32_t i = 0; i < mNumWorkers; ++i)
+    {
+        stats.Steals += mpQueues[i].steals;
+        stats.RemoteSteals += mpQueues[i].remoteSteals;
+        stats.IdleSpins += mpQueues[i].idleSpins;
+        stats.TileMigrations += mpQueues[i].migrations;
+    }
+}
+
+HotTileMgr::HotTileMgr(uint32_t numNodes, const uint32_t* pNodeIds)
+{
+    memset(&mHotTiles[0][0], 0, sizeof(mHotTiles));
+    memset((void*)&mTileLocks[0][0], 0, sizeof(mTileLocks));
+    mBudgetBytes = uint64_t(KNOB_HOT_TILE_BUDGET_MB) * 1024 * 1024;
+    mBytesAllocated = 0;
+    mEvictLock = 0;
+    mEvictHand = 0;
+    mTilesUsedX = 0;
+    mTilesUsedY = 0;
+
+    SWR_ASSERT(numNodes > 0 && numNodes <= KNOB_MAX_NUMA_NODES_PER_CONTEXT);
+    mNumNodes = numNodes;
+    memcpy(mNodeIds, pNodeIds, numNodes * sizeof(uint32_t));
+
+#if defined(_WIN32)
+    mNumaAlloc = (numNodes > 1);
+#elif defined(__linux__) || defined(__gnu_linux__)
+    mNumaAlloc = (numNodes > 1) && (numa_available() != -1);
+#else
+    mNumaAlloc = false;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Raises value to at least newValue. Racing callers only ever grow it.
+static void InterlockedMax(volatile uint32_t& value, uint32_t newValue)
+{
+    uint32_t curValue = value;
+    while (curValue < newValue)
+    {
+        uint32_t prevValue = InterlockedCompareExchange(&value, newValue, curValue);
+        if (prevValue == curValue)
+        {
+            break;
+        }
+        curValue = prevValue;
+    }
+}
+
+void HotTileMgr::AllocHotTileBuffer(HOTTILE& hotTile, uint32_t size, uint32_t x, uint32_t y)
+{
+    InterlockedMax(mTilesUsedX, x + 1);
+    InterlockedMax(mTilesUsedY, y + 1);
+
+    if (mNumaAlloc)
+    {
+        // Page aligned, node local memory.
+        uint32_t node = mNodeIds[GetMacroTileNumaNode(x, y, mNumNodes)];
+#if defined(_WIN32)
+        hotTile.pBuffer = (BYTE*)VirtualAllocExNuma(GetCurrentProcess(), NULL, size,
+            MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+#elif defined(__linux__) || defined(__gnu_linux__)
+        hotTile.pBuffer = (BYTE*)numa_alloc_onnode(size, node);
+#endif
+    }
+    else
+    {
+        hotTile.pBuffer = (BYTE*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
+    }
+    SWR_ASSERT(hotTile.pBuffer != NULL);
+
+    hotTile.bufferSize = size;
+    InterlockedExchangeAdd64(&mBytesAllocated, size);
+}
+
+void HotTileMgr::FreeHotTileBuffer(HOTTILE& hotTile)
+{
+    if (mNumaAlloc)
+    {
+#if defined(_WIN32)
+        VirtualFree(hotTile.pBuffer, 0, MEM_RELEASE);
+#elif defined(__linux__) || defined(__gnu_linux__)
+        numa_free(hotTile.pBuffer, hotTile.bufferSize);
+#endif
+    }
+    else
+    {
+        _aligned_free(hotTile.pBuffer);
+    }
+
+    hotTile.pBuffer = NULL;
+    InterlockedExchangeAdd64(&mBytesAllocated, -(int64_t)hotTile.bufferSize);
+    hotTile.bufferSize = 0;
+}
+
+// Per thread scratch space for resolving multisampled hot tiles before they are stored.
+static THREAD uint8_t* gt_pResolveBuffer = nullptr;
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Averages the samples of a 32bpc float color hot tile.
+static void ResolveSamplesFloat32(const uint8_t* pSrc, uint8_t* pDst, uint32_t rasterTileBytes, uint32_t numSamples)
+{
+    const simdscalar vScale = _simd_set1_ps(1.0f / numSamples);
+
+    for (uint32_t t = 0; t < NUM_RASTER_TILES; ++t)
+    {
+        const uint8_t* pSrcTile = pSrc + t * numSamples * rasterTileBytes;
+        uint8_t* pDstTile = pDst + t * rasterTileBytes;
+
+        for (uint32_t i = 0; i < rasterTileBytes; i += sizeof(simdscalar))
+        {
+            simdscalar vSum = _simd_load_ps((const float*)(pSrcTile + i));
+            for (uint32_t s = 1; s < numSamples; ++s)
+            {
+                vSum = _simd_add_ps(vSum, _simd_load_ps((const float*)(pSrcTile + s * rasterTileBytes + i)));
+            }
+            _simd_store_ps((float*)(pDstTile + i), _simd_mul_ps(vSum, vScale));
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Averages the samples of a 16bpc float color hot tile.
+static void ResolveSamplesFloat16(const uint8_t* pSrc, uint8_t* pDst, uint32_t rasterTileBytes, uint32_t numSamples)
+{
+    typedef TypeTraits<SWR_TYPE_FLOAT, 16> Float16;
+    const simdscalar vScale = _simd_set1_ps(1.0f / numSamples);
+
+    for (uint32_t t = 0; t < NUM_RASTER_TILES; ++t)
+    {
+        const uint8_t* pSrcTile = pSrc + t * numSamples * rasterTileBytes;
+        uint8_t* pDstTile = pDst + t * rasterTileBytes;
+
+        // KNOB_SIMD_WIDTH halfs at a time
+        for (uint32_t i = 0; i < rasterTileBytes; i += sizeof(__m128))
+        {
+            simdscalar vSum = _simd_setzero_ps();
+            for (uint32_t s = 0; s < numSamples; ++s)
+            {
+                simdscalar vSample = _mm256_castps128_ps256(_mm_load_ps((const float*)(pSrcTile + s * rasterTileBytes + i)));
+                vSum = _simd_add_ps(vSum, Float16::unpack(vSample));
+            }
+            simdscalar vResult = Float16::pack(_simd_mul_ps(vSum, vScale));
+            _mm_store_ps((float*)(pDstTile + i), _mm256_castps256_ps128(vResult));
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Averages the samples of an 8bpc unorm color hot tile, rounding
+///        to nearest. numSamples must be a power of 2 no larger than 16
+///        so the sums fit in 16 bits.
+static void ResolveSamplesUnorm8(const uint8_t* pSrc, uint8_t* pDst, uint32_t rasterTileBytes, uint32_t numSamples)
+{
+    DWORD shift;
+    _BitScanForward(&shift, numSamples);
+    const __m128i vShift = _mm_cvtsi32_si128(shift);
+    const __m128i vRound = _mm_set1_epi16((short)(numSamples >> 1));
+
+    for (uint32_t t = 0; t < NUM_RASTER_TILES; ++t)
+    {
+        const uint8_t* pSrcTile = pSrc + t * numSamples * rasterTileBytes;
+        uint8_t* pDstTile = pDst + t * rasterTileBytes;
+
+        for (uint32_t i = 0; i < rasterTileBytes; i += sizeof(__m128i))
+        {
+            __m128i vSumLo = vRound;
+            __m128i vSumHi = vRound;
+            for (uint32_t s = 0; s < numSamples; ++s)
+            {
+                __m128i vSample = _mm_load_si128((const __m128i*)(pSrcTile + s * rasterTileBytes + i));
+                vSumLo = _mm_add_epi16(vSumLo, _mm_cvtepu8_epi16(vSample));
+                vSumHi = _mm_add_epi16(vSumHi, _mm_cvtepu8_epi16(_mm_srli_si128(vSample, 8)));
+            }
+            vSumLo = _mm_srl_epi16(vSumLo, vShift);
+            vSumHi = _mm_srl_epi16(vSumHi, vShift);
+            _mm_store_si128((__m128i*)(pDstTile + i), _mm_packus_epi16(vSumLo, vSumHi));
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Copies sample 0 of every raster tile.
+static void ResolveSamplesFirst(const uint8_t* pSrc, uint8_t* pDst, uint32_t rasterTileBytes, uint32_t numSamples)
+{
+    for (uint32_t t = 0; t < NUM_RASTER_TILES; ++t)
+    {
+        memcpy(pDst + t * rasterTileBytes, pSrc + t * numSamples * rasterTileBytes, rasterTileBytes);
+    }
+}
+
+void HotTileMgr::FreeThreadResolveBuffer()
+{
+    _aligned_free(gt_pResolveBuffer);
+    gt_pResolveBuffer = nullptr;
+}
+
+void HotTileMgr::StoreHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, SWR_RENDERTARGET_ATTACHMENT attachment,
+    uint32_t x, uint32_t y, HOTTILE* pHotTile)
+{
+    uint8_t* pBuffer = pHotTile->pBuffer;
+
+    if (pHotTile->numSamples > 1)
+    {
+        if (gt_pResolveBuffer == nullptr)
+        {
+            gt_pResolveBuffer = (uint8_t*)_aligned_malloc(GetHotTileSize(KNOB_COLOR_HOT_TILE_FORMAT), 64);
+        }
+
+        uint32_t rasterTileBytes = GetHotTileSize(pHotTile->format) / NUM_RASTER_TILES;
+        switch (pHotTile->format)
+        {
+        case KNOB_COLOR_HOT_TILE_FORMAT:
+            ResolveSamplesFloat32(pBuffer, gt_pResolveBuffer, rasterTileBytes, pHotTile->numSamples);
+            break;
+        case KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16:
+            ResolveSamplesFloat16(pBuffer, gt_pResolveBuffer, rasterTileBytes, pHotTile->numSamples);
+            break;
+        case KNOB_COLOR_HOT_TILE_FORMAT_UNORM8:
+            ResolveSamplesUnorm8(pBuffer, gt_pResolveBuffer, rasterTileBytes, pHotTile->numSamples);
+            break;
+        default:
+            ResolveSamplesFirst(pBuffer, gt_pResolveBuffer, rasterTileBytes, pHotTile->numSamples);
+            break;
+        }
+        pBuffer = gt_pResolveBuffer;
+    }
+
+    pContext->pfnStoreTile(GetPrivateState(pDC), pHotTile->format, attachment,
+        x, y, pHotTile->renderTargetArrayIndex, pBuffer);
+
+    InterlockedExchangeAdd64(&pContext->hotTileStores, 1);
+}
+
+void HotTileMgr::LoadHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, SWR_RENDERTARGET_ATTACHMENT attachment,
+    uint32_t x, uint32_t y, HOTTILE* pHotTile)
+{
+    pContext->pfnLoadTile(GetPrivateState(pDC), pHotTile->format, attachment,
+        x, y, pHotTile->renderTargetArrayIndex, pHotTile->pBuffer);
+
+    InterlockedExchangeAdd64(&pContext->hotTileLoads, 1);
+
+    uint32_t numSamples = pHotTile->numSamples;
+    if (numSamples > 1)
+    {
+        // spread the single sample tile in place, back to front so nothing is overwritten before it is read
+        uint32_t rasterTileBytes = GetHotTileSize(pHotTile->format) / NUM_RASTER_TILES;
+        for (uint32_t t = NUM_RASTER_TILES; t-- > 0;)
+        {
+            const uint8_t* pSrc = pHotTile->pBuffer + t * rasterTileBytes;
+            for (uint32_t s = numSamples; s-- > 0;)
+            {
+                uint8_t* pDst = pHotTile->pBuffer + (t * numSamples + s) * rasterTileBytes;
+                if (pDst != pSrc)
+                {
+                    memcpy(pDst, pSrc, rasterTileBytes);
+                }
+            }
+        }
+    }
+
+    if (pHotTile->pHiZ != nullptr)
+    {
+        UpdateHiZ(pHotTile);
+    }
+}
+
+HOTTILE& HotTileMgr::GetLayerHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t x, uint32_t y,
+    SWR_RENDERTARGET_ATTACHMENT attachment, HOTTILE& firstLayer, uint32_t renderTargetArrayIndex, bool& switched)
+{
+    HOTTILE* pFree = NULL;
+    HOTTILE* pLeastRecent = NULL;
+    uint32_t numLayers = 0;
+
+    for (HOTTILE* pLayer = &firstLayer; pLayer != NULL; pLayer = pLayer->pNextLayer)
+    {
+        if (pLayer->pBuffer == NULL)
+        {
+            pFree = pFree ? pFree : pLayer;
+        }
+        else if (pLayer->renderTargetArrayIndex == renderTargetArrayIndex)
+        {
+            return *pLayer;
+        }
+        else if (pLeastRecent == NULL || pLayer->lastUse < pLeastRecent->lastUse)
+        {
+            pLeastRecent = pLayer;
+        }
+        numLayers++;
+    }
+
+    // slice isn't resident, use a hot tile without buffer, then a new one
+    if (pFree != NULL)
+    {
+        return *pFree;
+    }
+
+    if (numLayers < KNOB_HOT_TILE_LAYERS)
+    {
+        HOTTILE* pLayer = new HOTTILE();
+        pLayer->pNextLayer = firstLayer.pNextLayer;
+        firstLayer.pNextLayer = pLayer;
+
+        InterlockedExchangeAdd64(&pContext->hotTileLayerAllocs, 1);
+        return *pLayer;
+    }
+
+    // every slot holds a slice, swap out the least recently used one
+    if (pLeastRecent->state == HOTTILE_DIRTY)
+    {
+        StoreHotTile(pContext, pDC, attachment, x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, pLeastRecent);
+    }
+
+    pLeastRecent->renderTargetArrayIndex = renderTargetArrayIndex;
+    pLeastRecent->state = HOTTILE_INVALID;
+    switched = true;
+
+    InterlockedExchangeAdd64(&pContext->hotTileLayerReloads, 1);
+    return *pLeastRecent;
+}
+
+void HotTileMgr::UpdateHiZ(HOTTILE* pHotTile)
+{
+    static_assert(KNOB_DEPTH_HOT_TILE_FORMAT == R32_FLOAT, "Unsupported depth hot tile format");
+    SWR_ASSERT(pHotTile->pHiZ != nullptr);
+
+    // every sample of a raster tile is contiguous, so the bounds cover one block of numSamples raster tiles
+    const uint32_t numValues = KNOB_TILE_X_DIM * KNOB_TILE_Y_DIM * pHotTile->numSamples;
+    const float* pDepth = (const float*)pHotTile->pBuffer;
+
+    for (uint32_t t = 0; t < NUM_RASTER_TILES; ++t)
+    {
+        // NaN depth never passes an ordered depth test, keep it out of the bounds
+        simdscalar vMin = _simd_set1_ps(FLT_MAX);
+        simdscalar vMax = _simd_set1_ps(-FLT_MAX);
+        for (uint32_t i = 0; i < numValues; i += KNOB_SIMD_WIDTH)
+        {
+            simdscalar vZ = _simd_load_ps(pDepth + i);
+            vMin = _simd_min_ps(vZ, vMin);
+            vMax = _simd_max_ps(vZ, vMax);
+        }
+        pDepth += numValues;
+
+        OSALIGNSIMD(float) zMin[KNOB_SIMD_WIDTH];
+        OSALIGNSIMD(float) zMax[KNOB_SIMD_WIDTH];
+        _simd_store_ps(zMin, vMin);
+        _simd_store_ps(zMax, vMax);
+
+        HIZ_TILE& hiZ = pHotTile->pHiZ[t];
+        hiZ.zMin = zMin[0];
+        hiZ.zMax = zMax[0];
+        for (uint32_t i = 1; i < KNOB_SIMD_WIDTH; ++i)
+        {
+            hiZ.zMin = std::min(hiZ.zMin, zMin[i]);
+            hiZ.zMax = std::max(hiZ.zMax, zMax[i]);
+        }
+    }
+}
+
+void HotTileMgr::EvictHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC)
+{
+    // Bounds the work a single call does, the clock resumes where it stopped next time.
+    static const uint32_t MaxTilesVisited = 256;
+
+    if (mBytesAllocated <= (int64_t)mBudgetBytes)
+    {
+        return;
+    }
+
+    // one evicting worker at a time, the others keep rendering
+    if (InterlockedCompareExchange(&mEvictLock, 1, 0) != 0)
+    {
+        return;
+    }
+
+    // Clock approximation of LRU: tiles used since the hand last passed get
+    // a second chance, the others are freed if they can be reloaded. Only
+    // pDC's private state is known to describe the surface of a dirty tile,
+    // so dirty tiles other draws used last stay resident.
+    // The clock sweeps the macrotiles render targets have covered rather than
+    // every hot tile slot. The area only grows, which just moves the hand.
+    uint32_t tilesX = mTilesUsedX;
+    uint32_t numMacroTiles = tilesX * mTilesUsedY;
+    for (uint32_t i = 0; i < MaxTilesVisited && mBytesAllocated > (int64_t)mBudgetBytes; ++i)
+    {
+        mEvictHand = (mEvictHand < numMacroTiles) ? mEvictHand : 0;
+        uint32_t x = mEvictHand % tilesX;
+        uint32_t y = mEvictHand / tilesX;
+        mEvictHand++;
+
+        HotTileSet &tile = mHotTiles[x][y];
+
+        bool allocated = false;
+        for (uint32_t a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
+        {
+            allocated |= (tile.Attachment[a].pBuffer != NULL) || (tile.Attachment[a].pNextLayer != NULL);
+        }
+
+        // skip tiles a worker is on
+        if (!allocated || InterlockedCompareExchange(&mTileLocks[x][y], 1, 0) != 0)
+        {
+            continue;
+        }
+
+        for (uint32_t a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
+        {
+            for (HOTTILE* pHotTile = &tile.Attachment[a]; pHotTile != NULL; pHotTile = pHotTile->pNextLayer)
+            {
+                if (pHotTile->pBuffer == NULL)
+                {
+                    continue;
+                }
+
+                if (pHotTile->referenced)
+                {
+                    pHotTile->referenced = false;
+                }
+                else if (pHotTile->state == HOTTILE_INVALID || pHotTile->state == HOTTILE_RESOLVED)
+                {
+                    ReleaseHotTile(*pHotTile);
+                }
+                else if (pHotTile->state == HOTTILE_DIRTY && pHotTile->numSamples == 1 &&
+                         StoresLosslessly(pHotTile->format) && pHotTile->lastUseDraw == pDC->drawId)
+                {
+                    StoreHotTile(pContext, pDC, (SWR_RENDERTARGET_ATTACHMENT)a,
+                        x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, pHotTile);
+                    pHotTile->state = HOTTILE_RESOLVED;
+                    ReleaseHotTile(*pHotTile);
+                }
+            }
+        }
+
+        _ReadWriteBarrier();
+        mTileLocks[x][y] = 0;
+    }
+
+    _ReadWriteBarrier();
+    mEvictLock = 0;
+}
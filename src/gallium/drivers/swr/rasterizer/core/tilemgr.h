@@ -29,7 +29,10 @@
 #pragma once
 
 #include <set>
-#include <unordered_map>
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <cfloat>
 #include "common/formats.h"
 #include "fifo.hpp"
 #include "context.h"
@@ -104,22 +107,25 @@ private:
 
 //////////////////////////////////////////////////////////////////////////
 /// MacroTileMgr - Manages macrotiles for a draw.
+///   Tile queues live in a dense grid of pointers indexed by tile x/y. The
+///   grid grows on demand to cover the largest tile touched so far, and a
+///   tile's queue is only allocated the first time work is queued to it.
 //////////////////////////////////////////////////////////////////////////
 class MacroTileMgr
 {
 public:
     MacroTileMgr();
-    ~MacroTileMgr()
-    {
-        for (auto &tile : mTiles)
-        {
-            tile.second.destroy();
-        }
-    }
+    ~MacroTileMgr();
 
     void initialize();
     INLINE std::vector<uint32_t>& getDirtyTiles() { return mDirtyTiles; }
-    INLINE MacroTileQueue& getMacroTileQueue(uint32_t id) { return mTiles[id]; }
+    INLINE MacroTileQueue& getMacroTileQueue(uint32_t id)
+    {
+        uint32_t x, y;
+        getTileIndices(id, x, y);
+        SWR_ASSERT(x < mTilesX && y < mTilesY);
+        return *mppTiles[y * mTilesX + x];
+    }
     void markTileComplete(uint32_t id);
 
     INLINE bool isWorkComplete()
@@ -139,8 +145,13 @@ public:
     void operator delete (void *p);
 
 private:
+    void growTileGrid(uint32_t x, uint32_t y);
+
     SWR_FORMAT mFormat;
-    std::unordered_map<uint32_t, MacroTileQueue> mTiles;
+
+    MacroTileQueue** mppTiles;
+    uint32_t mTilesX;
+    uint32_t mTilesY;
 
     // Any tile that has work queued to it is a dirty tile.
     std::vector<uint32_t> mDirtyTiles;
@@ -149,6 +160,103 @@ private:
     OSALIGNLINE(volatile LONG) mWorkItemsConsumed;
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the NUMA partition owning a macrotile. Macrotiles are
+///        interleaved across partitions along diagonals so every node gets
+///        an even share of any region of the screen.
+/// @param x, y - macrotile indices
+/// @param numNodes - SWR_CONTEXT::NumNumaNodes
+INLINE uint32_t GetMacroTileNumaNode(uint32_t x, uint32_t y, uint32_t numNodes)
+{
+    return (x + y) % numNodes;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// MacroTileWork - all of the BE work queued to one macrotile by a draw.
+//////////////////////////////////////////////////////////////////////////
+struct MacroTileWork
+{
+    DRAW_CONTEXT* pDC;
+    uint32_t tileID;
+    uint64_t prevDrawId;    // Previous draw with work on this tile, 0 if none.
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// MacroTileScheduler - Schedules macrotile work across BE workers.
+///   Once a draw's FE is done its dirty macrotiles are published, in draw
+///   order, to per-worker deques. A tile goes to the worker of the tile's
+///   NUMA node that last worked on it so hot tiles stay in that worker's
+///   cache. Workers take work from their own deque first, then steal from
+///   workers of their node and only then from other nodes.
+///   Work for a tile is only handed out after the previous draw's work for
+///   that tile has completed, which keeps per-tile draw ordering.
+//////////////////////////////////////////////////////////////////////////
+class MacroTileScheduler
+{
+public:
+    MacroTileScheduler(uint32_t numWorkers, uint32_t numNodes, const uint8_t* pWorkerNodes);
+    ~MacroTileScheduler();
+
+    void publishDraws(SWR_CONTEXT* pContext, uint64_t curDrawBE);
+    bool getWork(uint32_t workerId, MacroTileWork& work);
+    void markTileComplete(uint32_t workerId, const MacroTileWork& work);
+    void getStats(SWR_SCHEDULER_STATS& stats);
+
+    void *operator new(size_t size);
+    void operator delete (void *p);
+
+private:
+    static INLINE uint32_t getTileIndex(uint32_t tileID)
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(tileID, x, y);
+        return y * KNOB_NUM_HOT_TILES_X + x;
+    }
+
+    INLINE uint32_t getTileNode(uint32_t tileID)
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(tileID, x, y);
+        return GetMacroTileNumaNode(x, y, mNumNodes);
+    }
+
+    INLINE bool isReady(const MacroTileWork& work)
+    {
+        return mpTileCompleted[getTileIndex(work.tileID)] >= work.prevDrawId;
+    }
+
+    bool takeReadyWork(uint32_t queueId, MacroTileWork& work);
+    bool stealWork(uint32_t workerId, bool sameNode, MacroTileWork& work);
+
+    struct WorkerQueue
+    {
+        OSALIGNLINE(std::mutex) lock;
+        std::deque<MacroTileWork> work;
+
+        // Only written by the worker owning this queue.
+        uint64_t steals;
+        uint64_t remoteSteals;
+        uint64_t idleSpins;
+        uint64_t migrations;
+    };
+
+    uint32_t mNumWorkers;
+    WorkerQueue* mpQueues;
+
+    // NUMA partition of each worker and the workers of each partition.
+    uint32_t mNumNodes;
+    std::vector<uint32_t> mWorkerNode;
+    std::vector<std::vector<uint32_t>> mNodeWorkers;
+
+    std::mutex mPublishLock;
+    uint64_t mNextDrawToPublish;
+
+    // Per macrotile state, indexed by getTileIndex().
+    uint64_t* mpTilePublished;              // Last draw published with work on the tile. Publisher only.
+    volatile uint64_t* mpTileCompleted;     // Last draw whose work on the tile completed.
+    uint32_t* mpTileOwner;                  // Worker that last completed work on the tile.
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// DispatchQueue - work queue for dispatch
 //////////////////////////////////////////////////////////////////////////
@@ -246,11 +354,23 @@ struct HOTTILE
 {
     BYTE *pBuffer;
     HOTTILE_STATE state;
+    SWR_FORMAT format;                  // format of pBuffer, color hot tile formats are chosen per render target
     DWORD clearData[4];                 // May need to change based on pfnClearTile implementation.  Reorder for alignment?
     uint32_t numSamples;
     uint32_t renderTargetArrayIndex;    // current render target array index loaded
+    HIZ_TILE *pHiZ;                     // per raster tile depth bounds, depth hot tile only
+    uint32_t bufferSize;                // bytes allocated for pBuffer, may exceed the current sample count
+    bool referenced;                    // used since the eviction clock last passed, see EvictHotTiles
+    uint64_t lastUseDraw;               // last draw that used the tile
+    uint64_t lastUse;                   // orders uses of the macrotile's slices, picks the slice to replace
+    HOTTILE *pNextLayer;                // hot tile of another array slice in the same macrotile
 };
 
+// Number of raster tiles in a macrotile. Each raster tile of a multisampled hot tile holds
+// all of its samples back to back, one raster tile sized block per sample.
+static const uint32_t NUM_RASTER_TILES =
+    (KNOB_MACROTILE_X_DIM / KNOB_TILE_X_DIM) * (KNOB_MACROTILE_Y_DIM / KNOB_TILE_Y_DIM);
+
 union HotTileSet
 {
     struct
@@ -265,18 +385,10 @@ union HotTileSet
 class HotTileMgr
 {
 public:
-    HotTileMgr()
-    {
-        memset(&mHotTiles[0][0], 0, sizeof(mHotTiles));
-
-        // cache hottile size
-        for (uint32_t i = SWR_ATTACHMENT_COLOR0; i <= SWR_ATTACHMENT_COLOR7; ++i)
-        {
-            mHotTileSize[i] = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * FormatTraits<KNOB_COLOR_HOT_TILE_FORMAT>::bpp / 8;
-        }
-        mHotTileSize[SWR_ATTACHMENT_DEPTH] = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * FormatTraits<KNOB_DEPTH_HOT_TILE_FORMAT>::bpp / 8;
-        mHotTileSize[SWR_ATTACHMENT_STENCIL] = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * FormatTraits<KNOB_STENCIL_HOT_TILE_FORMAT>::bpp / 8;
-    }
+    //////////////////////////////////////////////////////////////////////////
+    /// @param numNodes - number of NUMA partitions of the macrotiles
+    /// @param pNodeIds - OS NUMA node id of each partition
+    HotTileMgr(uint32_t numNodes, const uint32_t* pNodeIds);
 
     ~HotTileMgr()
     {
@@ -286,16 +398,31 @@ public:
             {
                 for (int a = 0; a < SWR_NUM_ATTACHMENTS; ++a)
                 {
-                    if (mHotTiles[x][y].Attachment[a].pBuffer != NULL)
+                    HOTTILE& firstLayer = mHotTiles[x][y].Attachment[a];
+                    ReleaseHotTile(firstLayer);
+
+                    HOTTILE* pLayer = firstLayer.pNextLayer;
+                    while (pLayer != NULL)
                     {
-                        _aligned_free(mHotTiles[x][y].Attachment[a].pBuffer);
-                        mHotTiles[x][y].Attachment[a].pBuffer = NULL;
+                        HOTTILE* pNext = pLayer->pNextLayer;
+                        ReleaseHotTile(*pLayer);
+                        delete pLayer;
+                        pLayer = pNext;
                     }
                 }
             }
         }
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Returns the hot tile of an attachment's array slice in a
+    ///        macrotile. Each macrotile keeps up to KNOB_HOT_TILE_LAYERS
+    ///        slices resident, so layered rendering only stores and reloads
+    ///        a slice when more slices are in use than that.
+    ///        Without create the first slice's hot tile is returned, walk
+    ///        pNextLayer for the others; slices may have no buffer.
+    /// @note Slice 0 is prepared by InitializeHotTiles, other slices are
+    ///       loaded from the surface when first touched.
     HOTTILE *GetHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t macroID, SWR_RENDERTARGET_ATTACHMENT attachment, bool create, uint32_t numSamples = 1, 
         uint32_t renderTargetArrayIndex = 0)
     {
@@ -306,75 +433,208 @@ public:
         assert(y < KNOB_NUM_HOT_TILES_Y);
 
         HotTileSet &tile = mHotTiles[x][y];
-        HOTTILE& hotTile = tile.Attachment[attachment];
+        HOTTILE& firstLayer = tile.Attachment[attachment];
+
+        if (!create)
+        {
+            return (firstLayer.pBuffer != NULL || firstLayer.pNextLayer != NULL) ? &firstLayer : NULL;
+        }
+
+        // color hot tile format is selected per render target by the driver
+        SWR_FORMAT format = GetHotTileFormat(attachment);
+        if (attachment <= SWR_ATTACHMENT_COLOR7)
+        {
+            format = GetApiState(pDC).backendState.colorHotTileFormat[attachment];
+        }
+
+        bool layerSwitched = false;
+        HOTTILE& hotTile = GetLayerHotTile(pContext, pDC, x, y, attachment, firstLayer, renderTargetArrayIndex, layerSwitched);
+
         if (hotTile.pBuffer == NULL)
         {
-            if (create)
-            {
-                uint32_t size = numSamples * mHotTileSize[attachment];
-                hotTile.pBuffer = (BYTE*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
-                hotTile.state = HOTTILE_INVALID;
-                hotTile.numSamples = numSamples;
-                hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
-            }
-            else
+            AllocHotTileBuffer(hotTile, numSamples * GetHotTileSize(format), x, y);
+            hotTile.state = HOTTILE_INVALID;
+            hotTile.format = format;
+            hotTile.numSamples = numSamples;
+            hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
+            if (attachment == SWR_ATTACHMENT_DEPTH)
             {
-                return NULL;
+                hotTile.pHiZ = (HIZ_TILE*)_aligned_malloc(NUM_RASTER_TILES * sizeof(HIZ_TILE), 64);
+                ResetHiZ(&hotTile, -FLT_MAX, FLT_MAX);
             }
         }
         else
         {
-            // free the old tile and create a new one with enough space to hold all samples
-            if (numSamples > hotTile.numSamples)
+            // render target moved to a different hot tile format, flush any rendering in the
+            // old format and reallocate. Pending clears are kept since the clear color is
+            // stored independently of the hot tile format.
+            if (format != hotTile.format)
+            {
+                if (hotTile.state == HOTTILE_DIRTY)
+                {
+                    StoreHotTile(pContext, pDC, attachment, x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, &hotTile);
+                }
+
+                FreeHotTileBuffer(hotTile);
+
+                hotTile.numSamples = numSamples;
+                AllocHotTileBuffer(hotTile, hotTile.numSamples * GetHotTileSize(format), x, y);
+                hotTile.format = format;
+                if (hotTile.state != HOTTILE_CLEAR)
+                {
+                    hotTile.state = HOTTILE_INVALID;
+                }
+            }
+
+            // switching to a new sample count, the sample layout of the tile changes so it has
+            // to be reloaded. Only grow the allocation if the tile needs space for more samples.
+            if (numSamples != hotTile.numSamples)
             {
-                // tile should be either uninitialized or resolved if we're deleting and switching to a 
+                // tile should be either uninitialized or resolved if we're switching to a 
                 // new sample count
                 assert((hotTile.state == HOTTILE_INVALID) ||
                        (hotTile.state == HOTTILE_RESOLVED));
-                _aligned_free(hotTile.pBuffer);
+                if (numSamples > hotTile.numSamples)
+                {
+                    FreeHotTileBuffer(hotTile);
 
-                uint32_t size = numSamples * mHotTileSize[attachment];
-                hotTile.pBuffer = (BYTE*)_aligned_malloc(size, KNOB_SIMD_WIDTH * 4);
+                    AllocHotTileBuffer(hotTile, numSamples * GetHotTileSize(hotTile.format), x, y);
+                    if (hotTile.pHiZ != NULL)
+                    {
+                        ResetHiZ(&hotTile, -FLT_MAX, FLT_MAX);
+                    }
+                }
                 hotTile.state = HOTTILE_INVALID;
                 hotTile.numSamples = numSamples;
             }
+        }
+
+        if ((renderTargetArrayIndex != 0 || layerSwitched) && hotTile.state == HOTTILE_INVALID)
+        {
+            LoadHotTile(pContext, pDC, attachment, x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, &hotTile);
+            hotTile.state = HOTTILE_DIRTY;
+        }
 
-            // if requested render target array index isn't currently loaded, need to store out the current hottile 
-            // and load the requested array slice
-            if (renderTargetArrayIndex != hotTile.renderTargetArrayIndex)
+        hotTile.referenced = true;
+        hotTile.lastUseDraw = pDC->drawId;
+        // order the uses of the macrotile's slices for GetLayerHotTile. Only the worker
+        // owning the macrotile gets here, so the slices' own stamps are enough.
+        if (firstLayer.pNextLayer != NULL)
+        {
+            uint64_t lastUse = 0;
+            for (HOTTILE* pLayer = &firstLayer; pLayer != NULL; pLayer = pLayer->pNextLayer)
             {
-                SWR_FORMAT format;
-                switch (attachment)
-                {
-                case SWR_ATTACHMENT_COLOR0:
-                case SWR_ATTACHMENT_COLOR1:
-                case SWR_ATTACHMENT_COLOR2:
-                case SWR_ATTACHMENT_COLOR3:
-                case SWR_ATTACHMENT_COLOR4:
-                case SWR_ATTACHMENT_COLOR5:
-                case SWR_ATTACHMENT_COLOR6:
-                case SWR_ATTACHMENT_COLOR7: format = KNOB_COLOR_HOT_TILE_FORMAT; break;
-                case SWR_ATTACHMENT_DEPTH: format = KNOB_DEPTH_HOT_TILE_FORMAT; break;
-                case SWR_ATTACHMENT_STENCIL: format = KNOB_STENCIL_HOT_TILE_FORMAT; break;
-                default: SWR_ASSERT(false, "Unknown attachment: %d", attachment); format = KNOB_COLOR_HOT_TILE_FORMAT; break;
-                }
+                lastUse = std::max(lastUse, pLayer->lastUse);
+            }
+            hotTile.lastUse = lastUse + 1;
+        }
+        return &hotTile;
+    }
 
-                if (hotTile.state == HOTTILE_DIRTY)
-                {
-                    pContext->pfnStoreTile(GetPrivateState(pDC), format, attachment,
-                        x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, hotTile.renderTargetArrayIndex, hotTile.pBuffer);
-                }
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief True if KNOB_HOT_TILE_BUDGET_MB limits hot tile memory. BE
+    ///        workers then hold the macrotile lock while working on a tile.
+    bool HasBudget() const
+    {
+        return mBudgetBytes != 0;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Acquires the lock of a macrotile. Only the evicting worker can
+    ///        contend for it, and only briefly.
+    void LockTile(uint32_t macroID)
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(macroID, x, y);
+        while (InterlockedCompareExchange(&mTileLocks[x][y], 1, 0) != 0)
+        {
+            _mm_pause();
+        }
+    }
+
+    void UnlockTile(uint32_t macroID)
+    {
+        uint32_t x, y;
+        MacroTileMgr::getTileIndices(macroID, x, y);
+        _ReadWriteBarrier();
+        mTileLocks[x][y] = 0;
+    }
 
-                pContext->pfnLoadTile(GetPrivateState(pDC), format, attachment,
-                    x * KNOB_MACROTILE_X_DIM, y * KNOB_MACROTILE_Y_DIM, renderTargetArrayIndex, hotTile.pBuffer);
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Frees hot tiles, least recently used first, while hot tiles
+    ///        exceed the budget. Tiles in sync with their surface are freed
+    ///        as is. Dirty single sample tiles that store losslessly and were
+    ///        last used by pDC are stored first. Multisampled dirty tiles
+    ///        would be resolved by the store, and pending clears are kept.
+    /// @param pDC - draw the evicting worker just worked on, its private
+    ///              state describes the surfaces of the tiles it used.
+    void EvictHotTiles(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC);
 
-                hotTile.renderTargetArrayIndex = renderTargetArrayIndex;
-                hotTile.state = HOTTILE_DIRTY;
-            }
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Bytes held by hot tile buffers.
+    int64_t GetBytesAllocated() const
+    {
+        return mBytesAllocated;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Frees a hot tile's buffers. The next GetHotTile with create
+    ///        reallocates it and the tile is reloaded from its surface.
+    void ReleaseHotTile(HOTTILE& hotTile)
+    {
+        if (hotTile.pBuffer != NULL)
+        {
+            FreeHotTileBuffer(hotTile);
+        }
+        if (hotTile.pHiZ != NULL)
+        {
+            _aligned_free(hotTile.pHiZ);
+            hotTile.pHiZ = NULL;
+        }
+        hotTile.state = HOTTILE_INVALID;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Stores a hot tile to the render target surface bound to the
+    ///        attachment. Multisampled color hot tiles are resolved on the
+    ///        way out by averaging their samples, depth and stencil store
+    ///        sample 0. The hot tile itself is left untouched.
+    /// @param x - x position of the macrotile in pixels
+    /// @param y - y position of the macrotile in pixels
+    static void StoreHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, SWR_RENDERTARGET_ATTACHMENT attachment,
+        uint32_t x, uint32_t y, HOTTILE* pHotTile);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Frees the calling thread's multisample resolve scratch, if it
+    ///        has one.
+    static void FreeThreadResolveBuffer();
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Loads a hot tile from the render target surface bound to the
+    ///        attachment. The surface holds a single sample per pixel, which
+    ///        is replicated to every sample of a multisampled hot tile.
+    /// @param x - x position of the macrotile in pixels
+    /// @param y - y position of the macrotile in pixels
+    static void LoadHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, SWR_RENDERTARGET_ATTACHMENT attachment,
+        uint32_t x, uint32_t y, HOTTILE* pHotTile);
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Sets the depth bounds of every raster tile of a depth hot tile.
+    ///        [-FLT_MAX, FLT_MAX] marks the contents as unknown.
+    static void ResetHiZ(HOTTILE* pHotTile, float zMin, float zMax)
+    {
+        for (uint32_t t = 0; t < NUM_RASTER_TILES; ++t)
+        {
+            pHotTile->pHiZ[t].zMin = zMin;
+            pHotTile->pHiZ[t].zMax = zMax;
         }
-        return &tile.Attachment[attachment];
     }
 
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Recomputes the depth bounds of every raster tile of a depth hot
+    ///        tile from its contents.
+    static void UpdateHiZ(HOTTILE* pHotTile);
+
     HotTileSet &GetHotTile(uint32_t macroID)
     {
         uint32_t x, y;
@@ -386,7 +646,84 @@ public:
     }
 
 private:
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Finds or makes room for the hot tile of an array slice.
+    /// @param switched - Set if a resident slice was stored to make room,
+    ///                   the returned tile then has to be loaded.
+    HOTTILE& GetLayerHotTile(SWR_CONTEXT* pContext, DRAW_CONTEXT* pDC, uint32_t x, uint32_t y,
+        SWR_RENDERTARGET_ATTACHMENT attachment, HOTTILE& firstLayer, uint32_t renderTargetArrayIndex, bool& switched);
+
+private:
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Default hot tile format for an attachment.
+    static SWR_FORMAT GetHotTileFormat(SWR_RENDERTARGET_ATTACHMENT attachment)
+    {
+        switch (attachment)
+        {
+        case SWR_ATTACHMENT_COLOR0:
+        case SWR_ATTACHMENT_COLOR1:
+        case SWR_ATTACHMENT_COLOR2:
+        case SWR_ATTACHMENT_COLOR3:
+        case SWR_ATTACHMENT_COLOR4:
+        case SWR_ATTACHMENT_COLOR5:
+        case SWR_ATTACHMENT_COLOR6:
+        case SWR_ATTACHMENT_COLOR7: return KNOB_COLOR_HOT_TILE_FORMAT;
+        case SWR_ATTACHMENT_DEPTH: return KNOB_DEPTH_HOT_TILE_FORMAT;
+        case SWR_ATTACHMENT_STENCIL: return KNOB_STENCIL_HOT_TILE_FORMAT;
+        default: SWR_ASSERT(false, "Unknown attachment: %d", attachment); return KNOB_COLOR_HOT_TILE_FORMAT;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief True if a hot tile of the format reloads exactly what it
+    ///        stored. Low precision color hot tiles are only picked for
+    ///        surfaces of their own format and stencil is 8 bit either way;
+    ///        full precision color and depth hot tiles also back narrower
+    ///        surfaces.
+    static bool StoresLosslessly(SWR_FORMAT format)
+    {
+        switch (format)
+        {
+        case KNOB_COLOR_HOT_TILE_FORMAT_UNORM8:
+        case KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16:
+        case KNOB_STENCIL_HOT_TILE_FORMAT:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Size in bytes of a single sample of a hot tile in the given format.
+    static uint32_t GetHotTileSize(SWR_FORMAT format)
+    {
+        return KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * GetFormatInfo(format).Bpp;
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Allocates a hot tile buffer on the NUMA node owning the
+    ///        macrotile, rather than wherever the worker first touching it
+    ///        happens to run.
+    /// @param x, y - macrotile indices
+    void AllocHotTileBuffer(HOTTILE& hotTile, uint32_t size, uint32_t x, uint32_t y);
+    void FreeHotTileBuffer(HOTTILE& hotTile);
+
     HotTileSet mHotTiles[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];
-    uint32_t mHotTileSize[SWR_NUM_ATTACHMENTS];
+
+    // NUMA partitions of the macrotiles, see GetMacroTileNumaNode. Buffers are
+    // only placed explicitly with more than one partition.
+    uint32_t mNumNodes;
+    uint32_t mNodeIds[KNOB_MAX_NUMA_NODES_PER_CONTEXT];
+    bool mNumaAlloc;
+
+    // Budgeted hot tiles. Each macrotile has a lock held by the worker
+    // working on it so the evicting worker can safely free its hot tiles.
+    volatile uint32_t mTileLocks[KNOB_NUM_HOT_TILES_X][KNOB_NUM_HOT_TILES_Y];
+    uint64_t mBudgetBytes;
+    OSALIGNLINE(volatile int64_t) mBytesAllocated;
+    OSALIGNLINE(volatile uint32_t) mEvictLock;     // Held by the single evicting worker.
+    uint32_t mEvictHand;                            // Next macrotile the eviction clock visits.
+    OSALIGNLINE(volatile uint32_t) mTilesUsedX;    // Macrotiles that ever had a hot tile lie below
+    volatile uint32_t mTilesUsedY;                  // these, the eviction clock only sweeps them.
 };
 
@@ -43,9 +43,12 @@
 
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/IRReader/IRReader.h"
 
 #include "core/state.h"
+#include "core/utils.h"
 #include "common/containers.hpp"
 
 #include "state_llvm.h"
@@ -58,6 +61,8 @@
 #define INTEL_OUTPUT_DIR "c:\\Intel"
 #define RASTY_OUTPUT_DIR INTEL_OUTPUT_DIR "\\Rasty"
 #define JITTER_OUTPUT_DIR RASTY_OUTPUT_DIR "\\Jitter"
+#else
+#include <dlfcn.h>
 #endif
 
 using namespace llvm;
@@ -147,6 +152,15 @@ JitManager::JitManager(uint32_t simdWidth, const char *arch)
 
     mpExec = EB.create();
 
+    if (KNOB_JIT_ENABLE_CACHE)
+    {
+        mCache.Init(hostCPUName.str(), CodeGenOpt::Aggressive);
+        if (mCache.IsEnabled())
+        {
+            mpExec->setObjectCache(&mCache);
+        }
+    }
+
 #if LLVM_USE_INTEL_JITEVENTS
     JITEventListener *vTune = JITEventListener::createIntelJITEventListener();
     mpExec->RegisterJITEventListener(vTune);
@@ -194,13 +208,28 @@ JitManager::JitManager(uint32_t simdWidth, const char *arch)
 
 //////////////////////////////////////////////////////////////////////////
 /// @brief Create new LLVM module.
-void JitManager::SetupNewModule()
+/// @param pCacheTag - If non-null, the module is cacheable and its object
+///                    code is looked up in / stored to the jit cache.
+/// @param pCacheKey - State the module's IR is built from.
+/// @param cacheKeySize - Size of the key in bytes.
+void JitManager::SetupNewModule(const char* pCacheTag, const void* pCacheKey, uint32_t cacheKeySize)
 {
     SWR_ASSERT(mIsModuleFinalized == true && "Current module is not finalized!");
     
-    std::stringstream fnName("JitModule", std::ios_base::in | std::ios_base::out | std::ios_base::ate);
-    fnName << mJitNumber++;
-    std::unique_ptr<Module> newModule(new Module(fnName.str(), mContext));
+    bool bCacheable = pCacheTag != nullptr && mCache.IsEnabled();
+    std::string moduleName;
+    if (bCacheable)
+    {
+        moduleName = JitCache::GetModuleName(pCacheTag, ComputeCRC(0, pCacheKey, cacheKeySize));
+        mJitNumber++;
+    }
+    else
+    {
+        std::stringstream fnName("JitModule", std::ios_base::in | std::ios_base::out | std::ios_base::ate);
+        fnName << mJitNumber++;
+        moduleName = fnName.str();
+    }
+    std::unique_ptr<Module> newModule(new Module(moduleName, mContext));
     mpCurrentModule = newModule.get();
 #if defined(_WIN32)
     // Needed for MCJIT on windows
@@ -209,6 +238,11 @@ void JitManager::SetupNewModule()
     newModule->setTargetTriple(hostTriple.getTriple());
 #endif // _WIN32
 
+    if (bCacheable)
+    {
+        mCache.SetModuleKey(mpCurrentModule, pCacheKey, cacheKeySize);
+    }
+
     mpExec->addModule(std::move(newModule));
     mIsModuleFinalized = false;
 }
@@ -273,6 +307,345 @@ void JitManager::DumpToFile(Function *f, const char *fileName)
     }
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// JitCache
+//////////////////////////////////////////////////////////////////////////
+
+static const char* const JIT_CACHE_MODULE_PREFIX = "SWRJIT.";
+static const char* const JIT_CACHE_FILE_EXT = ".obj";
+
+// bump when the file layout or the cached IR interface changes
+static const uint64_t JIT_CACHE_MAGIC = 0x5357524a49543033ULL;   // "SWRJIT03"
+
+// followed by keySize bytes of cache key, then objSize bytes of object code
+struct JitCacheFileHeader
+{
+    uint64_t magic;
+    uint32_t envCRC;        // llvm version, cpu, opt level, simd width and build stamp
+    uint32_t objCRC;
+    uint32_t objSize;
+    uint32_t keySize;
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns a stamp of the binary the jitter is linked into. The
+///        cache key only covers the compile state, so a rebuilt driver
+///        that generates different IR for it must not hit older entries.
+static std::string GetBuildStamp()
+{
+    std::string path;
+#if defined(_WIN32)
+    HMODULE hModule = nullptr;
+    char name[MAX_PATH];
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           (LPCSTR)&GetBuildStamp, &hModule) &&
+        GetModuleFileNameA(hModule, name, sizeof(name)))
+    {
+        path = name;
+    }
+#else
+    Dl_info info;
+    if (dladdr((void*)&GetBuildStamp, &info) && info.dli_fname)
+    {
+        path = info.dli_fname;
+    }
+#endif
+
+    sys::fs::file_status status;
+    if (path.empty() || sys::fs::status(Twine(path), status))
+    {
+        return __DATE__ " " __TIME__;
+    }
+
+    std::stringstream stamp;
+    stamp << status.getSize() << "@" << (uint64_t)LLVM_TIME_TO_TIME_T(status.getLastModificationTime());
+    return stamp.str();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Setup cache directory and scan current size of the cache.
+/// @param cpu - Target cpu the jitted code is generated for.
+/// @param optLevel - Codegen optimization level.
+void JitCache::Init(const std::string& cpu, uint32_t optLevel)
+{
+    mCpu = cpu;
+    mOptLevel = optLevel;
+    mMaxBytes = uint64_t(KNOB_JIT_CACHE_MAX_SIZE_MB) * 1024 * 1024;
+
+    // The host cpu is part of the environment as well since shaders compiled
+    // through gallivm target the host rather than the requested jit arch.
+    std::stringstream env;
+    env << LLVM_VERSION_MAJOR << "." << LLVM_VERSION_MINOR << ":" << mCpu << ":" << sys::getHostCPUName().str()
+        << ":" << mOptLevel << ":" << KNOB_SIMD_WIDTH << ":" << GetBuildStamp();
+    std::string envStr = env.str();
+    mEnvCRC = ComputeCRC(0, envStr.data(), (uint32_t)envStr.size());
+
+    mCacheDir.clear();
+    if (KNOB_JIT_CACHE_DIR.size())
+    {
+        sys::path::append(mCacheDir, KNOB_JIT_CACHE_DIR);
+    }
+    else
+    {
+#if defined(_WIN32)
+        sys::path::append(mCacheDir, JITTER_OUTPUT_DIR, "Cache");
+#else
+        const char* pXdgCache = getenv("XDG_CACHE_HOME");
+        const char* pHome = getenv("HOME");
+        if (pXdgCache && pXdgCache[0])
+        {
+            sys::path::append(mCacheDir, pXdgCache, "swr", "jit");
+        }
+        else if (pHome && pHome[0])
+        {
+            sys::path::append(mCacheDir, pHome, ".cache", "swr");
+            sys::path::append(mCacheDir, "jit");
+        }
+        else
+        {
+            return;
+        }
+#endif
+    }
+
+    if (sys::fs::create_directories(Twine(mCacheDir)))
+    {
+        return;
+    }
+
+    std::error_code EC;
+    mStats.bytesOnDisk = 0;
+    for (sys::fs::directory_iterator it(Twine(mCacheDir), EC), end; !EC && it != end; it.increment(EC))
+    {
+        sys::fs::file_status status;
+        if (sys::path::extension(it->path()) == JIT_CACHE_FILE_EXT && !it->status(status))
+        {
+            mStats.bytesOnDisk += status.getSize();
+        }
+    }
+
+    mEnabled = true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Returns the module identifier to use for a cacheable module.
+/// @param pTag - Short name of the kind of function the module holds.
+/// @param cacheKey - Hash of the compile state the module is built from.
+std::string JitCache::GetModuleName(const char* pTag, uint32_t cacheKey)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%s%s.%08x", JIT_CACHE_MODULE_PREFIX, pTag, cacheKey);
+    return std::string(name);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Records the full cache key of a cacheable module.  The file name
+///        only holds a hash of it, so the key is stored in the entry and
+///        compared on load.
+/// @param M - Module created with a cacheable module identifier.
+/// @param pKey - State the module's IR is built from.
+/// @param keySize - Size of the key in bytes.
+void JitCache::SetModuleKey(const Module* M, const void* pKey, uint32_t keySize)
+{
+    std::lock_guard<std::mutex> guard(mLock);
+    mModuleKeys[M].assign((const char*)pKey, keySize);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Builds the file path for a module. Returns false if the module
+///        isn't cacheable.
+bool JitCache::GetCachePath(const Module* M, SmallVectorImpl<char>& path)
+{
+    const std::string& moduleId = M->getModuleIdentifier();
+    if (!mEnabled || moduleId.compare(0, strlen(JIT_CACHE_MODULE_PREFIX), JIT_CACHE_MODULE_PREFIX) != 0)
+    {
+        return false;
+    }
+
+    char envStr[16];
+    snprintf(envStr, sizeof(envStr), ".%08x", mEnvCRC);
+
+    path.clear();
+    sys::path::append(path, Twine(mCacheDir), moduleId.substr(strlen(JIT_CACHE_MODULE_PREFIX)) + envStr + JIT_CACHE_FILE_EXT);
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Remove least recently used entries until the cache fits in
+///        its size budget.  Must be called with mLock held.
+void JitCache::EvictEntries()
+{
+    struct Entry
+    {
+        std::string path;
+        uint64_t size;
+        uint64_t lastUse;
+    };
+    std::vector<Entry> entries;
+
+    uint64_t totalBytes = 0;
+    std::error_code EC;
+    for (sys::fs::directory_iterator it(Twine(mCacheDir), EC), end; !EC && it != end; it.increment(EC))
+    {
+        sys::fs::file_status status;
+        if (sys::path::extension(it->path()) == JIT_CACHE_FILE_EXT && !it->status(status))
+        {
+            entries.push_back({ it->path(), status.getSize(), (uint64_t)LLVM_TIME_TO_TIME_T(status.getLastModificationTime()) });
+            totalBytes += status.getSize();
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+
+    for (const Entry& entry : entries)
+    {
+        if (totalBytes <= mMaxBytes)
+        {
+            break;
+        }
+
+        if (!sys::fs::remove(Twine(entry.path)))
+        {
+            totalBytes -= entry.size;
+            mStats.evictions++;
+        }
+    }
+
+    mStats.bytesOnDisk = totalBytes;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Called by MCJIT once a module has been compiled.  Writes the
+///        object to a temporary file and moves it into place so that
+///        concurrent processes never see partially written entries.
+void JitCache::notifyObjectCompiled(const Module *M, MemoryBufferRef Obj)
+{
+    SmallString<256> filePath;
+    if (!GetCachePath(M, filePath))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(mLock);
+
+    auto keyIt = mModuleKeys.find(M);
+    if (keyIt == mModuleKeys.end())
+    {
+        return;
+    }
+    std::string key = std::move(keyIt->second);
+    mModuleKeys.erase(keyIt);
+
+    JitCacheFileHeader header;
+    header.magic = JIT_CACHE_MAGIC;
+    header.envCRC = mEnvCRC;
+    header.objSize = (uint32_t)Obj.getBufferSize();
+    header.objCRC = ComputeCRC(0, Obj.getBufferStart(), header.objSize);
+    header.keySize = (uint32_t)key.size();
+
+    int fd;
+    SmallString<256> tmpPath;
+    if (sys::fs::createUniqueFile(Twine(filePath) + ".%%%%%%", fd, tmpPath))
+    {
+        return;
+    }
+
+    {
+        raw_fd_ostream os(fd, true);
+        os.write((const char*)&header, sizeof(header));
+        os.write(key.data(), header.keySize);
+        os.write(Obj.getBufferStart(), header.objSize);
+        os.flush();
+        if (os.has_error())
+        {
+            os.clear_error();
+            sys::fs::remove(Twine(tmpPath));
+            return;
+        }
+    }
+
+    if (sys::fs::rename(Twine(tmpPath), Twine(filePath)))
+    {
+        sys::fs::remove(Twine(tmpPath));
+        return;
+    }
+
+    mStats.stores++;
+    mStats.bytesOnDisk += sizeof(header) + header.keySize + header.objSize;
+
+    if (mMaxBytes && mStats.bytesOnDisk > mMaxBytes)
+    {
+        EvictEntries();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Called by MCJIT before compiling a module.  Returns the cached
+///        object or nullptr if the module has to be compiled.
+std::unique_ptr<MemoryBuffer> JitCache::getObject(const Module* M)
+{
+    SmallString<256> filePath;
+    if (!GetCachePath(M, filePath))
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> guard(mLock);
+
+    auto keyIt = mModuleKeys.find(M);
+    if (keyIt == mModuleKeys.end())
+    {
+        return nullptr;
+    }
+    const std::string& key = keyIt->second;
+
+    auto fileOrErr = MemoryBuffer::getFile(Twine(filePath), -1, false);
+    if (!fileOrErr)
+    {
+        mStats.misses++;
+        return nullptr;
+    }
+
+    std::unique_ptr<MemoryBuffer> pFile = std::move(fileOrErr.get());
+    const JitCacheFileHeader* pHeader = (const JitCacheFileHeader*)pFile->getBufferStart();
+    const char* pKey = pFile->getBufferStart() + sizeof(JitCacheFileHeader);
+    const char* pObj = pKey + key.size();
+
+    if ((pFile->getBufferSize() < sizeof(JitCacheFileHeader)) ||
+        (pHeader->magic != JIT_CACHE_MAGIC) ||
+        (pHeader->envCRC != mEnvCRC) ||
+        (pHeader->keySize != key.size()) ||
+        (pFile->getBufferSize() != sizeof(JitCacheFileHeader) + (uint64_t)pHeader->keySize + pHeader->objSize) ||
+        (memcmp(pKey, key.data(), key.size()) != 0) ||
+        (pHeader->objCRC != ComputeCRC(0, pObj, pHeader->objSize)))
+    {
+        // stale, corrupt or built from another key with the same hash,
+        // will be overwritten once recompiled
+        mStats.misses++;
+        return nullptr;
+    }
+
+    mModuleKeys.erase(keyIt);
+
+    // refresh timestamp so eviction is least-recently-used
+    int fd;
+    if (!sys::fs::openFileForWrite(Twine(filePath), fd, sys::fs::F_Append))
+    {
+        sys::fs::setLastModificationAndAccessTime(fd, LLVM_TIME_NOW());
+        sys::Process::SafelyCloseFileDescriptor(fd);
+    }
+
+    mStats.hits++;
+    return MemoryBuffer::getMemBufferCopy(StringRef(pObj, pHeader->objSize), M->getModuleIdentifier());
+}
+
+JitCache::Stats JitCache::GetStats()
+{
+    std::lock_guard<std::mutex> guard(mLock);
+    return mStats;
+}
+
 extern "C"
 {
     //////////////////////////////////////////////////////////////////////////
@@ -289,4 +662,17 @@ extern "C"
     {
         delete reinterpret_cast<JitManager*>(hJitContext);
     }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Get JIT cache counters.
+    void JITCALL JitGetCacheStats(HANDLE hJitContext, JIT_CACHE_STATS& stats)
+    {
+        JitCache::Stats cacheStats = reinterpret_cast<JitManager*>(hJitContext)->mCache.GetStats();
+
+        stats.hits = cacheStats.hits;
+        stats.misses = cacheStats.misses;
+        stats.stores = cacheStats.stores;
+        stats.evictions = cacheStats.evictions;
+        stats.bytesOnDisk = cacheStats.bytesOnDisk;
+    }
 }
@@ -54,6 +54,16 @@
 #include "llvm/Support/FileSystem.h"
 #define LLVM_F_NONE sys::fs::F_None
 
+#if LLVM_VERSION_MAJOR >= 4
+#include "llvm/Support/Chrono.h"
+#define LLVM_TIME_NOW() sys::toTimePoint(std::time(nullptr))
+#define LLVM_TIME_TO_TIME_T(t) sys::toTimeT(t)
+#else
+#include "llvm/Support/TimeValue.h"
+#define LLVM_TIME_NOW() sys::TimeValue::now()
+#define LLVM_TIME_TO_TIME_T(t) (t).toEpochTime()
+#endif
+
 #include "llvm/Analysis/Passes.h"
 #include "llvm/PassManager.h"
 #include "llvm/CodeGen/Passes.h"
@@ -63,6 +73,11 @@
 #include "llvm/Transforms/IPO.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Support/Host.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <ctime>
 
 
 using namespace llvm;
@@ -128,6 +143,64 @@ struct JitLLVMContext : LLVMContext
 {
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// JitCache
+/// @brief Persistent on-disk cache of compiled object code.  Only modules
+/// created with a cache key (see JitManager::SetupNewModule) are cached.
+/// Entries are named after a hash of the cache key combined with the LLVM
+/// version, target cpu, codegen level and a stamp of the driver binary, so
+/// objects built by a different driver build are never loaded.  Each entry
+/// also stores the full key and is only loaded if it matches byte for byte.
+//////////////////////////////////////////////////////////////////////////
+class JitCache : public ObjectCache
+{
+public:
+    JitCache() {}
+    virtual ~JitCache() {}
+
+    void Init(const std::string& cpu, uint32_t optLevel);
+
+    bool IsEnabled() const { return mEnabled; }
+
+    /// Returns the module identifier to use for a cacheable module.
+    static std::string GetModuleName(const char* pTag, uint32_t cacheKey);
+
+    /// Records the full cache key of a cacheable module.
+    void SetModuleKey(const Module* M, const void* pKey, uint32_t keySize);
+
+    /// ObjectCache interface
+    virtual void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj);
+    virtual std::unique_ptr<MemoryBuffer> getObject(const Module* M);
+
+    struct Stats
+    {
+        uint64_t hits;          ///< objects loaded from disk
+        uint64_t misses;        ///< cacheable modules that had to be compiled
+        uint64_t stores;        ///< objects written to disk
+        uint64_t evictions;     ///< objects removed to stay under the size limit
+        uint64_t bytesOnDisk;   ///< current size of the cache directory
+    };
+
+    Stats GetStats();
+
+private:
+    bool GetCachePath(const Module* M, SmallVectorImpl<char>& path);
+    void EvictEntries();
+
+    bool mEnabled = false;
+    std::string mCpu;
+    uint32_t mOptLevel = 0;
+    uint32_t mEnvCRC = 0;
+    uint64_t mMaxBytes = 0;
+    SmallString<256> mCacheDir;
+
+    std::mutex mLock;
+    Stats mStats = {};
+
+    // full keys of cacheable modules that haven't been loaded or stored yet
+    std::unordered_map<const Module*, std::string> mModuleKeys;
+};
+
 
 //////////////////////////////////////////////////////////////////////////
 /// JitManager
@@ -175,7 +248,9 @@ struct JitManager
 
     JitInstructionSet mArch;
 
-    void SetupNewModule();
+    JitCache mCache;
+
+    void SetupNewModule(const char* pCacheTag = nullptr, const void* pCacheKey = nullptr, uint32_t cacheKeySize = 0);
     bool SetupModuleFromIR(const uint8_t *pIR);
 
     static void DumpToFile(Function *f, const char *fileName);
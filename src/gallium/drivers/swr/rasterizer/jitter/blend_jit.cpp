@@ -342,7 +342,25 @@ struct BlendJit : public Builder
         Value* pResult = argitr++;
         pResult->setName("result");
 
-        static_assert(KNOB_COLOR_HOT_TILE_FORMAT == R32G32B32A32_FLOAT, "Unsupported hot tile format");
+        // hot tile is SOA, each component is a plane of KNOB_SIMD_WIDTH values
+        Value* pDstComps = nullptr;
+        switch (state.hotTileFormat)
+        {
+        case R32G32B32A32_FLOAT:
+            pDstComps = pDst;
+            break;
+        case R8G8B8A8_UNORM:
+            pDstComps = BITCAST(pDst, PointerType::get(VectorType::get(mInt8Ty, JM()->mVWidth), 0));
+            break;
+        case R16G16B16A16_FLOAT:
+            pDstComps = BITCAST(pDst, PointerType::get(mSimdInt16Ty, 0));
+            break;
+        default:
+            SWR_ASSERT(false, "Unsupported hot tile format: %d", state.hotTileFormat);
+            pDstComps = pDst;
+            break;
+        }
+
         Value* dst[4];
         Value* constantColor[4];
         Value* src[4];
@@ -351,7 +369,18 @@ struct BlendJit : public Builder
         for (uint32_t i = 0; i < 4; ++i)
         {
             // load hot tile
-            dst[i] = LOAD(pDst, { i });
+            dst[i] = LOAD(pDstComps, { i });
+            switch (state.hotTileFormat)
+            {
+            case R8G8B8A8_UNORM:
+                dst[i] = FMUL(UI_TO_FP(Z_EXT(dst[i], mSimdInt32Ty), mSimdFP32Ty), VIMMED1(1.0f / 255.0f));
+                break;
+            case R16G16B16A16_FLOAT:
+                dst[i] = CVTPH2PS(dst[i]);
+                break;
+            default:
+                break;
+            }
 
             // load constant color
             constantColor[i] = VBROADCAST(LOAD(pBlendState, { 0, SWR_BLEND_STATE_constantColor, i }));
@@ -464,7 +493,8 @@ extern "C" PFN_BLEND_JIT_FUNC JITCALL JitCompileBlend(HANDLE hJitMgr, const BLEN
 {
     JitManager* pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
 
-    pJitMgr->SetupNewModule();
+    // BLEND_COMPILE_STATE is compared bitwise, so key on it the same way
+    pJitMgr->SetupNewModule("blend", &state, sizeof(state));
 
     BlendJit theJit(pJitMgr);
     HANDLE hFunc = theJit.Create(state);
@@ -39,6 +39,7 @@
 struct BLEND_COMPILE_STATE
 {
     SWR_FORMAT format;          // format of render target being blended
+    SWR_FORMAT hotTileFormat;   // format of color hot tile, see SwrGetColorHotTileFormat
     bool independentAlphaBlendEnable;
     SWR_RENDER_TARGET_BLEND_STATE blendState;
 
@@ -1433,6 +1433,36 @@ PFN_FETCH_FUNC JitFetchFunc(HANDLE hJitMgr, const HANDLE hFunc)
     return pfnFetch;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Jit cache key for fetch state. Only holds the fields that
+///        FETCH_COMPILE_STATE::operator== compares, the rest may be garbage.
+/// @param state   - fetch state to build function from
+static std::string ComputeFetchCacheKey(const FETCH_COMPILE_STATE& state)
+{
+    std::string key;
+    auto append = [&key](const void* pData, size_t size) { key.append((const char*)pData, size); };
+
+    append(&state.numAttribs, sizeof(state.numAttribs));
+    append(&state.indexType, sizeof(state.indexType));
+    append(&state.cutIndex, sizeof(state.cutIndex));
+
+    uint32_t flags = (state.bDisableVGATHER ? 1 : 0) |
+                     (state.bDisableIndexOOBCheck ? 2 : 0) |
+                     (state.bEnableCutIndex ? 4 : 0);
+    append(&flags, sizeof(flags));
+
+    for (uint32_t i = 0; i < state.numAttribs; ++i)
+    {
+        append(&state.layout[i].bits, sizeof(state.layout[i].bits));
+        if (state.layout[i].InstanceEnable)
+        {
+            append(&state.layout[i].InstanceDataStepRate, sizeof(state.layout[i].InstanceDataStepRate));
+        }
+    }
+
+    return key;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief JIT compiles fetch shader
 /// @param hJitMgr - JitManager handle
@@ -1441,7 +1471,8 @@ extern "C" PFN_FETCH_FUNC JITCALL JitCompileFetch(HANDLE hJitMgr, const FETCH_CO
 {
     JitManager* pJitMgr = reinterpret_cast<JitManager*>(hJitMgr);
 
-    pJitMgr->SetupNewModule();
+    std::string cacheKey = ComputeFetchCacheKey(state);
+    pJitMgr->SetupNewModule("fetch", cacheKey.data(), (uint32_t)cacheKey.size());
 
     FetchJit theJit(pJitMgr);
     HANDLE hFunc = theJit.Create(state);
@@ -53,6 +53,24 @@ HANDLE JITCALL JitCreateContext(uint32_t targetSimdWidth, const char* arch);
 /// @brief Destroy JIT context.
 void JITCALL JitDestroyContext(HANDLE hJitContext);
 
+//////////////////////////////////////////////////////////////////////////
+/// Jit cache counters
+//////////////////////////////////////////////////////////////////////////
+struct JIT_CACHE_STATS
+{
+    uint64_t hits;          ///< objects loaded from the on-disk cache
+    uint64_t misses;        ///< cacheable functions that had to be compiled
+    uint64_t stores;        ///< objects written to the cache
+    uint64_t evictions;     ///< objects removed to stay under KNOB_JIT_CACHE_MAX_SIZE_MB
+    uint64_t bytesOnDisk;   ///< current size of the cache
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Get JIT cache counters.
+/// @param hJitContext - Jit Context
+/// @param stats - Filled out with the current counters
+void JITCALL JitGetCacheStats(HANDLE hJitContext, JIT_CACHE_STATS& stats);
+
 //////////////////////////////////////////////////////////////////////////
 /// Jit Compile Info Input
 //////////////////////////////////////////////////////////////////////////
@@ -219,6 +219,58 @@ static uint16_t Convert32To16Float(float val)
     uint32_t tmpVal = (sign << 15) | (exp << 10) | mant;
     return (uint16_t)tmpVal;
 }
+
+//////////////////////////////////////////////////////////////////////////
+/// @brief Convert an IEEE 754 32-bit single precision float to an IEEE 754
+///        16-bit float, rounding to nearest even.  Gives the same bits as
+///        _mm_cvtps_ph with _MM_FROUND_TO_NEAREST_INT.
+/// @param val - 32-bit float
+static uint16_t Convert32To16FloatRTNE(float val)
+{
+    uint32_t uf = *(uint32_t*)&val;
+    uint32_t sign = (uf >> 16) & 0x8000;
+    uint32_t absf = uf & 0x7FFFFFFF;
+    uint32_t exp = absf >> 23;
+    uint32_t mant = absf & 0x007FFFFF;
+
+    if (absf > 0x7F800000) // NaN -> quiet NaN, payload truncated
+    {
+        return (uint16_t)(sign | 0x7E00 | (mant >> 13));
+    }
+
+    if (absf >= 0x477FF000) // rounds past 65504 -> infinity
+    {
+        return (uint16_t)(sign | 0x7C00);
+    }
+
+    if (exp < 0x66) // below half the smallest denorm -> zero
+    {
+        return (uint16_t)sign;
+    }
+
+    uint32_t shift, result;
+    if (exp <= 0x70) // denorm, may round up to the smallest normal
+    {
+        mant |= 0x00800000;
+        shift = 0x7E - exp;
+        result = mant >> shift;
+    }
+    else
+    {
+        shift = 13;
+        result = ((exp - 0x70) << 10) | (mant >> shift);
+    }
+
+    // round to nearest even, a carry out of the mantissa bumps the exponent
+    uint32_t roundBits = mant & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (roundBits > halfway || (roundBits == halfway && (result & 1)))
+    {
+        result++;
+    }
+
+    return (uint16_t)(sign | result);
+}
 #endif
 
 //////////////////////////////////////////////////////////////////////////
@@ -46,6 +46,15 @@ static PFN_LOAD_TILES sLoadTilesColorTable_SWR_TILE_MODE_XMAJOR[NUM_SWR_FORMATS]
 
 static PFN_LOAD_TILES sLoadTilesDepthTable_SWR_TILE_MODE_YMAJOR[NUM_SWR_FORMATS];
 
+// RGBA8 UNORM and RGBA16 FLOAT color hot tiles
+static PFN_LOAD_TILES sLoadTilesColorUnorm8Table_SWR_TILE_NONE[NUM_SWR_FORMATS];
+static PFN_LOAD_TILES sLoadTilesColorUnorm8Table_SWR_TILE_MODE_YMAJOR[NUM_SWR_FORMATS];
+static PFN_LOAD_TILES sLoadTilesColorUnorm8Table_SWR_TILE_MODE_XMAJOR[NUM_SWR_FORMATS];
+
+static PFN_LOAD_TILES sLoadTilesColorFloat16Table_SWR_TILE_NONE[NUM_SWR_FORMATS];
+static PFN_LOAD_TILES sLoadTilesColorFloat16Table_SWR_TILE_MODE_YMAJOR[NUM_SWR_FORMATS];
+static PFN_LOAD_TILES sLoadTilesColorFloat16Table_SWR_TILE_MODE_XMAJOR[NUM_SWR_FORMATS];
+
 //////////////////////////////////////////////////////////////////////////
 /// LoadRasterTile
 //////////////////////////////////////////////////////////////////////////
@@ -185,7 +194,43 @@ void LoadHotTile(
         return;
     }
     
-    if (renderTargetIndex < SWR_ATTACHMENT_DEPTH)
+    if (renderTargetIndex < SWR_ATTACHMENT_DEPTH && dstFormat == KNOB_COLOR_HOT_TILE_FORMAT_UNORM8)
+    {
+        switch (pSrcSurface->tileMode)
+        {
+        case SWR_TILE_NONE:
+            pfnLoadTiles = sLoadTilesColorUnorm8Table_SWR_TILE_NONE[pSrcSurface->format];
+            break;
+        case SWR_TILE_MODE_YMAJOR:
+            pfnLoadTiles = sLoadTilesColorUnorm8Table_SWR_TILE_MODE_YMAJOR[pSrcSurface->format];
+            break;
+        case SWR_TILE_MODE_XMAJOR:
+            pfnLoadTiles = sLoadTilesColorUnorm8Table_SWR_TILE_MODE_XMAJOR[pSrcSurface->format];
+            break;
+        default:
+            SWR_ASSERT(0, "Unsupported tiling mode");
+            break;
+        }
+    }
+    else if (renderTargetIndex < SWR_ATTACHMENT_DEPTH && dstFormat == KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16)
+    {
+        switch (pSrcSurface->tileMode)
+        {
+        case SWR_TILE_NONE:
+            pfnLoadTiles = sLoadTilesColorFloat16Table_SWR_TILE_NONE[pSrcSurface->format];
+            break;
+        case SWR_TILE_MODE_YMAJOR:
+            pfnLoadTiles = sLoadTilesColorFloat16Table_SWR_TILE_MODE_YMAJOR[pSrcSurface->format];
+            break;
+        case SWR_TILE_MODE_XMAJOR:
+            pfnLoadTiles = sLoadTilesColorFloat16Table_SWR_TILE_MODE_XMAJOR[pSrcSurface->format];
+            break;
+        default:
+            SWR_ASSERT(0, "Unsupported tiling mode");
+            break;
+        }
+    }
+    else if (renderTargetIndex < SWR_ATTACHMENT_DEPTH)
     {
         switch (pSrcSurface->tileMode)
         {
@@ -359,6 +404,24 @@ void LoadHotTile(
     sLoadTilesColorTable_##tilemode[R8G8B8_UINT]      = LoadMacroTile<TilingTraits<tilemode, 24>, R8G8B8_UINT, R32G32B32A32_FLOAT>::Load; \
     sLoadTilesColorTable_##tilemode[R8G8B8_SINT]      = LoadMacroTile<TilingTraits<tilemode, 24>, R8G8B8_SINT, R32G32B32A32_FLOAT>::Load; \
 
+//////////////////////////////////////////////////////////////////////////
+/// INIT_LOAD_TILES_COLOR_UNORM8_TABLE - Sources of RGBA8 UNORM hot tiles.
+#define INIT_LOAD_TILES_COLOR_UNORM8_TABLE(tilemode) \
+    memset(sLoadTilesColorUnorm8Table_##tilemode, 0, sizeof(sLoadTilesColorUnorm8Table_##tilemode)); \
+    \
+    sLoadTilesColorUnorm8Table_##tilemode[B8G8R8A8_UNORM]      = LoadMacroTile<TilingTraits<tilemode, 32>, B8G8R8A8_UNORM, R8G8B8A8_UNORM>::Load; \
+    sLoadTilesColorUnorm8Table_##tilemode[B8G8R8X8_UNORM]      = LoadMacroTile<TilingTraits<tilemode, 32>, B8G8R8X8_UNORM, R8G8B8A8_UNORM>::Load; \
+    sLoadTilesColorUnorm8Table_##tilemode[R8G8B8A8_UNORM]      = LoadMacroTile<TilingTraits<tilemode, 32>, R8G8B8A8_UNORM, R8G8B8A8_UNORM>::Load; \
+    sLoadTilesColorUnorm8Table_##tilemode[R8G8B8X8_UNORM]      = LoadMacroTile<TilingTraits<tilemode, 32>, R8G8B8X8_UNORM, R8G8B8A8_UNORM>::Load; \
+
+//////////////////////////////////////////////////////////////////////////
+/// INIT_LOAD_TILES_COLOR_FLOAT16_TABLE - Sources of RGBA16 FLOAT hot tiles.
+#define INIT_LOAD_TILES_COLOR_FLOAT16_TABLE(tilemode) \
+    memset(sLoadTilesColorFloat16Table_##tilemode, 0, sizeof(sLoadTilesColorFloat16Table_##tilemode)); \
+    \
+    sLoadTilesColorFloat16Table_##tilemode[R16G16B16A16_FLOAT]      = LoadMacroTile<TilingTraits<tilemode, 64>, R16G16B16A16_FLOAT, R16G16B16A16_FLOAT>::Load; \
+    sLoadTilesColorFloat16Table_##tilemode[R16G16B16X16_FLOAT]      = LoadMacroTile<TilingTraits<tilemode, 64>, R16G16B16X16_FLOAT, R16G16B16A16_FLOAT>::Load; \
+
 //////////////////////////////////////////////////////////////////////////
 /// INIT_LOAD_TILES_TABLE - Helper macro for setting up the tables.
 #define INIT_LOAD_TILES_DEPTH_TABLE(tilemode) \
@@ -379,4 +442,12 @@ void InitSimLoadTilesTable()
     INIT_LOAD_TILES_COLOR_TABLE(SWR_TILE_MODE_XMAJOR);
 
     INIT_LOAD_TILES_DEPTH_TABLE(SWR_TILE_MODE_YMAJOR);
+
+    INIT_LOAD_TILES_COLOR_UNORM8_TABLE(SWR_TILE_NONE);
+    INIT_LOAD_TILES_COLOR_UNORM8_TABLE(SWR_TILE_MODE_YMAJOR);
+    INIT_LOAD_TILES_COLOR_UNORM8_TABLE(SWR_TILE_MODE_XMAJOR);
+
+    INIT_LOAD_TILES_COLOR_FLOAT16_TABLE(SWR_TILE_NONE);
+    INIT_LOAD_TILES_COLOR_FLOAT16_TABLE(SWR_TILE_MODE_YMAJOR);
+    INIT_LOAD_TILES_COLOR_FLOAT16_TABLE(SWR_TILE_MODE_XMAJOR);
 }
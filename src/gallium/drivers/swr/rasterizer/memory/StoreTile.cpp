@@ -45,6 +45,8 @@ typedef void(*PFN_STORE_TILES)(uint8_t*, SWR_SURFACE_STATE*, uint32_t, uint32_t,
 /// Store Raster Tile Function Tables.
 //////////////////////////////////////////////////////////////////////////
 static PFN_STORE_TILES sStoreTilesTableColor[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
+static PFN_STORE_TILES sStoreTilesTableColorUnorm8[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
+static PFN_STORE_TILES sStoreTilesTableColorFloat16[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
 static PFN_STORE_TILES sStoreTilesTableDepth[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
 static PFN_STORE_TILES sStoreTilesTableStencil[SWR_TILE_MODE_COUNT][NUM_SWR_FORMATS] = {};
 
@@ -582,6 +584,61 @@ struct ConvertPixelsSOAtoAOS < R32G32B32A32_FLOAT, R8G8B8X8_UNORM_SRGB >
     }
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// @brief Stores a simd tile of an RGBA8 UNORM hot tile to an 8-bit UNORM
+///        destination. Hot tile and destination share the same encoding so
+///        only the component planes are reordered before the transpose.
+template<SWR_FORMAT DstFormat, size_t NumDests>
+INLINE static void SwizzleConvertRGBA8(const uint8_t* pSrc, uint8_t* (&ppDsts)[NumDests])
+{
+    static const uint32_t RASTER_TILE_BYTES = KNOB_SIMD_WIDTH * 4;
+
+    OSALIGNSIMD(uint8_t) soaTile[RASTER_TILE_BYTES];
+    OSALIGNSIMD(uint8_t) aosTile[RASTER_TILE_BYTES];
+
+    // hot tile planes are in RGBA order
+    for (uint32_t comp = 0; comp < FormatTraits<DstFormat>::numComps; ++comp)
+    {
+        memcpy(&soaTile[comp * KNOB_SIMD_WIDTH], &pSrc[FormatTraits<DstFormat>::swizzle(comp) * KNOB_SIMD_WIDTH], KNOB_SIMD_WIDTH);
+    }
+
+    // Convert from SOA --> AOS
+    FormatTraits<DstFormat>::TransposeT::Transpose(soaTile, aosTile);
+
+    // Store data into destination
+    StorePixels<FormatTraits<DstFormat>::bpp, NumDests>::Store(aosTile, ppDsts);
+}
+
+template<>
+struct ConvertPixelsSOAtoAOS<R8G8B8A8_UNORM, B8G8R8A8_UNORM>
+{
+    template <size_t NumDests>
+    INLINE static void Convert(const uint8_t* pSrc, uint8_t* (&ppDsts)[NumDests])
+    {
+        SwizzleConvertRGBA8<B8G8R8A8_UNORM>(pSrc, ppDsts);
+    }
+};
+
+template<>
+struct ConvertPixelsSOAtoAOS<R8G8B8A8_UNORM, B8G8R8X8_UNORM>
+{
+    template <size_t NumDests>
+    INLINE static void Convert(const uint8_t* pSrc, uint8_t* (&ppDsts)[NumDests])
+    {
+        SwizzleConvertRGBA8<B8G8R8X8_UNORM>(pSrc, ppDsts);
+    }
+};
+
+template<>
+struct ConvertPixelsSOAtoAOS<R8G8B8A8_UNORM, R8G8B8X8_UNORM>
+{
+    template <size_t NumDests>
+    INLINE static void Convert(const uint8_t* pSrc, uint8_t* (&ppDsts)[NumDests])
+    {
+        SwizzleConvertRGBA8<R8G8B8X8_UNORM>(pSrc, ppDsts);
+    }
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// StoreRasterTile
 //////////////////////////////////////////////////////////////////////////
@@ -1458,7 +1515,18 @@ void StoreHotTile(
     PFN_STORE_TILES pfnStoreTiles = nullptr;
     if(renderTargetIndex <= SWR_ATTACHMENT_COLOR7)
     {
-        pfnStoreTiles = sStoreTilesTableColor[pDstSurface->tileMode][pDstSurface->format];
+        switch(srcFormat)
+        {
+        case KNOB_COLOR_HOT_TILE_FORMAT_UNORM8:
+            pfnStoreTiles = sStoreTilesTableColorUnorm8[pDstSurface->tileMode][pDstSurface->format];
+            break;
+        case KNOB_COLOR_HOT_TILE_FORMAT_FLOAT16:
+            pfnStoreTiles = sStoreTilesTableColorFloat16[pDstSurface->tileMode][pDstSurface->format];
+            break;
+        default:
+            pfnStoreTiles = sStoreTilesTableColor[pDstSurface->tileMode][pDstSurface->format];
+            break;
+        }
     }
     else if(renderTargetIndex == SWR_ATTACHMENT_DEPTH)
     {
@@ -1611,6 +1679,28 @@ void InitStoreTilesTableColor(
     table[TileModeT][R8G8B8_SINT]               = StoreMacroTile<TilingTraits<TileModeT, 24>, R32G32B32A32_FLOAT, R8G8B8_SINT>::Store;
 }
 
+//////////////////////////////////////////////////////////////////////////
+/// InitStoreTilesTableColorUnorm8 - Destinations of RGBA8 UNORM hot tiles.
+template <SWR_TILE_MODE TileModeT, size_t NumTileModesT, size_t ArraySizeT>
+void InitStoreTilesTableColorUnorm8(
+    PFN_STORE_TILES (&table)[NumTileModesT][ArraySizeT])
+{
+    table[TileModeT][B8G8R8A8_UNORM]            = StoreMacroTile<TilingTraits<TileModeT, 32>, R8G8B8A8_UNORM, B8G8R8A8_UNORM>::Store;
+    table[TileModeT][B8G8R8X8_UNORM]            = StoreMacroTile<TilingTraits<TileModeT, 32>, R8G8B8A8_UNORM, B8G8R8X8_UNORM>::Store;
+    table[TileModeT][R8G8B8A8_UNORM]            = StoreMacroTile<TilingTraits<TileModeT, 32>, R8G8B8A8_UNORM, R8G8B8A8_UNORM>::Store;
+    table[TileModeT][R8G8B8X8_UNORM]            = StoreMacroTile<TilingTraits<TileModeT, 32>, R8G8B8A8_UNORM, R8G8B8X8_UNORM>::Store;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// InitStoreTilesTableColorFloat16 - Destinations of RGBA16 FLOAT hot tiles.
+template <SWR_TILE_MODE TileModeT, size_t NumTileModesT, size_t ArraySizeT>
+void InitStoreTilesTableColorFloat16(
+    PFN_STORE_TILES (&table)[NumTileModesT][ArraySizeT])
+{
+    table[TileModeT][R16G16B16A16_FLOAT]        = StoreMacroTile<TilingTraits<TileModeT, 64>, R16G16B16A16_FLOAT, R16G16B16A16_FLOAT>::Store;
+    table[TileModeT][R16G16B16X16_FLOAT]        = StoreMacroTile<TilingTraits<TileModeT, 64>, R16G16B16A16_FLOAT, R16G16B16X16_FLOAT>::Store;
+}
+
 //////////////////////////////////////////////////////////////////////////
 /// INIT_STORE_TILES_TABLE - Helper macro for setting up the tables.
 template <SWR_TILE_MODE TileModeT, size_t NumTileModes, size_t ArraySizeT>
@@ -1640,6 +1730,14 @@ void InitSimStoreTilesTable()
     InitStoreTilesTableColor<SWR_TILE_MODE_YMAJOR>(sStoreTilesTableColor);
     InitStoreTilesTableColor<SWR_TILE_MODE_XMAJOR>(sStoreTilesTableColor);
 
+    InitStoreTilesTableColorUnorm8<SWR_TILE_NONE>(sStoreTilesTableColorUnorm8);
+    InitStoreTilesTableColorUnorm8<SWR_TILE_MODE_YMAJOR>(sStoreTilesTableColorUnorm8);
+    InitStoreTilesTableColorUnorm8<SWR_TILE_MODE_XMAJOR>(sStoreTilesTableColorUnorm8);
+
+    InitStoreTilesTableColorFloat16<SWR_TILE_NONE>(sStoreTilesTableColorFloat16);
+    InitStoreTilesTableColorFloat16<SWR_TILE_MODE_YMAJOR>(sStoreTilesTableColorFloat16);
+    InitStoreTilesTableColorFloat16<SWR_TILE_MODE_XMAJOR>(sStoreTilesTableColorFloat16);
+
     InitStoreTilesTableDepth<SWR_TILE_MODE_YMAJOR>(sStoreTilesTableDepth);
     InitStoreTilesTableStencil<SWR_TILE_MODE_WMAJOR>(sStoreTilesTableStencil);
 }
@@ -30,6 +30,7 @@
 #include "core/state.h"
 #include "core/format_traits.h"
 #include "memory/tilingtraits.h"
+#include "memory/Convert.h"
 
 #include <algorithm>
 
@@ -153,6 +154,112 @@ struct SimdTile <R8_UINT,R8_UINT>
     }
 };
 
+//////////////////////////////////////////////////////////////////////////
+/// SimdTile - RGBA8 UNORM hot tile specialization
+//////////////////////////////////////////////////////////////////////////
+template<SWR_FORMAT SrcOrDstFormat>
+struct SimdTile <R8G8B8A8_UNORM, SrcOrDstFormat>
+{
+    // SimdTile is SOA (e.g. rrrrrrrr gggggggg bbbbbbbb aaaaaaaa )
+    uint8_t color[FormatTraits<R8G8B8A8_UNORM>::numComps][KNOB_SIMD_WIDTH];
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Retrieve color from simd.
+    /// @param index - linear index to color within simd.
+    /// @param outputColor - output color
+    INLINE void GetSwizzledColor(
+        uint32_t index,
+        float outputColor[4])
+    {
+#if (SIMD_TILE_X_DIM == 4)
+        static const uint32_t offset[] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+#elif (SIMD_TILE_X_DIM == 2)
+        static const uint32_t offset[] = { 0, 1, 2, 3 };
+#endif
+
+        for (uint32_t i = 0; i < FormatTraits<SrcOrDstFormat>::numComps; ++i)
+        {
+            outputColor[i] = this->color[FormatTraits<SrcOrDstFormat>::swizzle(i)][offset[index]] * (1.0f / 255.0f);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Retrieve color from simd.
+    /// @param index - linear index to color within simd.
+    /// @param outputColor - output color
+    INLINE void SetSwizzledColor(
+        uint32_t index,
+        const float src[4])
+    {
+#if (SIMD_TILE_X_DIM == 4)
+        static const uint32_t offset[] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+#elif (SIMD_TILE_X_DIM == 2)
+        static const uint32_t offset[] = { 0, 1, 2, 3 };
+#endif
+
+        for (uint32_t i = 0; i < FormatTraits<SrcOrDstFormat>::numComps; ++i)
+        {
+            float value = std::min(std::max(src[i], 0.0f), 1.0f);
+            this->color[i][offset[index]] = (uint8_t)(value * 255.0f + 0.5f);
+        }
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////
+/// SimdTile - RGBA16 FLOAT hot tile specialization
+//////////////////////////////////////////////////////////////////////////
+template<SWR_FORMAT SrcOrDstFormat>
+struct SimdTile <R16G16B16A16_FLOAT, SrcOrDstFormat>
+{
+    // SimdTile is SOA (e.g. rrrrrrrr gggggggg bbbbbbbb aaaaaaaa )
+    uint16_t color[FormatTraits<R16G16B16A16_FLOAT>::numComps][KNOB_SIMD_WIDTH];
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Retrieve color from simd.
+    /// @param index - linear index to color within simd.
+    /// @param outputColor - output color
+    INLINE void GetSwizzledColor(
+        uint32_t index,
+        float outputColor[4])
+    {
+#if (SIMD_TILE_X_DIM == 4)
+        static const uint32_t offset[] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+#elif (SIMD_TILE_X_DIM == 2)
+        static const uint32_t offset[] = { 0, 1, 2, 3 };
+#endif
+
+        for (uint32_t i = 0; i < FormatTraits<SrcOrDstFormat>::numComps; ++i)
+        {
+            outputColor[i] = ConvertSmallFloatTo32(this->color[FormatTraits<SrcOrDstFormat>::swizzle(i)][offset[index]]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    /// @brief Retrieve color from simd.
+    /// @param index - linear index to color within simd.
+    /// @param outputColor - output color
+    INLINE void SetSwizzledColor(
+        uint32_t index,
+        const float src[4])
+    {
+#if (SIMD_TILE_X_DIM == 4)
+        static const uint32_t offset[] = { 0, 1, 4, 5, 2, 3, 6, 7 };
+#elif (SIMD_TILE_X_DIM == 2)
+        static const uint32_t offset[] = { 0, 1, 2, 3 };
+#endif
+
+        for (uint32_t i = 0; i < FormatTraits<SrcOrDstFormat>::numComps; ++i)
+        {
+#if KNOB_ARCH == KNOB_ARCH_AVX2
+            __m128i half = _mm_cvtps_ph(_mm_set1_ps(src[i]), _MM_FROUND_TO_NEAREST_INT);
+            this->color[i][offset[index]] = (uint16_t)_mm_extract_epi16(half, 0);
+#else
+            this->color[i][offset[index]] = Convert32To16FloatRTNE(src[i]);
+#endif
+        }
+    }
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// @brief Computes lod offset for 1D surface at specified lod.
 /// @param baseWidth - width of basemip (mip 0).
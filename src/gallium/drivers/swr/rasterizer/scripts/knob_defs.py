@@ -49,6 +49,28 @@ KNOBS = [
                        'defer clear execution to first backend op on hottile, or hottile store'],
     }],
 
+    ['LOW_PRECISION_HOT_TILES', {
+        'type'      : 'bool',
+        'default'   : 'true',
+        'desc'      : ['Use RGBA8 UNORM color hot tiles for 8-bit UNORM render targets and',
+                       'RGBA16 FLOAT color hot tiles for 16-bit float render targets.',
+                       'When disabled all color hot tiles are RGBA32 FLOAT.'],
+    }],
+
+    ['VERTEX_CACHE', {
+        'type'      : 'bool',
+        'default'   : 'true',
+        'desc'      : ['Shade each index of indexed draws once per window of indices and reuse',
+                       'the shaded vertex for repeated indices. Not used with GS or tessellation.'],
+    }],
+
+    ['HIZ', {
+        'type'      : 'bool',
+        'default'   : 'true',
+        'desc'      : ['Track min/max depth per raster tile of the depth hot tile and skip',
+                       'raster tiles that a triangle cannot pass the depth test for.'],
+    }],
+
     ['MAX_NUMA_NODES', {
         'type'      : 'uint32_t',
         'default'   : '0',
@@ -73,6 +95,15 @@ KNOBS = [
                        '  N == Use at most N hyper-threads per physical core'],
     }],
 
+    ['MAX_WORKERS_PER_CONTEXT', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Maximum # of worker threads of the shared thread pool used by each context',
+                       'that does not set SWR_CREATECONTEXT_INFO::maxWorkerThreads.',
+                       '  0 == ALL worker threads',
+                       '  N == Use at most N worker threads per context'],
+    }],
+
     ['BUCKETS_START_FRAME', {
         'type'      : 'uint32_t',
         'default'   : '1200',
@@ -91,6 +122,33 @@ KNOBS = [
                        'for this to have an effect.'],
     }],
 
+    ['TRACE_FILE', {
+        'type'      : 'std::string',
+        'default'   : '""',
+        'desc'      : ['Chrome trace event JSON file that bucket spans of all threads are written to.',
+                       'Load it in chrome://tracing or Perfetto. Does not need KNOB_ENABLE_RDTSC.',
+                       '  Empty == Tracing disabled'],
+    }],
+
+    ['TRACE_START_FRAME', {
+        'type'      : 'uint32_t',
+        'default'   : '100',
+        'desc'      : ['Frame at which to start tracing, see TRACE_FILE.'],
+    }],
+
+    ['TRACE_NUM_FRAMES', {
+        'type'      : 'uint32_t',
+        'default'   : '4',
+        'desc'      : ['Number of frames to trace, the trace is written after the last one.'],
+    }],
+
+    ['TRACE_EVENTS_PER_THREAD', {
+        'type'      : 'uint32_t',
+        'default'   : '262144',
+        'desc'      : ['Size of the per thread ring buffer of trace events.',
+                       'Threads keep their most recent events once it is full.'],
+    }],
+
     ['TOSS_DRAW', {
         'type'      : 'bool',
         'default'   : 'false',
@@ -168,6 +226,51 @@ KNOBS = [
         'desc'      : ['Maximum number of draws outstanding before API thread blocks.'],
     }],
 
+    ['ARENA_CACHE_MAX_SIZE_MB', {
+        'type'      : 'uint32_t',
+        'default'   : '128',
+        'desc'      : ['High-water mark for the arena block cache, per NUMA node, in megabytes.',
+                       'Blocks returned to a full cache are freed.',
+                       '  0 == Disable caching, arena blocks are always freed on reset'],
+    }],
+
+    ['HOT_TILE_LAYERS', {
+        'type'      : 'uint32_t',
+        'default'   : '8',
+        'desc'      : ['Array slices of a render target kept in hot tiles per macrotile.',
+                       'Layered rendering to more slices than this stores and reloads the',
+                       'least recently used slice.',
+                       '  1 == One hot tile per macrotile, every slice switch stores and reloads'],
+    }],
+
+    ['HOT_TILE_BUDGET_MB', {
+        'type'      : 'uint32_t',
+        'default'   : '0',
+        'desc'      : ['Memory budget for hot tiles, per context, in megabytes. Over budget, the',
+                       'least recently used hot tiles that are in sync with their surface are',
+                       'freed, and hot tiles of surfaces that are unbound are released.',
+                       'Dirty single sample hot tiles in a format that stores losslessly are',
+                       'stored and freed too. Other dirty hot tiles stay, so a single frame can',
+                       'still exceed it.',
+                       '  0 == Unlimited, hot tiles stay allocated until the context is destroyed'],
+    }],
+
+    ['NUMA_MACROTILES', {
+        'type'      : 'bool',
+        'default'   : 'true',
+        'desc'      : ['Partition macrotiles across the NUMA nodes of the worker threads.',
+                       'Hot tiles are allocated on the node owning their macrotile and BE',
+                       'workers prefer macrotiles of their own node, stealing across nodes last.'],
+    }],
+
+    ['TILED_RESOURCES', {
+        'type'      : 'bool',
+        'default'   : 'true',
+        'desc'      : ['Lay out 2D color render targets and textures in Y-major tiles.',
+                       'Tiled surfaces keep each macrotile store and texture footprint within',
+                       'a few pages.  Disable to keep every resource linear.'],
+    }],
+
     ['MAX_PRIMS_PER_DRAW', {
        'type'       : 'uint32_t',
        'default'    : '2040',
@@ -176,6 +279,14 @@ KNOBS = [
                        'Should be a multiple of (3 * vectorWidth).'],
     }],
 
+    ['FE_CHUNKS_PER_DRAW', {
+       'type'       : 'uint32_t',
+       'default'    : '64',
+       'desc'       : ['Maximum # of splits of a large Draw() put in a single draw context.',
+                       'Workers claim the splits of a draw context and run their FE concurrently.',
+                       '  1 == Each split of a large Draw() gets its own draw context'],
+    }],
+
     ['MAX_TESS_PRIMS_PER_DRAW', {
        'type'       : 'uint32_t',
        'default'    : '16',
@@ -208,5 +319,54 @@ KNOBS = [
        'desc'       : ['Dumps shader LLVM IR at various stages of jit compilation.'],
     }],
 
+    ['JIT_ENABLE_CACHE', {
+       'type'       : 'bool',
+       'default'    : 'false',
+       'desc'       : ['Enables the persistent on-disk cache of jitted shaders,',
+                       'fetch shaders and blend functions.'],
+    }],
+
+    ['JIT_CACHE_DIR', {
+       'type'       : 'std::string',
+       'default'    : '""',
+       'desc'       : ['Directory used by the jit cache.',
+                       '  Empty == $XDG_CACHE_HOME/swr/jit (or $HOME/.cache/swr/jit)'],
+    }],
+
+    ['JIT_CACHE_MAX_SIZE_MB', {
+       'type'       : 'uint32_t',
+       'default'    : '256',
+       'desc'       : ['Maximum size of the jit cache directory in megabytes.',
+                       'Least recently used entries are evicted once exceeded.',
+                       '  0 == No limit'],
+    }],
+
+    ['DUMP_JIT_CACHE_STATS', {
+       'type'       : 'bool',
+       'default'    : 'false',
+       'desc'       : ['(DEBUG) Print the jit cache counters when the screen is destroyed.'],
+    }],
+
+    ['JIT_ASYNC_COMPILE_THREADS', {
+       'type'       : 'uint32_t',
+       'default'    : '0',
+       'desc'       : ['Number of background threads compiling fragment shader variants.',
+                       'While a variant compiles, draws use an already compiled variant',
+                       'that renders identically (one whose key only differs in the mip',
+                       'filter of level-0-only textures); otherwise they wait for it,',
+                       'unless JIT_ASYNC_SKIP_DRAWS is set.',
+                       '  0 == Compile synchronously on the API thread'],
+    }],
+
+    ['JIT_ASYNC_SKIP_DRAWS', {
+       'type'       : 'bool',
+       'default'    : 'false',
+       'desc'       : ['Drop draws whose fragment shader variant is still compiling in the',
+                       'background and has no stand-in, rather than waiting for it.  The',
+                       'frames rendered meanwhile are missing those draws.  Draws with',
+                       'stream output or active queries still wait.',
+                       'Needs JIT_ASYNC_COMPILE_THREADS.'],
+    }],
+
 
 ]
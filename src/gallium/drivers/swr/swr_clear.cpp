@@ -23,6 +23,7 @@
 
 #include "swr_context.h"
 #include "swr_query.h"
+#include "swr_scratch.h"
 
 static void
 swr_clear(struct pipe_context *pipe,
@@ -77,6 +78,16 @@ swr_clear(struct pipe_context *pipe,
    SwrSetViewports(ctx->swrContext, 1, &vp, NULL);
 
    SwrClearRenderTarget(ctx->swrContext, clearMask, color->f, depth, stencil);
+
+   /* Validation may have copied draw state into scratch space */
+   swr_fence_scratch_draw(ctx);
+
+   if (clearMask & SWR_CLEAR_COLOR)
+      ctx->dirty_attachments |= 1 << SWR_ATTACHMENT_COLOR0;
+   if (clearMask & SWR_CLEAR_DEPTH)
+      ctx->dirty_attachments |= 1 << SWR_ATTACHMENT_DEPTH;
+   if (clearMask & SWR_CLEAR_STENCIL)
+      ctx->dirty_attachments |= 1 << SWR_ATTACHMENT_STENCIL;
 }
 
 
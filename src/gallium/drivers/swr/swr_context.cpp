@@ -28,6 +28,7 @@
 extern "C" {
 #include "util/u_transfer.h"
 #include "util/u_surface.h"
+#include "util/u_box.h"
 }
 
 #include "swr_context.h"
@@ -36,8 +37,58 @@ extern "C" {
 #include "swr_resource.h"
 #include "swr_scratch.h"
 #include "swr_query.h"
+#include "swr_fence.h"
 
 #include "api.h"
+#include "memory/tilingtraits.h"
+
+/* Tiled resources are mapped through a linear copy of the mapped box */
+struct swr_transfer {
+   struct pipe_transfer base;
+   uint8_t *map;
+};
+
+/*
+ * Copy a box between a Y-major tiled level and a linear buffer.  Pieces of
+ * rows never straddle a 16 byte tile column, so each is one memcpy.
+ */
+static void
+swr_tiled_copy_box(struct swr_resource *res,
+                   unsigned level,
+                   const struct pipe_box *box,
+                   uint8_t *linear,
+                   unsigned stride,
+                   unsigned layer_stride,
+                   boolean to_tiled)
+{
+   typedef TilingTraits<SWR_TILE_MODE_YMAJOR, 32> TTraits;
+
+   assert(res->swr.tileMode == SWR_TILE_MODE_YMAJOR);
+
+   unsigned cpp = util_format_get_blocksize(res->base.format);
+   unsigned pitch = res->row_stride[level];
+   unsigned x_begin = box->x * cpp;
+   unsigned x_end = (box->x + box->width) * cpp;
+
+   for (int z = 0; z < box->depth; z++) {
+      uint8_t *slice = res->swr.pBaseAddress + res->mip_offsets[level]
+         + (box->z + z) * res->img_stride[level];
+      for (int y = 0; y < box->height; y++) {
+         uint8_t *row = linear + z * layer_stride + y * stride;
+         for (unsigned x = x_begin; x < x_end;) {
+            unsigned len = MIN2(16 - (x & 15), x_end - x);
+            uint8_t *tiled =
+               slice + ComputeOffset2D<TTraits>(pitch, x, box->y + y);
+            if (to_tiled)
+               memcpy(tiled, row, len);
+            else
+               memcpy(row, tiled, len);
+            row += len;
+            x += len;
+         }
+      }
+   }
+}
 
 static struct pipe_surface *
 swr_create_surface(struct pipe_context *pipe,
@@ -118,6 +169,75 @@ swr_surface_destroy(struct pipe_context *pipe, struct pipe_surface *surf)
 }
 
 
+/*
+ * Mesa sees Z24_UNORM_S8_UINT as one packed surface, SWR keeps stencil in a
+ * separate R8_UINT surface.  Move the stencil bytes of a row in or out of
+ * the top byte of each packed depth texel, 16 pixels at a time.
+ */
+static void
+swr_copy_stencil_row(uint32_t *depth,
+                     uint8_t *stencil,
+                     int width,
+                     boolean to_packed)
+{
+   const __m128i depth_mask = _mm_set1_epi32(0x00ffffff);
+   int x = 0;
+
+   if (to_packed) {
+      for (; x + 16 <= width; x += 16) {
+         __m128i s = _mm_loadu_si128((const __m128i *)(stencil + x));
+         for (unsigned i = 0; i < 4; i++) {
+            __m128i *p = (__m128i *)(depth + x + 4 * i);
+            __m128i d = _mm_and_si128(_mm_loadu_si128(p), depth_mask);
+            d = _mm_or_si128(d, _mm_slli_epi32(_mm_cvtepu8_epi32(s), 24));
+            _mm_storeu_si128(p, d);
+            s = _mm_srli_si128(s, 4);
+         }
+      }
+      for (; x < width; x++)
+         depth[x] = (depth[x] & 0x00ffffff) | ((uint32_t)stencil[x] << 24);
+   } else {
+      for (; x + 16 <= width; x += 16) {
+         const __m128i *p = (const __m128i *)(depth + x);
+         __m128i s0 = _mm_srli_epi32(_mm_loadu_si128(p + 0), 24);
+         __m128i s1 = _mm_srli_epi32(_mm_loadu_si128(p + 1), 24);
+         __m128i s2 = _mm_srli_epi32(_mm_loadu_si128(p + 2), 24);
+         __m128i s3 = _mm_srli_epi32(_mm_loadu_si128(p + 3), 24);
+         __m128i s = _mm_packus_epi16(_mm_packus_epi32(s0, s1),
+                                      _mm_packus_epi32(s2, s3));
+         _mm_storeu_si128((__m128i *)(stencil + x), s);
+      }
+      for (; x < width; x++)
+         stencil[x] = depth[x] >> 24;
+   }
+}
+
+/*
+ * Move the stencil of a level 0 box between the packed surface and the
+ * stencil surface, which holds as many slices as level 0.
+ */
+static void
+swr_copy_stencil_box(struct swr_resource *res,
+                     const struct pipe_box *box,
+                     boolean to_packed)
+{
+   unsigned stencil_img_stride = res->alignedHeight * res->secondary.pitch;
+
+   for (int z = box->z; z < box->z + box->depth; z++) {
+      uint8_t *depth_slice = res->swr.pBaseAddress + z * res->img_stride[0];
+      uint8_t *stencil_slice =
+         res->secondary.pBaseAddress + z * stencil_img_stride;
+
+      for (int y = box->y; y < box->y + box->height; y++) {
+         uint32_t *depth =
+            (uint32_t *)(depth_slice + y * res->swr.pitch) + box->x;
+         uint8_t *stencil =
+            stencil_slice + y * res->secondary.pitch + box->x;
+         swr_copy_stencil_row(depth, stencil, box->width, to_packed);
+      }
+   }
+}
+
 static void *
 swr_transfer_map(struct pipe_context *pipe,
                  struct pipe_resource *resource,
@@ -127,6 +247,7 @@ swr_transfer_map(struct pipe_context *pipe,
                  struct pipe_transfer **transfer)
 {
    struct swr_resource *spr = swr_resource(resource);
+   struct swr_transfer *st;
    struct pipe_transfer *pt;
    enum pipe_format format = resource->format;
 
@@ -134,46 +255,88 @@ swr_transfer_map(struct pipe_context *pipe,
    assert(level <= resource->last_level);
 
    /*
-    * If mapping any attached rendertarget, store tiles and wait for idle
-    * before giving CPU access to the surface.
-    * (set postStoreTileState to SWR_TILE_INVALID so tiles are reloaded)
+    * If mapping an attached rendertarget that has been rendered to since its
+    * last store, store tiles before giving CPU access to the surface.
+    * Read-only maps keep the hot tiles resident (SWR_TILE_RESOLVED); maps
+    * that may write set them to SWR_TILE_INVALID so tiles are reloaded.
+    * When the mapped level is the one being rendered, only hot tiles
+    * intersecting the mapped box are stored.  Only the fence of the last
+    * store into this resource is waited on, not the whole pipeline.
+    * Unsynchronized maps skip both.
     */
-   if (resource->bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL
-                         | PIPE_BIND_DISPLAY_TARGET)) {
-      struct swr_context *ctx = swr_context(pipe);
-      for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; i++)
-         if (ctx->current.attachment[i] == &spr->swr) {
-            swr_store_render_target(ctx, i, SWR_TILE_INVALID);
-            /*
-             * Mesa thinks depth/stencil are fused, so we'll never get an
-             * explicit map for stencil.  So, if mapping depth, then also
-             * store tile for stencil.
-             */
-            if (spr->has_stencil && (i == SWR_ATTACHMENT_DEPTH))
-               swr_store_render_target(
-                  ctx, SWR_ATTACHMENT_STENCIL, SWR_TILE_INVALID);
-            SwrWaitForIdle(ctx->swrContext);
-            break;
-         }
-   }
+   if (!(usage & PIPE_TRANSFER_UNSYNCHRONIZED)) {
+      if (resource->bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL
+                            | PIPE_BIND_DISPLAY_TARGET)) {
+         struct swr_context *ctx = swr_context(pipe);
+         enum SWR_TILE_STATE post_state = (usage & PIPE_TRANSFER_WRITE)
+            ? SWR_TILE_INVALID : SWR_TILE_RESOLVED;
+         for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; i++)
+            if (ctx->current.attachment[i] == &spr->swr) {
+               /*
+                * Mesa thinks depth/stencil are fused, so we'll never get an
+                * explicit map for stencil.  So, if mapping depth, then also
+                * store tile for stencil.
+                */
+               unsigned mask = 1 << i;
+               if (spr->has_stencil && (i == SWR_ATTACHMENT_DEPTH))
+                  mask |= 1 << SWR_ATTACHMENT_STENCIL;
+
+               if ((ctx->dirty_attachments & mask)
+                   || post_state == SWR_TILE_INVALID) {
+                  const struct pipe_box *store_box =
+                     (ctx->current.attachment[i]->lod == level) ? box : NULL;
+                  for (uint32_t a = i; a < SWR_NUM_ATTACHMENTS; a++)
+                     if (mask & (1 << a))
+                        swr_store_render_target(
+                           ctx, a, post_state, NULL, store_box);
+                  swr_resource_set_write_fence(
+                     spr, ctx->write_fence,
+                     swr_fence_submit(ctx, ctx->write_fence));
+               }
+               break;
+            }
+      }
 
+      swr_resource_wait_write(spr);
+   }
 
-   pt = CALLOC_STRUCT(pipe_transfer);
-   if (!pt)
+   st = CALLOC_STRUCT(swr_transfer);
+   if (!st)
       return NULL;
+   pt = &st->base;
    pipe_resource_reference(&pt->resource, resource);
    pt->level = level;
+   pt->usage = (enum pipe_transfer_usage)usage;
    pt->box = *box;
+
+   if (spr->swr.tileMode != SWR_TILE_NONE) {
+      pt->stride = align(box->width * util_format_get_blocksize(format), 16);
+      pt->layer_stride = pt->stride * box->height;
+      st->map = (uint8_t *)_aligned_malloc(pt->layer_stride * box->depth, 64);
+      if (!st->map) {
+         pipe_resource_reference(&pt->resource, NULL);
+         FREE(st);
+         return NULL;
+      }
+
+      if (!(usage & (PIPE_TRANSFER_DISCARD_RANGE
+                     | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)))
+         swr_tiled_copy_box(
+            spr, level, box, st->map, pt->stride, pt->layer_stride, FALSE);
+
+      *transfer = pt;
+      return st->map;
+   }
+
    pt->stride = spr->row_stride[level];
    pt->layer_stride = spr->img_stride[level];
 
-   /* if we're mapping the depth/stencil, copy in stencil */
+   /* if we're mapping the depth/stencil, copy in stencil of the box */
    if (spr->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
-       && spr->has_stencil) {
-      for (unsigned i = 0; i < spr->alignedWidth * spr->alignedHeight; i++) {
-         spr->swr.pBaseAddress[4 * i + 3] = spr->secondary.pBaseAddress[i];
-      }
-   }
+       && spr->has_stencil && level == 0
+       && !(usage & (PIPE_TRANSFER_DISCARD_RANGE
+                     | PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE)))
+      swr_copy_stencil_box(spr, box, TRUE);
 
    unsigned offset = box->z * pt->layer_stride + box->y * pt->stride
       + box->x * util_format_get_blocksize(format);
@@ -198,14 +361,25 @@ swr_transfer_unmap(struct pipe_context *pipe, struct pipe_transfer *transfer)
    struct swr_resource *res = swr_resource(transfer->resource);
    res->bound_to_context = (void *)pipe;
 
-   /* if we're mapping the depth/stencil, copy out stencil */
-   if (res->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
-       && res->has_stencil) {
-      for (unsigned i = 0; i < res->alignedWidth * res->alignedHeight; i++) {
-         res->secondary.pBaseAddress[i] = res->swr.pBaseAddress[4 * i + 3];
-      }
+   struct swr_transfer *st = (struct swr_transfer *)transfer;
+   if (st->map) {
+      if (transfer->usage & PIPE_TRANSFER_WRITE)
+         swr_tiled_copy_box(res,
+                            transfer->level,
+                            &transfer->box,
+                            st->map,
+                            transfer->stride,
+                            transfer->layer_stride,
+                            TRUE);
+      _aligned_free(st->map);
    }
 
+   /* if we're mapping the depth/stencil, copy out stencil of the box */
+   if (res->base.format == PIPE_FORMAT_Z24_UNORM_S8_UINT
+       && res->has_stencil && transfer->level == 0
+       && (transfer->usage & PIPE_TRANSFER_WRITE))
+      swr_copy_stencil_box(res, &transfer->box, FALSE);
+
    pipe_resource_reference(&transfer->resource, NULL);
    FREE(transfer);
 }
@@ -233,6 +407,105 @@ swr_resource_copy(struct pipe_context *pipe,
 }
 
 
+static void swr_blit(struct pipe_context *pipe,
+                     const struct pipe_blit_info *blit_info);
+
+/*
+ * Return the attachment a resource is currently bound to, or -1.
+ */
+static int
+swr_resource_attachment(struct swr_context *ctx, struct pipe_resource *resource)
+{
+   struct swr_resource *spr = swr_resource(resource);
+   for (int i = 0; i < SWR_NUM_ATTACHMENTS; i++)
+      if (ctx->current.attachment[i] == &spr->swr)
+         return i;
+   return -1;
+}
+
+
+/*
+ * Multisample color resolve.
+ *
+ * Multisampled color data only lives in the hot tiles.  StoreTiles
+ * averages the samples of each pixel as it stores a macrotile, in parallel
+ * across the workers, so once the source is stored its own storage holds
+ * the resolved image.  Unscaled resolves copy that straight into the
+ * destination; anything else blits from a single sampled copy of it.
+ */
+static void
+swr_blit_resolve(struct pipe_context *pipe, const struct pipe_blit_info *info)
+{
+   struct swr_context *ctx = swr_context(pipe);
+   struct pipe_resource *src = info->src.resource;
+   struct pipe_resource *dst = info->dst.resource;
+   struct swr_resource *src_res = swr_resource(src);
+   struct swr_resource *dst_res = swr_resource(dst);
+
+   /* Store with the tiles left resolved, rendering can continue into the
+    * multisampled hot tiles. */
+   int src_attachment = swr_resource_attachment(ctx, src);
+   if (src_attachment >= 0) {
+      swr_store_render_target(ctx, src_attachment, SWR_TILE_RESOLVED);
+      SwrWaitForIdle(ctx->swrContext);
+   }
+
+   if (info->src.format == info->dst.format
+       && src->format == dst->format
+       && info->src.box.width == info->dst.box.width
+       && info->src.box.height == info->dst.box.height
+       && info->src.box.depth == info->dst.box.depth
+       && info->src.box.width > 0 && info->src.box.height > 0
+       && (info->mask & PIPE_MASK_RGBA) == PIPE_MASK_RGBA
+       && !info->scissor_enable
+       && dst_res->swr.tileMode == SWR_TILE_NONE
+       && swr_resource_attachment(ctx, dst) < 0) {
+      unsigned level = info->dst.level;
+      util_copy_box(dst_res->swr.pBaseAddress + dst_res->mip_offsets[level],
+                    dst->format,
+                    dst_res->row_stride[level], dst_res->img_stride[level],
+                    info->dst.box.x, info->dst.box.y, info->dst.box.z,
+                    info->src.box.width, info->src.box.height,
+                    info->src.box.depth,
+                    src_res->swr.pBaseAddress,
+                    src_res->row_stride[0], src_res->img_stride[0],
+                    info->src.box.x, info->src.box.y, info->src.box.z);
+      return;
+   }
+
+   struct pipe_resource templ = *src;
+   templ.nr_samples = 0;
+   templ.bind |= PIPE_BIND_SAMPLER_VIEW;
+   struct pipe_resource *resolved =
+      pipe->screen->resource_create(pipe->screen, &templ);
+   if (!resolved) {
+      debug_printf("swr: failed to allocate resolve surface\n");
+      return;
+   }
+
+   struct swr_resource *resolved_res = swr_resource(resolved);
+   if (resolved_res->swr.tileMode != SWR_TILE_NONE) {
+      struct pipe_box box;
+      u_box_origin_2d(src->width0, src->height0, &box);
+      swr_tiled_copy_box(resolved_res, 0, &box,
+                         src_res->swr.pBaseAddress,
+                         src_res->row_stride[0], src_res->img_stride[0],
+                         TRUE);
+   } else {
+      memcpy(resolved_res->swr.pBaseAddress,
+             src_res->swr.pBaseAddress,
+             src_res->img_stride[0] * MAX2(src->array_size, 1));
+   }
+
+   struct pipe_blit_info resolve_info = *info;
+   resolve_info.src.resource = resolved;
+   resolve_info.render_condition_enable = FALSE;
+   swr_blit(pipe, &resolve_info);
+
+   pipe_resource_reference(&resolved, NULL);
+}
+
+
 static void
 swr_blit(struct pipe_context *pipe, const struct pipe_blit_info *blit_info)
 {
@@ -245,7 +518,7 @@ swr_blit(struct pipe_context *pipe, const struct pipe_blit_info *blit_info)
    if (info.src.resource->nr_samples > 1 && info.dst.resource->nr_samples <= 1
        && !util_format_is_depth_or_stencil(info.src.resource->format)
        && !util_format_is_pure_integer(info.src.resource->format)) {
-      debug_printf("swr: color resolve unimplemented\n");
+      swr_blit_resolve(pipe, &info);
       return;
    }
 
@@ -270,7 +543,7 @@ swr_blit(struct pipe_context *pipe, const struct pipe_blit_info *blit_info)
    util_blitter_save_vertex_buffer_slot(ctx->blitter, ctx->vertex_buffer);
    util_blitter_save_vertex_elements(ctx->blitter, (void *)ctx->velems);
    util_blitter_save_vertex_shader(ctx->blitter, (void *)ctx->vs);
-   /*util_blitter_save_geometry_shader(ctx->blitter, (void*)ctx->gs);*/
+   util_blitter_save_geometry_shader(ctx->blitter, (void *)ctx->gs);
    util_blitter_save_so_targets(
       ctx->blitter,
       ctx->num_so_targets,
@@ -315,6 +588,8 @@ swr_destroy(struct pipe_context *pipe)
 
    delete ctx->blendJIT;
 
+   swr_fence_reference(pipe->screen, &ctx->write_fence, NULL);
+
    swr_destroy_scratch_buffers(ctx);
 
    FREE(ctx);
@@ -348,8 +623,11 @@ swr_create_context(struct pipe_screen *screen, void *priv)
    createInfo.pfnLoadTile = swr_LoadHotTile;
    createInfo.pfnStoreTile = swr_StoreHotTile;
    createInfo.pfnClearTile = swr_StoreHotTileClear;
+   createInfo.maxWorkerThreads = 0;
    ctx->swrContext = SwrCreateContext(&createInfo);
 
+   ctx->write_fence = swr_fence_create();
+
    /* Init Load/Store/ClearTiles Tables */
    swr_InitMemoryModule();
 
@@ -47,7 +47,9 @@
 #define SWR_NEW_FRAMEBUFFER (1 << 13)
 #define SWR_NEW_CLIP (1 << 14)
 #define SWR_NEW_SO (1 << 15)
-#define SWR_NEW_ALL 0x0000ffff
+#define SWR_NEW_GS (1 << 16)
+#define SWR_NEW_GSCONSTANTS (1 << 17)
+#define SWR_NEW_ALL 0x0003ffff
 
 namespace std
 {
@@ -71,6 +73,7 @@ struct swr_context {
    struct pipe_rasterizer_state *rasterizer;
 
    struct swr_vertex_shader *vs;
+   struct swr_geometry_shader *gs;
    struct swr_fragment_shader *fs;
    struct swr_vertex_element_state *velems;
 
@@ -98,6 +101,10 @@ struct swr_context {
    boolean render_cond_cond;
    unsigned active_queries;
 
+   /* no fragment shader variant is bound while it compiles, so draws are
+    * dropped (JIT_ASYNC_SKIP_DRAWS) */
+   boolean fs_compiling;
+
    unsigned num_vertex_buffers;
    unsigned num_samplers[PIPE_SHADER_TYPES];
    unsigned num_sampler_views[PIPE_SHADER_TYPES];
@@ -118,6 +125,12 @@ struct swr_context {
    struct swr_shadow_state current;
 
    unsigned dirty; /**< Mask of SWR_NEW_x flags */
+
+   /* Attachments rendered to since their hot tiles were last stored */
+   unsigned dirty_attachments;
+
+   /* Submitted after StoreTiles to track when resource writes complete */
+   struct pipe_fence_handle *write_fence;
 };
 
 struct swr_jit_texture {
@@ -151,6 +164,9 @@ struct swr_draw_context {
    swr_jit_sampler samplersFS[PIPE_MAX_SAMPLERS];
 
    SWR_SURFACE_STATE renderTargets[SWR_NUM_ATTACHMENTS];
+
+   const float *constantGS[PIPE_MAX_CONSTANT_BUFFERS];
+   unsigned num_constantsGS[PIPE_MAX_CONSTANT_BUFFERS];
 };
 
 
@@ -160,6 +176,13 @@ swr_context(struct pipe_context *pipe)
    return (struct swr_context *)pipe;
 }
 
+/* Outputs of the last vertex processing stage feed the rasterizer */
+static INLINE struct tgsi_shader_info *
+swr_last_vertex_stage_info(struct swr_context *ctx)
+{
+   return ctx->gs ? &ctx->gs->info.base : &ctx->vs->info.base;
+}
+
 struct pipe_context *swr_create_context(struct pipe_screen *, void *priv);
 
 void swr_state_init(struct pipe_context *pipe);
@@ -109,6 +109,11 @@ Gen_swr_draw_context(JitManager *pShG)
                                     PIPE_MAX_SAMPLERS)); // samplersFS
    members.push_back(ArrayType::get(Gen_SWR_SURFACE_STATE(pShG),
                                     SWR_NUM_ATTACHMENTS)); // renderTargets
+   members.push_back(
+      ArrayType::get(PointerType::get(Type::getFloatTy(ctx), 0),
+                     PIPE_MAX_CONSTANT_BUFFERS)); // constantGS
+   members.push_back(ArrayType::get(
+      Type::getInt32Ty(ctx), PIPE_MAX_CONSTANT_BUFFERS)); // num_constantsGS
 
    return StructType::get(ctx, members, false);
 }
@@ -122,3 +127,5 @@ static const UINT swr_draw_context_samplersVS = 5;
 static const UINT swr_draw_context_texturesFS = 6;
 static const UINT swr_draw_context_samplersFS = 7;
 static const UINT swr_draw_context_renderTargets = 8;
+static const UINT swr_draw_context_constantGS = 9;
+static const UINT swr_draw_context_num_constantsGS = 10;
@@ -26,6 +26,7 @@
 #include "swr_resource.h"
 #include "swr_fence.h"
 #include "swr_query.h"
+#include "swr_scratch.h"
 #include "jit_api.h"
 
 #include "util/u_draw.h"
@@ -93,12 +94,24 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    if (ctx->dirty)
       swr_update_derived(ctx, info);
 
-   if (ctx->vs->pipe.stream_output.num_outputs) {
-      if (!ctx->vs->soFunc[info->mode]) {
+   if (ctx->fs_compiling)
+      return;
+
+   /* stream output is fed by the last vertex processing stage */
+   struct pipe_stream_output_info *so = ctx->gs
+      ? &ctx->gs->pipe.stream_output
+      : &ctx->vs->pipe.stream_output;
+   PFN_SO_FUNC *soFunc = ctx->gs ? ctx->gs->soFunc : ctx->vs->soFunc;
+
+   if (so->num_outputs) {
+      if (!soFunc[info->mode]) {
          STREAMOUT_COMPILE_STATE state = {0};
-         struct pipe_stream_output_info *so = &ctx->vs->pipe.stream_output;
 
-         state.numVertsPerPrim = u_vertices_per_prim(info->mode);
+         if (ctx->gs)
+            state.numVertsPerPrim = u_vertices_per_prim(
+               ctx->gs->info.base.properties[TGSI_PROPERTY_GS_OUTPUT_PRIM]);
+         else
+            state.numVertsPerPrim = u_vertices_per_prim(info->mode);
 
          uint32_t offsets[MAX_SO_STREAMS] = {0};
          uint32_t num = 0;
@@ -131,12 +144,12 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
          state.stream.numDecls = num;
 
          HANDLE hJitMgr = swr_screen(pipe->screen)->hJitMgr;
-         ctx->vs->soFunc[info->mode] = JitCompileStreamout(hJitMgr, state);
-         debug_printf("so shader    %p\n", ctx->vs->soFunc[info->mode]);
-         assert(ctx->vs->soFunc[info->mode] && "Error: SoShader = NULL");
+         soFunc[info->mode] = JitCompileStreamout(hJitMgr, state);
+         debug_printf("so shader    %p\n", soFunc[info->mode]);
+         assert(soFunc[info->mode] && "Error: SoShader = NULL");
       }
 
-      SwrSetSoFunc(ctx->swrContext, ctx->vs->soFunc[info->mode], 0);
+      SwrSetSoFunc(ctx->swrContext, soFunc[info->mode], 0);
    }
 
    struct swr_vertex_element_state *velems = ctx->velems;
@@ -172,6 +185,14 @@ swr_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
                        info->instance_count,
                        info->start,
                        info->start_instance);
+
+   /* Fence the scratch space the draw's constants and client arrays use */
+   swr_fence_scratch_draw(ctx);
+
+   /* Every bound attachment may now hold unstored hot tile data */
+   for (uint32_t i = 0; i < SWR_NUM_ATTACHMENTS; i++)
+      if (ctx->current.attachment[i])
+         ctx->dirty_attachments |= 1 << i;
 }
 
 
@@ -188,15 +209,25 @@ swr_flush(struct pipe_context *pipe,
     * preparation for present (swr_flush_frontbuffer)
     */
    struct pipe_surface *cb = ctx->framebuffer.cbufs[0];
-   if (cb && swr_resource(cb->texture)->display_target)
+   struct swr_resource *display = nullptr;
+   if (cb && swr_resource(cb->texture)->display_target) {
+      display = swr_resource(cb->texture);
       swr_store_render_target(ctx, SWR_ATTACHMENT_COLOR0, SWR_TILE_RESOLVED);
+   }
 
    // SwrStoreTiles is asynchronous, always submit the "flush" fence.
    // flush_frontbuffer needs it.
-   swr_fence_submit(ctx, screen->flush_fence);
+   uint64_t value = swr_fence_submit(ctx, screen->flush_fence);
+   if (display)
+      swr_resource_set_write_fence(display, screen->flush_fence, value);
 
    if (fence)
       swr_fence_reference(pipe->screen, fence, screen->flush_fence);
+
+   /* Frames rendered to a display target end when they are presented
+    * (swr_flush_frontbuffer); offscreen and headless ones have no present */
+   if ((flags & PIPE_FLUSH_END_OF_FRAME) && !display)
+      SwrEndFrame();
 }
 
 void
@@ -212,13 +243,15 @@ swr_finish(struct pipe_context *pipe)
 
 
 /*
- * Store SWR HotTiles back to RenderTarget surface.
+ * Store SWR HotTiles back to RenderTarget surface.  If box is given, only
+ * the hot tiles intersecting it are stored.
  */
 void
 swr_store_render_target(struct swr_context *ctx,
                         uint32_t attachment,
                         enum SWR_TILE_STATE post_tile_state,
-                        struct SWR_SURFACE_STATE *surface)
+                        struct SWR_SURFACE_STATE *surface,
+                        const struct pipe_box *box)
 {
    struct swr_draw_context *pDC =
       (swr_draw_context *)SwrGetPrivateContextState(ctx->swrContext);
@@ -231,36 +264,23 @@ swr_store_render_target(struct swr_context *ctx,
 
    /* Only proceed if there's a valid surface to store to */
    if (renderTarget->pBaseAddress) {
-      /* Set viewport to full renderTarget width/height and disable scissor
-       * before StoreTiles */
-      boolean change_viewport =
-         (ctx->current.vp.x != 0.0f || ctx->current.vp.y != 0.0f
-          || ctx->current.vp.width != renderTarget->width
-          || ctx->current.vp.height != renderTarget->height);
-      if (change_viewport) {
-         SWR_VIEWPORT vp = {0};
-         vp.width = renderTarget->width;
-         vp.height = renderTarget->height;
-         SwrSetViewports(ctx->swrContext, 1, &vp, NULL);
-      }
-
-      boolean scissor_enable = ctx->current.rastState.scissorEnable;
-      if (scissor_enable) {
-         ctx->current.rastState.scissorEnable = FALSE;
-         SwrSetRastState(ctx->swrContext, &ctx->current.rastState);
+      /* Store rect is independent of the current viewport and scissor */
+      SWR_RECT rect = {0, renderTarget->width, 0, renderTarget->height};
+      if (box) {
+         rect.left = MIN2((uint32_t)box->x, rect.right);
+         rect.top = MIN2((uint32_t)box->y, rect.bottom);
+         rect.right = MIN2((uint32_t)(box->x + box->width), rect.right);
+         rect.bottom = MIN2((uint32_t)(box->y + box->height), rect.bottom);
       }
 
-      SwrStoreTiles(ctx->swrContext,
-                    (enum SWR_RENDERTARGET_ATTACHMENT)attachment,
-                    post_tile_state);
+      SwrStoreTilesRect(ctx->swrContext,
+                        1 << attachment,
+                        post_tile_state,
+                        &rect);
 
-      /* Restore viewport and scissor enable */
-      if (change_viewport)
-         SwrSetViewports(ctx->swrContext, 1, &ctx->current.vp, &ctx->current.vpm);
-      if (scissor_enable) {
-         ctx->current.rastState.scissorEnable = scissor_enable;
-         SwrSetRastState(ctx->swrContext, &ctx->current.rastState);
-      }
+      /* A partial store leaves the rest of the attachment dirty */
+      if (!box && (!surface || (surface == ctx->current.attachment[attachment])))
+         ctx->dirty_attachments &= ~(1 << attachment);
 
       /* Restore surface attachment, if changed */
       if (surface && (surface != ctx->current.attachment[attachment]))
@@ -269,6 +289,31 @@ swr_store_render_target(struct swr_context *ctx,
 }
 
 
+/*
+ * Record the fence value that signals once every StoreTiles queued so far
+ * into a resource has completed.
+ */
+void
+swr_resource_set_write_fence(struct swr_resource *res,
+                             struct pipe_fence_handle *fence,
+                             uint64_t value)
+{
+   swr_fence_reference(res->base.screen, &res->write_fence, fence);
+   res->write_fence_value = value;
+}
+
+/*
+ * Wait for the last StoreTiles into a resource to land in memory.  Unlike
+ * SwrWaitForIdle, rendering queued after that store is not waited on.
+ */
+void
+swr_resource_wait_write(struct swr_resource *res)
+{
+   if (res->write_fence)
+      swr_fence_wait_value(res->write_fence, res->write_fence_value);
+}
+
+
 void
 swr_draw_init(struct pipe_context *pipe)
 {
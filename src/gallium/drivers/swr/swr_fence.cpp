@@ -39,19 +39,36 @@ swr_sync_cb(UINT64 userData, UINT64 userData2)
 {
    struct swr_fence *fence = (struct swr_fence *)userData;
 
-   fence->read = fence->write;
+   /* Syncs retire in submission order, userData2 is the submitted value */
+   fence->read = userData2;
 }
 
 /*
- * Submit an existing fence.
+ * Submit an existing fence.  Returns the value that will be signaled once
+ * all rendering queued so far has completed.
  */
-void
+uint64_t
 swr_fence_submit(struct swr_context *ctx, struct pipe_fence_handle *fh)
 {
    struct swr_fence *fence = swr_fence(fh);
 
    fence->write++;
-   SwrSync(ctx->swrContext, swr_sync_cb, (UINT64)fence, 0);
+   SwrSync(ctx->swrContext, swr_sync_cb, (UINT64)fence, fence->write);
+
+   return fence->write;
+}
+
+/*
+ * Wait until a previously submitted value of the fence has been signaled,
+ * without waiting on later submissions.
+ */
+void
+swr_fence_wait_value(struct pipe_fence_handle *fence_handle, uint64_t value)
+{
+   struct swr_fence *fence = swr_fence(fence_handle);
+
+   while (!swr_is_fence_value_done(fence, value))
+      sched_yield();
 }
 
 /*
@@ -52,6 +52,16 @@ swr_is_fence_done(struct swr_fence *fence)
    return (fence->read == fence->write);
 }
 
+/*
+ * Each submission of a fence bumps its write counter; the submitted value
+ * has retired once the back-end callback has advanced read past it.
+ */
+static INLINE boolean
+swr_is_fence_value_done(struct swr_fence *fence, uint64_t value)
+{
+   return (fence->read >= value);
+}
+
 
 void swr_fence_init(struct pipe_screen *screen);
 
@@ -65,9 +75,12 @@ boolean swr_fence_finish(struct pipe_screen *screen,
                          struct pipe_fence_handle *fence_handle,
                          uint64_t timeout);
 
-void
+uint64_t
 swr_fence_submit(struct swr_context *ctx, struct pipe_fence_handle *fence);
 
+void swr_fence_wait_value(struct pipe_fence_handle *fence_handle,
+                          uint64_t value);
+
 uint64_t swr_get_timestamp(struct pipe_screen *screen);
 
 #endif
@@ -42,7 +42,9 @@ swr_create_query(struct pipe_context *pipe, unsigned type, unsigned index)
 {
    struct swr_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES
+          || (type >= PIPE_QUERY_DRIVER_SPECIFIC
+              && type < SWR_QUERY_DRIVER_END));
    assert(index < MAX_SO_STREAMS);
 
    pq = CALLOC_STRUCT(swr_query);
@@ -170,6 +172,85 @@ swr_gather_stats(struct pipe_context *pipe, struct swr_query *pq)
 }
 
 
+static boolean
+swr_is_driver_query(struct swr_query *pq)
+{
+   return pq->type >= PIPE_QUERY_DRIVER_SPECIFIC;
+}
+
+
+/*
+ * Percentage of the available worker time between two samples spent on
+ * the given ticks.
+ */
+static uint64_t
+swr_busy_percent(uint64_t ticks,
+                 const SWR_DRIVER_COUNTERS *start,
+                 const SWR_DRIVER_COUNTERS *end,
+                 uint32_t num_workers)
+{
+   uint64_t elapsed = (end->Timestamp - start->Timestamp) * num_workers;
+
+   if (!elapsed)
+      return 0;
+
+   return MIN2(ticks * 100 / elapsed, 100);
+}
+
+
+/*
+ * Driver queries read counters the core keeps without stats enabled,
+ * so results are available at end_query without waiting on the draws.
+ */
+static void
+swr_get_driver_query_result(struct swr_query *pq,
+                            union pipe_query_result *result)
+{
+   const SWR_DRIVER_COUNTERS *start = &pq->start_counters;
+   const SWR_DRIVER_COUNTERS *end = &pq->end_counters;
+
+   switch (pq->type) {
+   case SWR_QUERY_MACROTILES:
+      result->u64 = end->MacroTiles - start->MacroTiles;
+      break;
+   case SWR_QUERY_HOT_TILE_LOADS:
+      result->u64 = end->HotTileLoads - start->HotTileLoads;
+      break;
+   case SWR_QUERY_HOT_TILE_STORES:
+      result->u64 = end->HotTileStores - start->HotTileStores;
+      break;
+   case SWR_QUERY_LAYER_ALLOCS:
+      result->u64 = end->LayerAllocs - start->LayerAllocs;
+      break;
+   case SWR_QUERY_LAYER_RELOADS:
+      result->u64 = end->LayerReloads - start->LayerReloads;
+      break;
+   case SWR_QUERY_FE_BUSY:
+      result->u64 = swr_busy_percent(
+         end->FeTicks - start->FeTicks, start, end, end->NumWorkers);
+      break;
+   case SWR_QUERY_BE_BUSY:
+      result->u64 = swr_busy_percent(
+         end->BeTicks - start->BeTicks, start, end, end->NumWorkers);
+      break;
+   case SWR_QUERY_WORKER_IDLE:
+      result->u64 = swr_busy_percent(
+         end->IdleTicks - start->IdleTicks, start, end, end->NumPoolWorkers);
+      break;
+   /* Gauges report the value at end_query */
+   case SWR_QUERY_DRAWS_IN_FLIGHT:
+      result->u64 = end->DrawsInFlight;
+      break;
+   case SWR_QUERY_ARENA_BYTES:
+      result->u64 = end->ArenaBytesInUse;
+      break;
+   default:
+      assert(0 && "Unsupported query");
+      break;
+   }
+}
+
+
 static boolean
 swr_get_query_result(struct pipe_context *pipe,
                      struct pipe_query *q,
@@ -189,6 +270,11 @@ swr_get_query_result(struct pipe_context *pipe,
       swr_fence_reference(pipe->screen, &pq->fence, NULL);
    }
 
+   if (swr_is_driver_query(pq)) {
+      swr_get_driver_query_result(pq, result);
+      return TRUE;
+   }
+
    /* XXX: Need to handle counter rollover */
 
    switch (pq->type) {
@@ -264,6 +350,11 @@ swr_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    struct swr_context *ctx = swr_context(pipe);
    struct swr_query *pq = swr_query(q);
 
+   if (swr_is_driver_query(pq)) {
+      SwrGetDriverCounters(ctx->swrContext, &pq->start_counters);
+      return true;
+   }
+
    /* Initialize Results */
    memset(&pq->start, 0, sizeof(pq->start));
    memset(&pq->end, 0, sizeof(pq->end));
@@ -287,6 +378,11 @@ swr_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct swr_context *ctx = swr_context(pipe);
    struct swr_query *pq = swr_query(q);
 
+   if (swr_is_driver_query(pq)) {
+      SwrGetDriverCounters(ctx->swrContext, &pq->end_counters);
+      return;
+   }
+
    assert(ctx->active_queries
           && "swr_end_query, there are no active queries!");
    ctx->active_queries--;
@@ -332,3 +428,80 @@ swr_query_init(struct pipe_context *pipe)
 
    ctx->active_queries = 0;
 }
+
+
+#define SWR_DRIVER_QUERY(_name, _query, _type, _max)                      \
+   {                                                                       \
+      _name, _query, {_max}, _type,                                        \
+         PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE, 0                          \
+   }
+
+static const struct pipe_driver_query_info swr_driver_queries[] = {
+   SWR_DRIVER_QUERY("SWR-macrotiles", SWR_QUERY_MACROTILES,
+                    PIPE_DRIVER_QUERY_TYPE_UINT64, 0),
+   SWR_DRIVER_QUERY("SWR-hot-tile-loads", SWR_QUERY_HOT_TILE_LOADS,
+                    PIPE_DRIVER_QUERY_TYPE_UINT64, 0),
+   SWR_DRIVER_QUERY("SWR-hot-tile-stores", SWR_QUERY_HOT_TILE_STORES,
+                    PIPE_DRIVER_QUERY_TYPE_UINT64, 0),
+   SWR_DRIVER_QUERY("SWR-layer-allocs", SWR_QUERY_LAYER_ALLOCS,
+                    PIPE_DRIVER_QUERY_TYPE_UINT64, 0),
+   SWR_DRIVER_QUERY("SWR-layer-reloads", SWR_QUERY_LAYER_RELOADS,
+                    PIPE_DRIVER_QUERY_TYPE_UINT64, 0),
+   SWR_DRIVER_QUERY("SWR-fe-busy", SWR_QUERY_FE_BUSY,
+                    PIPE_DRIVER_QUERY_TYPE_PERCENTAGE, 100),
+   SWR_DRIVER_QUERY("SWR-be-busy", SWR_QUERY_BE_BUSY,
+                    PIPE_DRIVER_QUERY_TYPE_PERCENTAGE, 100),
+   SWR_DRIVER_QUERY("SWR-worker-idle", SWR_QUERY_WORKER_IDLE,
+                    PIPE_DRIVER_QUERY_TYPE_PERCENTAGE, 100),
+   SWR_DRIVER_QUERY("SWR-draws-in-flight", SWR_QUERY_DRAWS_IN_FLIGHT,
+                    PIPE_DRIVER_QUERY_TYPE_UINT64, 0),
+   SWR_DRIVER_QUERY("SWR-arena-bytes", SWR_QUERY_ARENA_BYTES,
+                    PIPE_DRIVER_QUERY_TYPE_BYTES, 0),
+};
+
+#undef SWR_DRIVER_QUERY
+
+
+static int
+swr_get_driver_query_info(struct pipe_screen *screen,
+                          unsigned index,
+                          struct pipe_driver_query_info *info)
+{
+   if (!info)
+      return ARRAY_SIZE(swr_driver_queries);
+
+   if (index >= ARRAY_SIZE(swr_driver_queries))
+      return 0;
+
+   *info = swr_driver_queries[index];
+
+   return 1;
+}
+
+
+static int
+swr_get_driver_query_group_info(struct pipe_screen *screen,
+                                unsigned index,
+                                struct pipe_driver_query_group_info *info)
+{
+   if (!info)
+      return 1;
+
+   if (index != 0)
+      return 0;
+
+   info->name = "SWR";
+   info->type = PIPE_DRIVER_QUERY_GROUP_TYPE_CPU;
+   info->max_active_queries = ARRAY_SIZE(swr_driver_queries);
+   info->num_queries = ARRAY_SIZE(swr_driver_queries);
+
+   return 1;
+}
+
+
+void
+swr_query_screen_init(struct pipe_screen *screen)
+{
+   screen->get_driver_query_info = swr_get_driver_query_info;
+   screen->get_driver_query_group_info = swr_get_driver_query_group_info;
+}
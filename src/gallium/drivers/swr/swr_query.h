@@ -27,6 +27,23 @@
 
 #include <limits.h>
 #include "os/os_thread.h"
+#include "pipe/p_defines.h"
+#include "api.h"
+
+/* Driver specific queries, graphed by the HUD */
+enum swr_driver_query {
+   SWR_QUERY_MACROTILES = PIPE_QUERY_DRIVER_SPECIFIC,
+   SWR_QUERY_HOT_TILE_LOADS,
+   SWR_QUERY_HOT_TILE_STORES,
+   SWR_QUERY_LAYER_ALLOCS,
+   SWR_QUERY_LAYER_RELOADS,
+   SWR_QUERY_FE_BUSY,
+   SWR_QUERY_BE_BUSY,
+   SWR_QUERY_WORKER_IDLE,
+   SWR_QUERY_DRAWS_IN_FLIGHT,
+   SWR_QUERY_ARENA_BYTES,
+   SWR_QUERY_DRIVER_END
+};
 
 
 struct swr_query {
@@ -39,10 +56,16 @@ struct swr_query {
 
    struct pipe_fence_handle *fence;
 
+   /* Driver specific queries sample these instead of SWR_STATS */
+   SWR_DRIVER_COUNTERS start_counters;
+   SWR_DRIVER_COUNTERS end_counters;
+
    boolean enable_stats;
 };
 
 extern void swr_query_init(struct pipe_context *pipe);
 
+extern void swr_query_screen_init(struct pipe_screen *screen);
+
 extern boolean swr_check_render_cond(struct pipe_context *pipe);
 #endif
@@ -49,6 +49,11 @@ struct swr_resource {
 
    /* Opaque pointer to swr_context to mark resource in use */
    void *bound_to_context;
+
+   /* Fence value signaled when the last StoreTiles into this resource has
+    * landed in memory */
+   struct pipe_fence_handle *write_fence;
+   uint64_t write_fence_value;
 };
 
 
@@ -94,5 +99,12 @@ swr_resource_data(struct pipe_resource *resource)
 void swr_store_render_target(struct swr_context *ctx,
                              uint32_t attachment,
                              enum SWR_TILE_STATE post_tile_state,
-                             struct SWR_SURFACE_STATE *surface = nullptr);
+                             struct SWR_SURFACE_STATE *surface = nullptr,
+                             const struct pipe_box *box = nullptr);
+
+void swr_resource_set_write_fence(struct swr_resource *res,
+                                  struct pipe_fence_handle *fence,
+                                  uint64_t value);
+
+void swr_resource_wait_write(struct swr_resource *res);
 #endif
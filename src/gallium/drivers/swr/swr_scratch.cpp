@@ -24,9 +24,144 @@
 #include "util/u_memory.h"
 #include "swr_context.h"
 #include "swr_scratch.h"
+#include "swr_fence.h"
 #include "api.h"
 
 
+/*
+ * Free the replaced rings whose draws have all retired.  With all, free
+ * every ring, only valid once the SWR context has been destroyed.
+ */
+static void
+swr_free_retired_scratch(struct swr_scratch_buffers *scratch, boolean all)
+{
+   struct swr_retired_scratch **link = &scratch->retired;
+
+   while (*link) {
+      struct swr_retired_scratch *retired = *link;
+
+      if (all || swr_is_fence_value_done(swr_fence(scratch->fence),
+                                         retired->fence_value)) {
+         *link = retired->next;
+         align_free(retired->base);
+         FREE(retired);
+      } else {
+         link = &retired->next;
+      }
+   }
+}
+
+
+/*
+ * Fence value the scratch fence gets when it is submitted after the draw
+ * being set up, see swr_fence_scratch_draw.  Submitting it any earlier
+ * would not cover that draw.
+ */
+static uint64_t
+swr_next_draw_fence_value(struct swr_scratch_buffers *scratch)
+{
+   scratch->fence_pending = TRUE;
+   return swr_fence(scratch->fence)->write + 1;
+}
+
+
+/*
+ * Replace the ring with a larger one.  Queued draws and the draw being set
+ * up may still read the old ring, so it is freed once the fence submitted
+ * after that draw retires instead of idling the pipeline.
+ */
+static void
+swr_grow_scratch_space(struct swr_context *ctx,
+                       struct swr_scratch_space *space,
+                       unsigned int size)
+{
+   struct swr_scratch_buffers *scratch = ctx->scratch;
+
+   swr_free_retired_scratch(scratch, FALSE);
+
+   if (space->base) {
+      struct swr_retired_scratch *retired =
+         CALLOC_STRUCT(swr_retired_scratch);
+      retired->base = space->base;
+      retired->fence_value = swr_next_draw_fence_value(scratch);
+      retired->next = scratch->retired;
+      scratch->retired = retired;
+   }
+
+   space->current_size = size;
+   space->base = (BYTE *)align_malloc(space->current_size, 4);
+   space->head = space->base;
+   space->segment = 0;
+   memset(space->segment_fence, 0, sizeof(space->segment_fence));
+}
+
+
+/*
+ * Reserve size bytes of the ring, entering new segments as needed.
+ */
+static void *
+swr_alloc_scratch_space(struct swr_context *ctx,
+                        struct swr_scratch_space *space,
+                        unsigned int size)
+{
+   struct swr_scratch_buffers *scratch = ctx->scratch;
+   struct swr_fence *fence = swr_fence(scratch->fence);
+
+   /* Allocate enough so that MAX_DRAWS_IN_FLIGHT sets fit. */
+   unsigned int max_size_in_flight = size * KNOB_MAX_DRAWS_IN_FLIGHT;
+
+   /* Need to grow space, this is infrequent */
+   if (max_size_in_flight > space->current_size)
+      swr_grow_scratch_space(ctx, space, max_size_in_flight);
+
+   BYTE *head;
+   unsigned int last;
+   for (;;) {
+      head = (BYTE *)space->head;
+
+      /* Wrap */
+      if ((head + size) > ((BYTE *)space->base + space->current_size))
+         head = (BYTE *)space->base;
+
+      unsigned int segment_size = space->current_size / SWR_SCRATCH_SEGMENTS;
+      last = MIN2((head + size - 1 - (BYTE *)space->base) / segment_size,
+                  SWR_SCRATCH_SEGMENTS - 1);
+
+      /*
+       * A segment still waiting on the fence of the draw being set up holds
+       * that draw's own data, so the ring is too small for one draw.
+       */
+      boolean overrun = FALSE;
+      for (unsigned int s = space->segment; s != last;) {
+         s = (s + 1) % SWR_SCRATCH_SEGMENTS;
+         if (space->segment_fence[s] > fence->write)
+            overrun = TRUE;
+      }
+      if (!overrun)
+         break;
+
+      swr_grow_scratch_space(ctx, space, space->current_size * 2);
+   }
+
+   /*
+    * Entering new segments: fence the draws that used the segment being
+    * left and wait for the ones that used the entered segments last pass.
+    */
+   if (space->segment != last) {
+      uint64_t value = swr_next_draw_fence_value(scratch);
+      while (space->segment != last) {
+         space->segment_fence[space->segment] = value;
+         space->segment = (space->segment + 1) % SWR_SCRATCH_SEGMENTS;
+         swr_fence_wait_value(scratch->fence,
+                              space->segment_fence[space->segment]);
+      }
+   }
+
+   space->head = head + size;
+   return head;
+}
+
+
 void *
 swr_copy_to_scratch_space(struct swr_context *ctx,
                           struct swr_scratch_space *space,
@@ -42,43 +177,7 @@ swr_copy_to_scratch_space(struct swr_context *ctx,
       /* Use per draw SwrAllocDrawContextMemory for larger copies */
       ptr = SwrAllocDrawContextMemory(ctx->swrContext, size, 4);
    } else {
-      /* Allocate enough so that MAX_DRAWS_IN_FLIGHT sets fit. */
-      unsigned int max_size_in_flight = size * KNOB_MAX_DRAWS_IN_FLIGHT;
-
-      /* Need to grow space */
-      if (max_size_in_flight > space->current_size) {
-         /* Must idle the pipeline, this is infrequent */
-         SwrWaitForIdle(ctx->swrContext);
-
-         space->current_size = max_size_in_flight;
-
-         if (space->base) {
-            align_free(space->base);
-            space->base = NULL;
-         }
-
-         if (!space->base) {
-            space->base = (BYTE *)align_malloc(space->current_size, 4);
-            space->head = (void *)space->base;
-         }
-      }
-
-      /* Wrap */
-      if (((BYTE *)space->head + size)
-          >= ((BYTE *)space->base + space->current_size)) {
-         /*
-          * TODO XXX: Should add a fence on wrap.  Assumption is that
-          * current_space >> size, and there are at least MAX_DRAWS_IN_FLIGHT
-          * draws in scratch.  So fence would always be met on wrap.  A fence
-          * would ensure that first frame in buffer is done before wrapping.
-          * If fence ever needs to be waited on, can increase buffer size.
-          * So far in testing, this hasn't been necessary.
-          */
-         space->head = space->base;
-      }
-
-      ptr = space->head;
-      space->head = (BYTE *)space->head + size;
+      ptr = swr_alloc_scratch_space(ctx, space, size);
    }
 
    /* Copy user_buffer to scratch */
@@ -88,12 +187,25 @@ swr_copy_to_scratch_space(struct swr_context *ctx,
 }
 
 
+void
+swr_fence_scratch_draw(struct swr_context *ctx)
+{
+   struct swr_scratch_buffers *scratch = ctx->scratch;
+
+   if (scratch->fence_pending) {
+      swr_fence_submit(ctx, scratch->fence);
+      scratch->fence_pending = FALSE;
+   }
+}
+
+
 void
 swr_init_scratch_buffers(struct swr_context *ctx)
 {
    struct swr_scratch_buffers *scratch;
 
    scratch = CALLOC_STRUCT(swr_scratch_buffers);
+   scratch->fence = swr_fence_create();
    ctx->scratch = scratch;
 }
 
@@ -105,12 +217,16 @@ swr_destroy_scratch_buffers(struct swr_context *ctx)
    if (scratch) {
       if (scratch->vs_constants.base)
          align_free(scratch->vs_constants.base);
+      if (scratch->gs_constants.base)
+         align_free(scratch->gs_constants.base);
       if (scratch->fs_constants.base)
          align_free(scratch->fs_constants.base);
       if (scratch->vertex_buffer.base)
          align_free(scratch->vertex_buffer.base);
       if (scratch->index_buffer.base)
          align_free(scratch->index_buffer.base);
+      swr_free_retired_scratch(scratch, TRUE);
+      swr_fence_reference(ctx->pipe.screen, &scratch->fence, NULL);
       FREE(scratch);
    }
 }
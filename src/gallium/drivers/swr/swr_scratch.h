@@ -24,19 +24,44 @@
 #ifndef SWR_SCRATCH_H
 #define SWR_SCRATCH_H
 
+/* Number of fenced segments of a scratch ring */
+#define SWR_SCRATCH_SEGMENTS 4
+
 struct swr_scratch_space {
    void *head;
    unsigned int current_size;
-   /* TODO XXX: Add a fence for wrap condition. */
 
+   /*
+    * Leaving a segment records the fence value submitted after the next
+    * draw, which covers every draw that used it.  The head only enters a
+    * segment again once that value has retired, so wrapping waits on old
+    * draws rather than the pipeline.
+    */
+   uint64_t segment_fence[SWR_SCRATCH_SEGMENTS];
+   unsigned int segment;
+
+   void *base;
+};
+
+/* Ring replaced by a larger one, freed once its last draw retires */
+struct swr_retired_scratch {
    void *base;
+   uint64_t fence_value;
+   struct swr_retired_scratch *next;
 };
 
 struct swr_scratch_buffers {
    struct swr_scratch_space vs_constants;
+   struct swr_scratch_space gs_constants;
    struct swr_scratch_space fs_constants;
    struct swr_scratch_space vertex_buffer;
    struct swr_scratch_space index_buffer;
+
+   struct pipe_fence_handle *fence;
+   struct swr_retired_scratch *retired;
+
+   /* Some segment or ring waits on the fence of the next draw */
+   boolean fence_pending;
 };
 
 
@@ -46,7 +71,7 @@ struct swr_scratch_buffers {
  * Used to store temporary data such as client arrays and constants.
  *
  * Inputs:
- *   space ptr to scratch pool (vs_constants, fs_constants)
+ *   space ptr to scratch pool (vs_constants, gs_constants, fs_constants)
  *   user_buffer, data to copy into scratch space
  *   size to be copied
  * Returns:
@@ -57,6 +82,14 @@ void *swr_copy_to_scratch_space(struct swr_context *ctx,
                                 const void *user_buffer,
                                 unsigned int size);
 
+/*
+ * swr_fence_scratch_draw
+ * Submits the scratch fence if the draw just queued used scratch space
+ * that is waiting to be fenced.  Called after every SwrDraw and SwrDispatch
+ * whose state went through swr_copy_to_scratch_space.
+ */
+void swr_fence_scratch_draw(struct swr_context *ctx);
+
 void swr_init_scratch_buffers(struct swr_context *ctx);
 void swr_destroy_scratch_buffers(struct swr_context *ctx);
 
@@ -39,6 +39,8 @@ extern "C" {
 #include "swr_context.h"
 #include "swr_resource.h"
 #include "swr_fence.h"
+#include "swr_query.h"
+#include "swr_state.h"
 #include "gen_knobs.h"
 
 #include "jit_api.h"
@@ -80,8 +82,17 @@ swr_is_format_supported(struct pipe_screen *screen,
    if (!format_desc)
       return FALSE;
 
-   if (sample_count > 1)
-      return FALSE;
+   /* Multisampled data only lives in the hot tiles. Storing the tiles
+    * resolves them, so multisample resources can be rendered to but not
+    * sampled from.
+    */
+   if (sample_count > 1) {
+      if (sample_count > SWR_MAX_NUM_MULTISAMPLES
+          || !util_is_power_of_two(sample_count))
+         return FALSE;
+      if (bind & ~(PIPE_BIND_RENDER_TARGET | PIPE_BIND_DEPTH_STENCIL))
+         return FALSE;
+   }
 
    if (bind
        & (PIPE_BIND_DISPLAY_TARGET | PIPE_BIND_SCANOUT | PIPE_BIND_SHARED)) {
@@ -316,10 +327,22 @@ swr_get_shader_param(struct pipe_screen *screen,
                      unsigned shader,
                      enum pipe_shader_cap param)
 {
-   if (shader == PIPE_SHADER_VERTEX || shader == PIPE_SHADER_FRAGMENT)
+   if (shader == PIPE_SHADER_GEOMETRY) {
+      /* no sampler is handed to the GS jit yet */
+      switch (param) {
+      case PIPE_SHADER_CAP_MAX_TEXTURE_SAMPLERS:
+      case PIPE_SHADER_CAP_MAX_SAMPLER_VIEWS:
+         return 0;
+      default:
+         break;
+      }
+   }
+
+   if (shader == PIPE_SHADER_VERTEX || shader == PIPE_SHADER_FRAGMENT
+       || shader == PIPE_SHADER_GEOMETRY)
       return gallivm_get_shader_param(param);
 
-   // Todo: geometry, tesselation, compute
+   // Todo: tesselation, compute
    return 0;
 }
 
@@ -416,6 +439,43 @@ swr_displaytarget_layout(struct swr_screen *screen, struct swr_resource *res)
    return TRUE;
 }
 
+/*
+ * 2D color render targets and textures are laid out in Y-major tiles, which
+ * Load/StoreTiles and the gallivm sampler both address directly.  Anything
+ * the winsys or a compute resource binding treat as linear memory stays
+ * linear, as do depth/stencil (the stencil plane is interleaved linearly on
+ * map) and formats whose texels could straddle a 16 byte tile column.
+ */
+static boolean
+swr_resource_use_tiling(const struct pipe_resource *templat,
+                        const struct util_format_description *desc,
+                        const SWR_FORMAT_INFO &finfo)
+{
+   if (!KNOB_TILED_RESOURCES)
+      return FALSE;
+
+   if (templat->target != PIPE_TEXTURE_2D
+       && templat->target != PIPE_TEXTURE_RECT)
+      return FALSE;
+
+   if (!(templat->bind & (PIPE_BIND_RENDER_TARGET | PIPE_BIND_SAMPLER_VIEW)))
+      return FALSE;
+
+   if (templat->bind & (PIPE_BIND_DEPTH_STENCIL | PIPE_BIND_DISPLAY_TARGET
+                        | PIPE_BIND_SCANOUT | PIPE_BIND_SHARED
+                        | PIPE_BIND_COMPUTE_RESOURCE | PIPE_BIND_LINEAR))
+      return FALSE;
+
+   if (templat->nr_samples > 1 || util_format_is_depth_or_stencil(templat->format))
+      return FALSE;
+
+   if (desc->block.width != 1 || desc->block.height != 1
+       || desc->block.bits / 8 != finfo.Bpp)
+      return FALSE;
+
+   return util_is_power_of_two(finfo.Bpp) && finfo.Bpp <= 16;
+}
+
 static struct pipe_resource *
 swr_resource_create(struct pipe_screen *_screen,
                     const struct pipe_resource *templat)
@@ -444,17 +504,20 @@ swr_resource_create(struct pipe_screen *_screen,
    res->swr.height = templat->height0;
    res->swr.depth = templat->depth0;
    res->swr.type = SURFACE_2D;
-   res->swr.tileMode = SWR_TILE_NONE;
    res->swr.format = mesa_to_swr_format(fmt);
-   res->swr.numSamples = (1 << templat->nr_samples);
+   res->swr.numSamples = MAX2(templat->nr_samples, 1);
 
    SWR_FORMAT_INFO finfo = GetFormatInfo(res->swr.format);
 
+   boolean tiled = swr_resource_use_tiling(templat, desc, finfo);
+   res->swr.tileMode = tiled ? SWR_TILE_MODE_YMAJOR : SWR_TILE_NONE;
+
    unsigned total_size = 0;
    unsigned width = templat->width0;
    unsigned height = templat->height0;
    unsigned depth = templat->depth0;
    unsigned layers = templat->array_size;
+   unsigned base_slices = 1;
 
    for (int level = 0; level <= templat->last_level; level++) {
       unsigned alignedWidth, alignedHeight;
@@ -471,6 +534,13 @@ swr_resource_create(struct pipe_screen *_screen,
          alignedHeight = height;
       }
 
+      /* Whole 128 byte x 32 row tiles, so every level starts on a 4KB
+       * boundary */
+      if (tiled) {
+         alignedWidth = align(alignedWidth, 128 / finfo.Bpp);
+         alignedHeight = align(alignedHeight, 32);
+      }
+
       if (level == 0) {
          res->alignedWidth = alignedWidth;
          res->alignedHeight = alignedHeight;
@@ -490,6 +560,9 @@ swr_resource_create(struct pipe_screen *_screen,
       else
          num_slices = 1;
 
+      if (level == 0)
+         base_slices = num_slices;
+
       total_size += res->img_stride[level] * num_slices;
 
       width = u_minify(width, 1);
@@ -500,7 +573,8 @@ swr_resource_create(struct pipe_screen *_screen,
    res->swr.halign = res->alignedWidth;
    res->swr.valign = res->alignedHeight;
    res->swr.pitch = res->row_stride[0];
-   res->swr.pBaseAddress = (BYTE *)_aligned_malloc(total_size, 64);
+   res->swr.pBaseAddress =
+      (BYTE *)_aligned_malloc(total_size, tiled ? 4096 : 64);
 
    if (res->has_depth && res->has_stencil) {
       res->secondary.width = templat->width0;
@@ -509,12 +583,13 @@ swr_resource_create(struct pipe_screen *_screen,
       res->secondary.type = SURFACE_2D;
       res->secondary.tileMode = SWR_TILE_NONE;
       res->secondary.format = R8_UINT;
-      res->secondary.numSamples = (1 << templat->nr_samples);
+      res->secondary.numSamples = MAX2(templat->nr_samples, 1);
 
+      /* every slice of level 0 has its stencil mapped through here */
       SWR_FORMAT_INFO finfo = GetFormatInfo(res->secondary.format);
       res->secondary.pitch = res->alignedWidth * finfo.Bpp;
       res->secondary.pBaseAddress = (BYTE *)_aligned_malloc(
-         res->alignedHeight * res->secondary.pitch, 64);
+         res->alignedHeight * res->secondary.pitch * base_slices, 64);
    }
 
    if (swr_resource_is_texture(&res->base)) {
@@ -563,6 +638,8 @@ swr_resource_destroy(struct pipe_screen *p_screen, struct pipe_resource *pt)
    _aligned_free(res->swr.pBaseAddress);
    _aligned_free(res->secondary.pBaseAddress);
 
+   swr_fence_reference(p_screen, &res->write_fence, NULL);
+
    FREE(res);
 }
 
@@ -594,6 +671,9 @@ swr_flush_frontbuffer(struct pipe_screen *p_screen,
    if (res->display_target)
       winsys->displaytarget_display(
          winsys, res->display_target, context_private, sub_box);
+
+   /* Presenting ends a frame for the RDTSC buckets and trace capture */
+   SwrEndFrame();
 }
 
 
@@ -608,6 +688,22 @@ swr_destroy_screen(struct pipe_screen *p_screen)
    swr_fence_finish(p_screen, screen->flush_fence, 0);
    swr_fence_reference(p_screen, &screen->flush_fence, NULL);
 
+   if (screen->compile_queue)
+      swr_compile_queue_destroy(screen->compile_queue);
+
+   if (KNOB_JIT_ENABLE_CACHE && KNOB_DUMP_JIT_CACHE_STATS) {
+      JIT_CACHE_STATS stats;
+      JitGetCacheStats(screen->hJitMgr, stats);
+      fprintf(stderr,
+              "SWR jit cache: %llu hits, %llu misses, %llu stores, "
+              "%llu evictions, %llu KB on disk\n",
+              (unsigned long long)stats.hits,
+              (unsigned long long)stats.misses,
+              (unsigned long long)stats.stores,
+              (unsigned long long)stats.evictions,
+              (unsigned long long)(stats.bytesOnDisk / 1024));
+   }
+
    JitDestroyContext(screen->hJitMgr);
 
    if (winsys->destroy)
@@ -660,7 +756,12 @@ swr_create_screen(struct sw_winsys *winsys)
 
    screen->hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, KNOB_ARCH_STR);
 
+   if (KNOB_JIT_ASYNC_COMPILE_THREADS)
+      screen->compile_queue =
+         swr_compile_queue_create(KNOB_JIT_ASYNC_COMPILE_THREADS);
+
    swr_fence_init(&screen->base);
+   swr_query_screen_init(&screen->base);
 
    return &screen->base;
 }
@@ -38,6 +38,9 @@ struct swr_screen {
    struct sw_winsys *winsys;
 
    HANDLE hJitMgr;
+
+   /* background fragment shader compiles, NULL if compiling inline */
+   struct swr_compile_queue *compile_queue;
 };
 
 static INLINE struct swr_screen *
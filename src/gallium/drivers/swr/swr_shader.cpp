@@ -21,7 +21,15 @@
  * IN THE SOFTWARE.
  ***************************************************************************/
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "JitManager.h"
+#include "jit_api.h"
 #include "state.h"
 #include "state_llvm.h"
 #include "builder.h"
@@ -30,6 +38,8 @@
 #include "llvm/Support/CBindingWrapping.h"
 
 #include "tgsi/tgsi_strings.h"
+#include "tgsi/tgsi_parse.h"
+#include "util/u_format.h"
 #include "gallivm/lp_bld_init.h"
 #include "gallivm/lp_bld_flow.h"
 #include "gallivm/lp_bld_struct.h"
@@ -39,24 +49,46 @@
 #include "swr_context_llvm.h"
 #include "swr_state.h"
 #include "swr_screen.h"
+#include "swr_resource.h"
 
 bool operator==(const swr_jit_key &lhs, const swr_jit_key &rhs)
 {
    return !memcmp(&lhs, &rhs, sizeof(lhs));
 }
 
+bool operator==(const swr_gs_key &lhs, const swr_gs_key &rhs)
+{
+   return !memcmp(&lhs, &rhs, sizeof(lhs));
+}
+
+/*
+ * The texel addressing of tiled resources is baked into the sampling code.
+ */
+static void
+swr_sampler_static_texture_state(struct lp_static_texture_state *state,
+                                 const struct pipe_sampler_view *view)
+{
+   lp_sampler_static_texture_state(state, view);
+
+   if (view && view->texture && view->texture->target != PIPE_BUFFER)
+      state->tiled =
+         swr_resource(view->texture)->swr.tileMode == SWR_TILE_MODE_YMAJOR;
+}
+
 void
 swr_generate_fs_key(struct swr_jit_key &key,
                     struct swr_context *ctx,
                     swr_fragment_shader *swr_fs)
 {
+   struct tgsi_shader_info *vs_info = swr_last_vertex_stage_info(ctx);
+
    key.nr_cbufs = ctx->framebuffer.nr_cbufs;
    key.light_twoside = ctx->rasterizer->light_twoside;
    memcpy(&key.vs_output_semantic_name,
-          &ctx->vs->info.base.output_semantic_name,
+          &vs_info->output_semantic_name,
           sizeof(key.vs_output_semantic_name));
    memcpy(&key.vs_output_semantic_idx,
-          &ctx->vs->info.base.output_semantic_index,
+          &vs_info->output_semantic_index,
           sizeof(key.vs_output_semantic_idx));
 
    key.nr_samplers = swr_fs->info.base.file_max[TGSI_FILE_SAMPLER] + 1;
@@ -79,7 +111,7 @@ swr_generate_fs_key(struct swr_jit_key &key,
          swr_fs->info.base.file_max[TGSI_FILE_SAMPLER_VIEW] + 1;
       for (unsigned i = 0; i < key.nr_sampler_views; i++) {
          if (swr_fs->info.base.file_mask[TGSI_FILE_SAMPLER_VIEW] & (1 << i)) {
-            lp_sampler_static_texture_state(
+            swr_sampler_static_texture_state(
                &key.sampler[i].texture_state,
                ctx->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
@@ -88,7 +120,7 @@ swr_generate_fs_key(struct swr_jit_key &key,
       key.nr_sampler_views = key.nr_samplers;
       for (unsigned i = 0; i < key.nr_sampler_views; i++) {
          if (swr_fs->info.base.file_mask[TGSI_FILE_SAMPLER] & (1 << i)) {
-            lp_sampler_static_texture_state(
+            swr_sampler_static_texture_state(
                &key.sampler[i].texture_state,
                ctx->sampler_views[PIPE_SHADER_FRAGMENT][i]);
          }
@@ -100,18 +132,109 @@ swr_generate_fs_key(struct swr_jit_key &key,
           sizeof(struct pipe_alpha_state));
 }
 
+void
+swr_generate_gs_key(struct swr_gs_key &key,
+                    struct swr_context *ctx,
+                    swr_geometry_shader *swr_gs)
+{
+   struct tgsi_shader_info *gs_info = &swr_gs->info.base;
+   struct tgsi_shader_info *vs_info = &ctx->vs->info.base;
+
+   memset(&key, 0, sizeof(key));
+
+   for (unsigned i = 0; i < gs_info->num_inputs; i++) {
+      key.input_slot[i] = SWR_GS_INPUT_UNLINKED;
+      for (unsigned j = 0; j < vs_info->num_outputs; j++) {
+         if ((vs_info->output_semantic_name[j]
+              == gs_info->input_semantic_name[i])
+             && (vs_info->output_semantic_index[j]
+                 == gs_info->input_semantic_index[i])) {
+            key.input_slot[i] = j;
+            break;
+         }
+      }
+   }
+}
+
+/*
+ * Jit cache keys.  The shader tokens are stored along with the variant key
+ * since the key alone doesn't identify the shader.
+ */
+static std::string
+swr_cache_key(const struct tgsi_token *tokens, const void *key, size_t size)
+{
+   std::string cache_key((const char *)tokens,
+                         tgsi_num_tokens(tokens) * sizeof(struct tgsi_token));
+   cache_key.append((const char *)key, size);
+   return cache_key;
+}
+
+static std::string
+swr_vs_cache_key(swr_vertex_shader *swr_vs)
+{
+   return swr_cache_key(swr_vs->pipe.tokens, NULL, 0);
+}
+
+static std::string
+swr_gs_cache_key(swr_geometry_shader *swr_gs, swr_gs_key &key)
+{
+   return swr_cache_key(swr_gs->pipe.tokens, &key, sizeof(key));
+}
+
+static std::string
+swr_fs_cache_key(swr_fragment_shader *swr_fs, swr_jit_key &key)
+{
+   return swr_cache_key(swr_fs->pipe.tokens, &key, sizeof(key));
+}
+
 struct BuilderSWR : public Builder {
-   BuilderSWR(JitManager *pJitMgr)
+   BuilderSWR(JitManager *pJitMgr, const char *pCacheTag,
+              const std::string &cacheKey)
       : Builder(pJitMgr)
    {
-      pJitMgr->SetupNewModule();
+      pJitMgr->SetupNewModule(pCacheTag, cacheKey.data(),
+                              (uint32_t)cacheKey.size());
    }
 
+   void UseJitCache(struct gallivm_state *gallivm);
+
    PFN_VERTEX_FUNC
    CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs);
-   PFN_PIXEL_KERNEL CompileFS(struct swr_context *ctx, swr_jit_key &key);
+   PFN_GS_FUNC
+   CompileGS(swr_geometry_shader *swr_gs, swr_gs_key &key);
+   PFN_PIXEL_KERNEL CompileFS(swr_fs_compile_job &job);
+
+   LLVMValueRef
+   swr_gs_llvm_fetch_input(const struct lp_build_tgsi_gs_iface *gs_iface,
+                           struct lp_build_tgsi_context *bld_base,
+                           boolean is_vindex_indirect,
+                           LLVMValueRef vertex_index,
+                           boolean is_aindex_indirect,
+                           LLVMValueRef attrib_index,
+                           LLVMValueRef swizzle_index);
+   void
+   swr_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_iface,
+                           struct lp_build_tgsi_context *bld_base,
+                           LLVMValueRef (*outputs)[4],
+                           LLVMValueRef emitted_vertices_vec);
+   void
+   swr_gs_llvm_epilogue(const struct lp_build_tgsi_gs_iface *gs_iface,
+                        struct lp_build_tgsi_context *bld_base,
+                        LLVMValueRef total_emitted_vertices_vec,
+                        LLVMValueRef emitted_prims_vec);
 };
 
+/*
+ * gallivm creates its own MCJIT engine per shader; hook it up to the jit
+ * cache before the first function lookup triggers codegen.
+ */
+void
+BuilderSWR::UseJitCache(struct gallivm_state *gallivm)
+{
+   if (JM()->mCache.IsEnabled())
+      unwrap(gallivm->engine)->setObjectCache(&JM()->mCache);
+}
+
 PFN_VERTEX_FUNC
 BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
 {
@@ -223,6 +346,7 @@ BuilderSWR::CompileVS(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
 
    gallivm_verify_function(gallivm, wrap(pFunction));
    gallivm_compile_module(gallivm);
+   UseJitCache(gallivm);
 
    //   lp_debug_dump_value(func);
 
@@ -243,10 +367,378 @@ PFN_VERTEX_FUNC
 swr_compile_vs(struct pipe_context *ctx, swr_vertex_shader *swr_vs)
 {
    BuilderSWR builder(
-      reinterpret_cast<JitManager *>(swr_screen(ctx->screen)->hJitMgr));
+      reinterpret_cast<JitManager *>(swr_screen(ctx->screen)->hJitMgr),
+      "VS",
+      swr_vs_cache_key(swr_vs));
    return builder.CompileVS(ctx, swr_vs);
 }
 
+/*
+ * Geometry shader outputs go straight into the core's GS output stream.
+ * Each SIMD lane (input primitive) owns a run of simdvertex batches in
+ * which emitted vertex n sits in batch n / SIMD width, lane n % SIMD width,
+ * with a bit per vertex in the cut buffer marking the end of a strip.
+ */
+struct swr_gs_llvm_iface {
+   struct lp_build_tgsi_gs_iface base;
+   struct tgsi_shader_info *info;
+
+   BuilderSWR *pBuilder;
+   swr_gs_key *key;
+
+   Value *pGsCtx;
+   Value *pStream;
+   Value *pCutBuffer;
+
+   uint32_t maxVerts;
+   uint32_t inputPrimStride;
+   uint32_t cutPrimStride;
+};
+
+static LLVMValueRef
+swr_gs_llvm_fetch_input(const struct lp_build_tgsi_gs_iface *gs_iface,
+                        struct lp_build_tgsi_context *bld_base,
+                        boolean is_vindex_indirect,
+                        LLVMValueRef vertex_index,
+                        boolean is_aindex_indirect,
+                        LLVMValueRef attrib_index,
+                        LLVMValueRef swizzle_index)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+   return iface->pBuilder->swr_gs_llvm_fetch_input(gs_iface,
+                                                   bld_base,
+                                                   is_vindex_indirect,
+                                                   vertex_index,
+                                                   is_aindex_indirect,
+                                                   attrib_index,
+                                                   swizzle_index);
+}
+
+static void
+swr_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_iface,
+                        struct lp_build_tgsi_context *bld_base,
+                        LLVMValueRef (*outputs)[4],
+                        LLVMValueRef emitted_vertices_vec)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+   iface->pBuilder->swr_gs_llvm_emit_vertex(
+      gs_iface, bld_base, outputs, emitted_vertices_vec);
+}
+
+/*
+ * Nothing to do here: the cut is recorded by the next emit, which sees the
+ * lane's primitive vertex count gallivm resets on ENDPRIM.
+ */
+static void
+swr_gs_llvm_end_primitive(const struct lp_build_tgsi_gs_iface *gs_iface,
+                          struct lp_build_tgsi_context *bld_base,
+                          LLVMValueRef verts_per_prim_vec,
+                          LLVMValueRef emitted_prims_vec)
+{
+}
+
+static void
+swr_gs_llvm_epilogue(const struct lp_build_tgsi_gs_iface *gs_iface,
+                     struct lp_build_tgsi_context *bld_base,
+                     LLVMValueRef total_emitted_vertices_vec,
+                     LLVMValueRef emitted_prims_vec)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+   iface->pBuilder->swr_gs_llvm_epilogue(
+      gs_iface, bld_base, total_emitted_vertices_vec, emitted_prims_vec);
+}
+
+LLVMValueRef
+BuilderSWR::swr_gs_llvm_fetch_input(const struct lp_build_tgsi_gs_iface *gs_iface,
+                                    struct lp_build_tgsi_context *bld_base,
+                                    boolean is_vindex_indirect,
+                                    LLVMValueRef vertex_index,
+                                    boolean is_aindex_indirect,
+                                    LLVMValueRef attrib_index,
+                                    LLVMValueRef swizzle_index)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+
+   IRB()->SetInsertPoint(unwrap(LLVMGetInsertBlock(gallivm->builder)));
+
+   uint32_t swizzle = IMMED(unwrap(swizzle_index));
+
+   if (!is_vindex_indirect && !is_aindex_indirect) {
+      uint32_t vertex = IMMED(unwrap(vertex_index));
+      uint32_t slot = iface->key->input_slot[IMMED(unwrap(attrib_index))];
+
+      if (slot == SWR_GS_INPUT_UNLINKED)
+         return wrap(VIMMED1(0.0f));
+
+      return wrap(LOAD(iface->pGsCtx,
+                       {0, SWR_GS_CONTEXT_vert, vertex, 0, slot, swizzle}));
+   }
+
+   Value *vVertex = is_vindex_indirect
+      ? unwrap(vertex_index)
+      : VIMMED1((int)IMMED(unwrap(vertex_index)));
+
+   Value *vSlot;
+   if (is_aindex_indirect) {
+      Value *vAttrib = unwrap(attrib_index);
+      vSlot = VIMMED1(0);
+      for (unsigned i = 0; i < iface->info->num_inputs; i++) {
+         uint32_t slot = iface->key->input_slot[i];
+         if (slot == SWR_GS_INPUT_UNLINKED)
+            continue;
+         vSlot = SELECT(ICMP_EQ(vAttrib, VIMMED1((int)i)), VIMMED1((int)slot), vSlot);
+      }
+   } else {
+      uint32_t slot = iface->key->input_slot[IMMED(unwrap(attrib_index))];
+      if (slot == SWR_GS_INPUT_UNLINKED)
+         return wrap(VIMMED1(0.0f));
+      vSlot = VIMMED1((int)slot);
+   }
+
+   std::vector<Constant *> lanes;
+   for (uint32_t i = 0; i < JM()->mVWidth; i++)
+      lanes.push_back(C((int)(i * sizeof(float))));
+
+   const uint32_t componentSize = JM()->mVWidth * sizeof(float);
+   Value *vOffset = MUL(vVertex, VIMMED1((int)sizeof(simdvertex)));
+   vOffset = ADD(vOffset, MUL(vSlot, VIMMED1((int)(4 * componentSize))));
+   vOffset = ADD(vOffset, VIMMED1((int)(swizzle * componentSize)));
+   vOffset = ADD(vOffset, ConstantVector::get(lanes));
+
+   Value *pVerts = BITCAST(GEP(iface->pGsCtx, {0, SWR_GS_CONTEXT_vert}),
+                           PointerType::get(mInt8Ty, 0));
+
+   return wrap(GATHERPS(
+      VIMMED1(0.0f), pVerts, vOffset, VIMMED1(-1), C((char)1)));
+}
+
+void
+BuilderSWR::swr_gs_llvm_emit_vertex(const struct lp_build_tgsi_gs_iface *gs_iface,
+                                    struct lp_build_tgsi_context *bld_base,
+                                    LLVMValueRef (*outputs)[4],
+                                    LLVMValueRef emitted_vertices_vec)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   struct lp_build_tgsi_soa_context *bld = lp_soa_context(bld_base);
+
+   IRB()->SetInsertPoint(unwrap(LLVMGetInsertBlock(gallivm->builder)));
+
+   /*
+    * There's no exec mask here, so every lane writes; lanes that aren't
+    * emitting write the vertex they'd emit next, which is never counted.
+    * Lanes that hit max_vertices write to the spare vertex past the end.
+    */
+   Value *vTotal = unwrap(emitted_vertices_vec);
+   Value *vPrimVerts = LOAD(unwrap(bld->emitted_vertices_vec_ptr));
+   Value *vMaxVerts = VIMMED1((int)iface->maxVerts);
+   Value *vIndex = SELECT(ICMP_ULT(vTotal, vMaxVerts), vTotal, vMaxVerts);
+
+   std::vector<Constant *> lanes;
+   for (uint32_t i = 0; i < JM()->mVWidth; i++)
+      lanes.push_back(C((int)i));
+   Value *vLane = ConstantVector::get(lanes);
+
+   const uint32_t componentSize = JM()->mVWidth * sizeof(float);
+   Value *vSimdWidth = VIMMED1((int)JM()->mVWidth);
+   Value *vOffset = MUL(vLane, VIMMED1((int)iface->inputPrimStride));
+   vOffset = ADD(vOffset,
+                 MUL(UDIV(vIndex, vSimdWidth),
+                     VIMMED1((int)sizeof(simdvertex))));
+   vOffset = ADD(vOffset,
+                 MUL(UREM(vIndex, vSimdWidth), VIMMED1((int)sizeof(float))));
+
+   Value *vMask = VIMMED1(-1);
+
+   for (uint32_t attrib = 0; attrib < iface->info->num_outputs; attrib++) {
+      uint32_t primIdSlot =
+         (iface->info->output_semantic_name[attrib] == TGSI_SEMANTIC_PRIMID)
+         ? VERTEX_PRIMID_SLOT
+         : 0;
+
+      for (uint32_t channel = 0; channel < TGSI_NUM_CHANNELS; channel++) {
+         if (!outputs[attrib][channel])
+            continue;
+
+         Value *val = LOAD(unwrap(outputs[attrib][channel]));
+         Value *vAttribOffset = ADD(
+            vOffset, VIMMED1((int)((attrib * 4 + channel) * componentSize)));
+         SCATTERPS(iface->pStream, val, vAttribOffset, vMask);
+
+         if (primIdSlot) {
+            vAttribOffset = ADD(
+               vOffset,
+               VIMMED1((int)((primIdSlot * 4 + channel) * componentSize)));
+            SCATTERPS(iface->pStream, val, vAttribOffset, vMask);
+         }
+      }
+   }
+
+   /*
+    * A lane starting a new primitive after having emitted vertices ended
+    * its previous strip on the last vertex it emitted.
+    */
+   Value *vCut = AND(ICMP_UGT(vTotal, VIMMED1(0)),
+                     ICMP_EQ(vPrimVerts, VIMMED1(0)));
+   Value *vLast = SELECT(vCut, SUB(vTotal, VIMMED1(1)), VIMMED1(0));
+   Value *vCutOffset = ADD(MUL(vLane, VIMMED1((int)iface->cutPrimStride)),
+                           LSHR(vLast, VIMMED1(3)));
+   Value *vCutBit = SELECT(vCut, SHL(VIMMED1(1), AND(vLast, VIMMED1(7))),
+                           VIMMED1(0));
+
+   for (uint32_t lane = 0; lane < JM()->mVWidth; lane++) {
+      Value *pCut = GEP(iface->pCutBuffer, {VEXTRACT(vCutOffset, C(lane))});
+      Value *cutBit = TRUNC(VEXTRACT(vCutBit, C(lane)), mInt8Ty);
+      STORE(OR(LOAD(pCut), cutBit), pCut);
+   }
+}
+
+void
+BuilderSWR::swr_gs_llvm_epilogue(const struct lp_build_tgsi_gs_iface *gs_iface,
+                                 struct lp_build_tgsi_context *bld_base,
+                                 LLVMValueRef total_emitted_vertices_vec,
+                                 LLVMValueRef emitted_prims_vec)
+{
+   swr_gs_llvm_iface *iface = (swr_gs_llvm_iface *)gs_iface;
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+
+   IRB()->SetInsertPoint(unwrap(LLVMGetInsertBlock(gallivm->builder)));
+
+   STORE(unwrap(total_emitted_vertices_vec),
+         iface->pGsCtx,
+         {0, SWR_GS_CONTEXT_vertexCount});
+}
+
+PFN_GS_FUNC
+BuilderSWR::CompileGS(swr_geometry_shader *swr_gs, swr_gs_key &key)
+{
+   //   tgsi_dump(swr_gs->pipe.tokens, 0);
+
+   struct gallivm_state *gallivm =
+      gallivm_create("GS", wrap(&JM()->mContext));
+   gallivm->module = wrap(JM()->mpCurrentModule);
+
+   LLVMValueRef outputs[PIPE_MAX_SHADER_OUTPUTS][TGSI_NUM_CHANNELS];
+
+   memset(outputs, 0, sizeof(outputs));
+
+   AttrBuilder attrBuilder;
+   attrBuilder.addStackAlignmentAttr(JM()->mVWidth * sizeof(float));
+   AttributeSet attrSet = AttributeSet::get(
+      JM()->mContext, AttributeSet::FunctionIndex, attrBuilder);
+
+   std::vector<Type *> gsArgs{PointerType::get(Gen_swr_draw_context(JM()), 0),
+                              PointerType::get(Gen_SWR_GS_CONTEXT(JM()), 0)};
+   FunctionType *gsFuncType =
+      FunctionType::get(Type::getVoidTy(JM()->mContext), gsArgs, false);
+
+   // create new geometry shader function
+   auto pFunction = Function::Create(gsFuncType,
+                                     GlobalValue::ExternalLinkage,
+                                     "GS",
+                                     JM()->mpCurrentModule);
+   pFunction->addAttributes(AttributeSet::FunctionIndex, attrSet);
+
+   BasicBlock *block = BasicBlock::Create(JM()->mContext, "entry", pFunction);
+   IRB()->SetInsertPoint(block);
+   LLVMPositionBuilderAtEnd(gallivm->builder, wrap(block));
+
+   auto argitr = pFunction->getArgumentList().begin();
+   Value *hPrivateData = argitr++;
+   hPrivateData->setName("hPrivateData");
+   Value *pGsCtx = argitr++;
+   pGsCtx->setName("gsCtx");
+
+   Value *consts_ptr = GEP(hPrivateData, {0, swr_draw_context_constantGS});
+   consts_ptr->setName("gs_constants");
+   Value *const_sizes_ptr =
+      GEP(hPrivateData, {0, swr_draw_context_num_constantsGS});
+   const_sizes_ptr->setName("num_gs_constants");
+
+   const uint32_t maxNumVerts = swr_gs->gsState.maxNumVerts;
+   const uint32_t numSimdBatches =
+      (maxNumVerts + JM()->mVWidth - 1) / JM()->mVWidth;
+
+   struct swr_gs_llvm_iface gs_iface;
+   gs_iface.base.fetch_input = ::swr_gs_llvm_fetch_input;
+   gs_iface.base.emit_vertex = ::swr_gs_llvm_emit_vertex;
+   gs_iface.base.end_primitive = ::swr_gs_llvm_end_primitive;
+   gs_iface.base.gs_epilogue = ::swr_gs_llvm_epilogue;
+   gs_iface.info = &swr_gs->info.base;
+   gs_iface.pBuilder = this;
+   gs_iface.key = &key;
+   gs_iface.pGsCtx = pGsCtx;
+   gs_iface.pStream = LOAD(pGsCtx, {0, SWR_GS_CONTEXT_pStream, 0});
+   gs_iface.pCutBuffer = LOAD(pGsCtx, {0, SWR_GS_CONTEXT_pCutBuffer});
+   gs_iface.maxVerts = maxNumVerts - 1; // last vertex is the spare
+   gs_iface.inputPrimStride = numSimdBatches * sizeof(simdvertex);
+   gs_iface.cutPrimStride = (maxNumVerts + 7) / 8;
+
+   // cut bits are only ever set, start from a clear buffer
+   MEMSET(gs_iface.pCutBuffer,
+          C((uint8_t)0),
+          gs_iface.cutPrimStride * JM()->mVWidth,
+          1);
+
+   struct lp_bld_tgsi_system_values system_values;
+   memset(&system_values, 0, sizeof(system_values));
+   system_values.prim_id = wrap(LOAD(pGsCtx, {0, SWR_GS_CONTEXT_PrimitiveID}));
+   system_values.invocation_id =
+      wrap(LOAD(pGsCtx, {0, SWR_GS_CONTEXT_InstanceID}));
+
+   // all lanes run; the frontend ignores lanes past the last input prim
+   struct lp_build_mask_context mask;
+   lp_build_mask_begin(
+      &mask, gallivm, lp_type_float_vec(32, 32 * 8), wrap(VIMMED1(-1)));
+
+   lp_build_tgsi_soa(gallivm,
+                     swr_gs->pipe.tokens,
+                     lp_type_float_vec(32, 32 * 8),
+                     &mask,
+                     wrap(consts_ptr),
+                     wrap(const_sizes_ptr),
+                     &system_values,
+                     NULL, // inputs are fetched through gs_iface
+                     outputs,
+                     NULL, // wrap(hPrivateData), (sampler context)
+                     NULL, // sampler
+                     &swr_gs->info.base,
+                     &gs_iface.base);
+
+   lp_build_mask_end(&mask);
+
+   IRB()->SetInsertPoint(unwrap(LLVMGetInsertBlock(gallivm->builder)));
+
+   RET_VOID();
+
+   gallivm_verify_function(gallivm, wrap(pFunction));
+   gallivm_compile_module(gallivm);
+   UseJitCache(gallivm);
+
+   PFN_GS_FUNC pFunc =
+      (PFN_GS_FUNC)gallivm_jit_function(gallivm, wrap(pFunction));
+
+   debug_printf("geom shader  %p\n", pFunc);
+   assert(pFunc && "Error: GeomShader = NULL");
+
+#if (LLVM_VERSION_MAJOR == 3) && (LLVM_VERSION_MINOR >= 5)
+   JM()->mIsModuleFinalized = true;
+#endif
+
+   return pFunc;
+}
+
+PFN_GS_FUNC
+swr_compile_gs(struct swr_context *ctx, swr_gs_key &key)
+{
+   BuilderSWR builder(
+      reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr),
+      "GS",
+      swr_gs_cache_key(ctx->gs, key));
+   return builder.CompileGS(ctx->gs, key);
+}
+
 static unsigned
 locate_linkage(ubyte name, ubyte index, struct tgsi_shader_info *info)
 {
@@ -270,9 +762,10 @@ locate_linkage(ubyte name, ubyte index, struct tgsi_shader_info *info)
 }
 
 PFN_PIXEL_KERNEL
-BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
+BuilderSWR::CompileFS(swr_fs_compile_job &job)
 {
-   struct swr_fragment_shader *swr_fs = ctx->fs;
+   struct swr_fragment_shader *swr_fs = job.fs;
+   swr_jit_key &key = job.key;
 
    //   tgsi_dump(swr_fs->pipe.tokens, 0);
 
@@ -337,7 +830,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
    Value *pPerspAttribs =
       LOAD(pPS, {0, SWR_PS_CONTEXT_pPerspAttribs}, "pPerspAttribs");
 
-   swr_fs->constantMask = 0;
+   unsigned constantMask = 0;
 
    for (int attrib = 0; attrib < PIPE_MAX_SHADER_INPUTS; attrib++) {
       const unsigned mask = swr_fs->info.base.input_usage_mask[attrib];
@@ -377,11 +870,11 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
       }
 
       unsigned linkedAttrib =
-         locate_linkage(semantic_name, semantic_idx, &ctx->vs->info.base);
+         locate_linkage(semantic_name, semantic_idx, &job.vs_info);
       if (linkedAttrib == 0xFFFFFFFF) {
          // not found - check for point sprite
-         if (ctx->rasterizer->sprite_coord_enable) {
-            linkedAttrib = ctx->vs->info.base.num_outputs - 1;
+         if (job.sprite_coord_enable) {
+            linkedAttrib = job.vs_info.num_outputs - 1;
          } else {
             fprintf(stderr,
                     "Missing %s[%d]\n",
@@ -392,7 +885,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
       }
 
       if (interpMode == TGSI_INTERPOLATE_CONSTANT) {
-         swr_fs->constantMask |= 1 << linkedAttrib;
+         constantMask |= 1 << linkedAttrib;
       }
 
       for (int channel = 0; channel < TGSI_NUM_CHANNELS; channel++) {
@@ -402,9 +895,9 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
             Value *indexC = C(linkedAttrib * 12 + channel + 8);
 
             if ((semantic_name == TGSI_SEMANTIC_COLOR)
-                && ctx->rasterizer->light_twoside) {
+                && key.light_twoside) {
                unsigned bcolorAttrib = locate_linkage(
-                  TGSI_SEMANTIC_BCOLOR, semantic_idx, &ctx->vs->info.base);
+                  TGSI_SEMANTIC_BCOLOR, semantic_idx, &job.vs_info);
 
                unsigned diff = 12 * (bcolorAttrib - linkedAttrib);
 
@@ -419,7 +912,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
                indexC = ADD(indexC, offset);
 
                if (interpMode == TGSI_INTERPOLATE_CONSTANT) {
-                  swr_fs->constantMask |= 1 << bcolorAttrib;
+                  constantMask |= 1 << bcolorAttrib;
                }
             }
 
@@ -536,7 +1029,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
 
    if (key.alphaTest.enabled) {
       unsigned linkage =
-         locate_linkage(TGSI_SEMANTIC_COLOR, 0, &ctx->fs->info.base) + 1;
+         locate_linkage(TGSI_SEMANTIC_COLOR, 0, &swr_fs->info.base) + 1;
 
       Value *alpha = LOAD(
          pPS, {0, SWR_PS_CONTEXT_shaded, linkage, 3 /* alpha */}, "alpha");
@@ -586,6 +1079,7 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
    gallivm_verify_function(gallivm, wrap(pFunction));
 
    gallivm_compile_module(gallivm);
+   UseJitCache(gallivm);
 
    PFN_PIXEL_KERNEL kernel =
       (PFN_PIXEL_KERNEL)gallivm_jit_function(gallivm, wrap(pFunction));
@@ -596,13 +1090,261 @@ BuilderSWR::CompileFS(struct swr_context *ctx, swr_jit_key &key)
    JM()->mIsModuleFinalized = true;
 #endif
 
+   job.constantMask = constantMask;
+
    return kernel;
 }
 
+static void
+swr_init_fs_job(swr_fs_compile_job &job,
+                struct swr_context *ctx,
+                swr_jit_key &key)
+{
+   job.fs = ctx->fs;
+   job.key = key;
+   job.vs_info = *swr_last_vertex_stage_info(ctx);
+   job.sprite_coord_enable = ctx->rasterizer->sprite_coord_enable;
+   job.func = NULL;
+   job.constantMask = 0;
+   job.status = swr_fs_compile_job::QUEUED;
+}
+
+static void
+swr_run_fs_job(JitManager *pJitMgr, swr_fs_compile_job &job)
+{
+   BuilderSWR builder(pJitMgr, "FS", swr_fs_cache_key(job.fs, job.key));
+   job.func = builder.CompileFS(job);
+}
+
 PFN_PIXEL_KERNEL
 swr_compile_fs(struct swr_context *ctx, swr_jit_key &key)
 {
-   BuilderSWR builder(
-      reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr));
-   return builder.CompileFS(ctx, key);
+   swr_fs_compile_job job;
+   swr_init_fs_job(job, ctx, key);
+   swr_run_fs_job(
+      reinterpret_cast<JitManager *>(swr_screen(ctx->pipe.screen)->hJitMgr),
+      job);
+   ctx->fs->constantMask = job.constantMask;
+   return job.func;
+}
+
+/*
+ * Background fragment shader compiles.  Each compile thread owns a
+ * JitManager (and so an LLVM context) of its own, so compiles run
+ * concurrently with each other and with jitting on the API thread.
+ */
+struct swr_compile_queue {
+   std::vector<std::thread> threads;
+   std::vector<HANDLE> jitMgrs;
+
+   std::mutex mutex;
+   std::condition_variable work_cv;
+   std::condition_variable done_cv;
+   std::deque<swr_fs_compile_job *> jobs;
+   bool shutdown;
+};
+
+static void
+swr_compile_thread(struct swr_compile_queue *queue, HANDLE hJitMgr)
+{
+   std::unique_lock<std::mutex> lock(queue->mutex);
+
+   for (;;) {
+      queue->work_cv.wait(
+         lock, [queue] { return queue->shutdown || !queue->jobs.empty(); });
+      if (queue->shutdown)
+         break;
+
+      swr_fs_compile_job *job = queue->jobs.front();
+      queue->jobs.pop_front();
+      job->status = swr_fs_compile_job::RUNNING;
+
+      lock.unlock();
+      swr_run_fs_job(reinterpret_cast<JitManager *>(hJitMgr), *job);
+      lock.lock();
+
+      job->status = swr_fs_compile_job::DONE;
+      queue->done_cv.notify_all();
+   }
+}
+
+struct swr_compile_queue *
+swr_compile_queue_create(unsigned num_threads)
+{
+   struct swr_compile_queue *queue = new swr_compile_queue;
+   queue->shutdown = false;
+
+   /* gallivm's one-time init isn't thread safe */
+   lp_build_init();
+
+   for (unsigned i = 0; i < num_threads; i++) {
+      HANDLE hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, KNOB_ARCH_STR);
+      queue->jitMgrs.push_back(hJitMgr);
+      queue->threads.push_back(std::thread(swr_compile_thread, queue, hJitMgr));
+   }
+
+   return queue;
+}
+
+void
+swr_compile_queue_destroy(struct swr_compile_queue *queue)
+{
+   {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      queue->shutdown = true;
+   }
+   queue->work_cv.notify_all();
+
+   for (auto &thread : queue->threads)
+      thread.join();
+
+   /* The compiled variants live in per-shader gallivm engines, but those
+    * reference the thread's LLVM context; all shaders are gone by now. */
+   for (HANDLE hJitMgr : queue->jitMgrs)
+      JitDestroyContext(hJitMgr);
+
+   delete queue;
+}
+
+/*
+ * A variant can only stand in for another if it renders exactly the same
+ * thing.  The one key difference gallivm provably ignores is the mip
+ * filter of a texture that only has level 0 (it samples as if the filter
+ * were NONE), except for pure integer formats, where a linear filter makes
+ * the sampler bail out.  dx10-style shaders can pair any sampler with any
+ * view, so there the units can't be matched up and the keys must be equal.
+ */
+static bool
+swr_fs_key_compatible(const swr_fragment_shader *swr_fs,
+                      const swr_jit_key &a, const swr_jit_key &b)
+{
+   if (swr_fs->info.base.file_max[TGSI_FILE_SAMPLER_VIEW] != -1)
+      return false;
+
+   swr_jit_key ka = a;
+   swr_jit_key kb = b;
+
+   for (unsigned i = 0; i < ka.nr_samplers; i++) {
+      const struct lp_static_texture_state *ta = &ka.sampler[i].texture_state;
+      const struct lp_static_texture_state *tb = &kb.sampler[i].texture_state;
+
+      if (ta->level_zero_only && tb->level_zero_only &&
+          !util_format_is_pure_integer(ta->format)) {
+         ka.sampler[i].sampler_state.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+         kb.sampler[i].sampler_state.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+      }
+   }
+
+   return ka == kb;
+}
+
+/*
+ * Look up the fragment shader variant for key, compiling it if needed.
+ * With a compile queue the compile happens in the background and pending
+ * is set, telling the caller to revalidate on the next draw, when either
+ * an equivalent stand-in variant is returned or, if can_skip allows it,
+ * NULL, in which case the caller must not draw with the shader.  Otherwise
+ * the draw waits for the compile.
+ */
+PFN_PIXEL_KERNEL
+swr_get_fs_variant(struct swr_context *ctx, swr_jit_key &key,
+                   bool can_skip, bool &pending)
+{
+   struct swr_fragment_shader *swr_fs = ctx->fs;
+   struct swr_compile_queue *queue =
+      swr_screen(ctx->pipe.screen)->compile_queue;
+
+   pending = false;
+
+   auto search = swr_fs->map.find(key);
+   if (search != swr_fs->map.end()) {
+      swr_fs->constantMask = search->second.constantMask;
+      return search->second.func;
+   }
+
+   if (!queue) {
+      swr_fs_variant variant;
+      variant.func = swr_compile_fs(ctx, key);
+      variant.constantMask = swr_fs->constantMask;
+      swr_fs->map.insert(std::make_pair(key, variant));
+      return variant.func;
+   }
+
+   std::unique_lock<std::mutex> lock(queue->mutex);
+
+   swr_fs_compile_job *job;
+   auto job_search = swr_fs->pending.find(key);
+   if (job_search != swr_fs->pending.end()) {
+      job = job_search->second;
+   } else {
+      job = new swr_fs_compile_job;
+      swr_init_fs_job(*job, ctx, key);
+      swr_fs->pending.insert(std::make_pair(key, job));
+      queue->jobs.push_back(job);
+      queue->work_cv.notify_one();
+   }
+
+   if (job->status != swr_fs_compile_job::DONE) {
+      for (auto &variant : swr_fs->map) {
+         if (swr_fs_key_compatible(swr_fs, variant.first, key)) {
+            pending = true;
+            swr_fs->constantMask = variant.second.constantMask;
+            return variant.second.func;
+         }
+      }
+
+      if (can_skip) {
+         pending = true;
+         return NULL;
+      }
+
+      /* Nothing to stand in; the draw has to wait, so move the job to the
+       * front of the queue if it hasn't been picked up yet. */
+      if (job->status == swr_fs_compile_job::QUEUED) {
+         auto it = std::find(queue->jobs.begin(), queue->jobs.end(), job);
+         queue->jobs.erase(it);
+         queue->jobs.push_front(job);
+      }
+      queue->done_cv.wait(
+         lock, [job] { return job->status == swr_fs_compile_job::DONE; });
+   }
+
+   swr_fs_variant variant;
+   variant.func = job->func;
+   variant.constantMask = job->constantMask;
+   swr_fs->constantMask = variant.constantMask;
+   swr_fs->map.insert(std::make_pair(key, variant));
+   swr_fs->pending.erase(key);
+   delete job;
+
+   return variant.func;
+}
+
+/*
+ * Drop queued compiles for a shader that is being deleted and wait for the
+ * ones already running, which read the shader's tokens.
+ */
+void
+swr_fs_cancel_compiles(struct pipe_screen *screen,
+                       swr_fragment_shader *swr_fs)
+{
+   struct swr_compile_queue *queue = swr_screen(screen)->compile_queue;
+
+   if (!queue || swr_fs->pending.empty())
+      return;
+
+   std::unique_lock<std::mutex> lock(queue->mutex);
+
+   for (auto &entry : swr_fs->pending) {
+      swr_fs_compile_job *job = entry.second;
+      if (job->status == swr_fs_compile_job::QUEUED) {
+         auto it = std::find(queue->jobs.begin(), queue->jobs.end(), job);
+         queue->jobs.erase(it);
+      } else {
+         queue->done_cv.wait(
+            lock, [job] { return job->status == swr_fs_compile_job::DONE; });
+      }
+      delete job;
+   }
+   swr_fs->pending.clear();
 }
@@ -24,19 +24,38 @@
 #pragma once
 
 class swr_vertex_shader;
+class swr_geometry_shader;
 class swr_fragment_shader;
 class swr_jit_key;
+class swr_gs_key;
 
 PFN_VERTEX_FUNC
 swr_compile_vs(struct pipe_context *ctx, swr_vertex_shader *swr_vs);
 
+PFN_GS_FUNC
+swr_compile_gs(struct swr_context *ctx, swr_gs_key &key);
+
 PFN_PIXEL_KERNEL
 swr_compile_fs(struct swr_context *ctx, swr_jit_key &key);
 
+PFN_PIXEL_KERNEL
+swr_get_fs_variant(struct swr_context *ctx, swr_jit_key &key,
+                   bool can_skip, bool &pending);
+
+void swr_fs_cancel_compiles(struct pipe_screen *screen,
+                            swr_fragment_shader *swr_fs);
+
+struct swr_compile_queue *swr_compile_queue_create(unsigned num_threads);
+void swr_compile_queue_destroy(struct swr_compile_queue *queue);
+
 void swr_generate_fs_key(struct swr_jit_key &key,
                          struct swr_context *ctx,
                          swr_fragment_shader *swr_fs);
 
+void swr_generate_gs_key(struct swr_gs_key &key,
+                         struct swr_context *ctx,
+                         swr_geometry_shader *swr_gs);
+
 struct swr_jit_key {
    unsigned nr_cbufs;
    unsigned light_twoside;
@@ -59,3 +78,42 @@ template <> struct hash<swr_jit_key> {
 };
 
 bool operator==(const swr_jit_key &lhs, const swr_jit_key &rhs);
+
+/*
+ * Geometry shader inputs are read from the vertex shader's output slots,
+ * so a geometry shader is compiled per vertex shader output layout.
+ */
+#define SWR_GS_INPUT_UNLINKED 0xff
+
+struct swr_gs_key {
+   ubyte input_slot[PIPE_MAX_SHADER_INPUTS];
+};
+
+namespace std
+{
+template <> struct hash<swr_gs_key> {
+   std::size_t operator()(const swr_gs_key &k) const
+   {
+      return util_hash_crc32(&k, sizeof(k));
+   }
+};
+};
+
+bool operator==(const swr_gs_key &lhs, const swr_gs_key &rhs);
+
+/*
+ * A fragment shader variant compile, either run inline or queued on the
+ * screen's compile threads.  Everything the compile reads from the context
+ * is copied in so the job doesn't depend on state bound after it was made.
+ */
+struct swr_fs_compile_job {
+   swr_fragment_shader *fs;
+   swr_jit_key key;
+   struct tgsi_shader_info vs_info;
+   unsigned sprite_coord_enable;
+
+   PFN_PIXEL_KERNEL func;
+   unsigned constantMask;
+
+   enum { QUEUED, RUNNING, DONE } status;
+};
@@ -25,6 +25,7 @@
 #include "jit_api.h"
 #include "JitManager.h"
 #include "state_llvm.h"
+#include "core/multisample.h"
 
 #include "gallivm/lp_bld_tgsi.h"
 #include "util/u_format.h"
@@ -42,6 +43,7 @@
 #include "swr_tex_sample.h"
 #include "swr_scratch.h"
 #include "swr_shader.h"
+#include "gen_knobs.h"
 
 /* These should be pulled out into separate files as necessary
  * Just initializing everything here to get going. */
@@ -302,6 +304,28 @@ swr_sampler_view_destroy(struct pipe_context *pipe,
    FREE(view);
 }
 
+static void
+swr_init_so_state(SWR_STREAMOUT_STATE &soState,
+                  const pipe_stream_output_info &stream_output)
+{
+   soState = {0};
+
+   if (stream_output.num_outputs) {
+      soState.soEnable = true;
+      // soState.rasterizerDisable set on state dirty
+      // soState.streamToRasterizer not used
+
+      for (uint32_t i = 0; i < stream_output.num_outputs; i++) {
+         soState.streamMasks[stream_output.output[i].stream] |=
+            1 << (stream_output.output[i].register_index - 1);
+      }
+      for (uint32_t i = 0; i < MAX_SO_STREAMS; i++) {
+        soState.streamNumEntries[i] =
+             _mm_popcnt_u32(soState.streamMasks[i]);
+       }
+   }
+}
+
 static void *
 swr_create_vs_state(struct pipe_context *pipe,
                     const struct pipe_shader_state *vs)
@@ -318,24 +342,7 @@ swr_create_vs_state(struct pipe_context *pipe,
 
    swr_vs->func = swr_compile_vs(pipe, swr_vs);
 
-   swr_vs->soState = {0};
-
-   if (swr_vs->pipe.stream_output.num_outputs) {
-      pipe_stream_output_info *stream_output = &swr_vs->pipe.stream_output;
-
-      swr_vs->soState.soEnable = true;
-      // soState.rasterizerDisable set on state dirty
-      // soState.streamToRasterizer not used
-
-      for (uint32_t i = 0; i < stream_output->num_outputs; i++) {
-         swr_vs->soState.streamMasks[stream_output->output[i].stream] |=
-            1 << (stream_output->output[i].register_index - 1);
-      }
-      for (uint32_t i = 0; i < MAX_SO_STREAMS; i++) {
-        swr_vs->soState.streamNumEntries[i] =
-             _mm_popcnt_u32(swr_vs->soState.streamMasks[i]);
-       }
-   }
+   swr_init_so_state(swr_vs->soState, swr_vs->pipe.stream_output);
 
    return swr_vs;
 }
@@ -360,6 +367,87 @@ swr_delete_vs_state(struct pipe_context *pipe, void *vs)
    FREE(vs);
 }
 
+static void *
+swr_create_gs_state(struct pipe_context *pipe,
+                    const struct pipe_shader_state *gs)
+{
+   struct swr_geometry_shader *swr_gs = new swr_geometry_shader();
+   if (!swr_gs)
+      return NULL;
+
+   swr_gs->pipe.tokens = tgsi_dup_tokens(gs->tokens);
+   swr_gs->pipe.stream_output = gs->stream_output;
+
+   lp_build_tgsi_info(gs->tokens, &swr_gs->info);
+
+   struct tgsi_shader_info *info = &swr_gs->info.base;
+
+   swr_gs->linkageMask = 0;
+   for (unsigned i = 0; i < info->num_outputs; i++) {
+      switch (info->output_semantic_name[i]) {
+      case TGSI_SEMANTIC_POSITION:
+         break;
+      case TGSI_SEMANTIC_PSIZE:
+         swr_gs->pointSizeAttrib = i;
+         break;
+      case TGSI_SEMANTIC_PRIMID:
+         swr_gs->gsState.emitsPrimitiveID = true;
+         swr_gs->linkageMask |= (1 << i);
+         break;
+      default:
+         swr_gs->linkageMask |= (1 << i);
+         break;
+      }
+   }
+
+   switch (info->properties[TGSI_PROPERTY_GS_OUTPUT_PRIM]) {
+   case PIPE_PRIM_POINTS:
+      swr_gs->gsState.outputTopology = TOP_POINT_LIST;
+      break;
+   case PIPE_PRIM_LINE_STRIP:
+      swr_gs->gsState.outputTopology = TOP_LINE_STRIP;
+      break;
+   default:
+      swr_gs->gsState.outputTopology = TOP_TRIANGLE_STRIP;
+      break;
+   }
+
+   /* gallivm's default when the property is missing */
+   unsigned max_vertices =
+      info->properties[TGSI_PROPERTY_GS_MAX_OUTPUT_VERTICES];
+   if (!max_vertices)
+      max_vertices = 32;
+
+   swr_gs->gsState.gsEnable = true;
+   /* plus a spare vertex for lanes emitting past max_vertices */
+   swr_gs->gsState.maxNumVerts = max_vertices + 1;
+   swr_gs->gsState.instanceCount = 1;
+
+   swr_init_so_state(swr_gs->soState, swr_gs->pipe.stream_output);
+
+   return swr_gs;
+}
+
+static void
+swr_bind_gs_state(struct pipe_context *pipe, void *gs)
+{
+   struct swr_context *ctx = swr_context(pipe);
+
+   if (ctx->gs == gs)
+      return;
+
+   ctx->gs = (swr_geometry_shader *)gs;
+   ctx->dirty |= SWR_NEW_GS;
+}
+
+static void
+swr_delete_gs_state(struct pipe_context *pipe, void *gs)
+{
+   struct swr_geometry_shader *swr_gs = (swr_geometry_shader *)gs;
+   FREE((void *)swr_gs->pipe.tokens);
+   delete swr_gs;
+}
+
 static void *
 swr_create_fs_state(struct pipe_context *pipe,
                     const struct pipe_shader_state *fs)
@@ -392,6 +480,7 @@ static void
 swr_delete_fs_state(struct pipe_context *pipe, void *fs)
 {
    struct swr_fragment_shader *swr_fs = (swr_fragment_shader *)fs;
+   swr_fs_cancel_compiles(pipe->screen, swr_fs);
    FREE((void *)swr_fs->pipe.tokens);
    delete swr_fs;
 }
@@ -412,8 +501,10 @@ swr_set_constant_buffer(struct pipe_context *pipe,
    /* note: reference counting */
    util_copy_constant_buffer(&ctx->constants[shader][index], cb);
 
-   if (shader == PIPE_SHADER_VERTEX || shader == PIPE_SHADER_GEOMETRY) {
+   if (shader == PIPE_SHADER_VERTEX) {
       ctx->dirty |= SWR_NEW_VSCONSTANTS;
+   } else if (shader == PIPE_SHADER_GEOMETRY) {
+      ctx->dirty |= SWR_NEW_GSCONSTANTS;
    } else if (shader == PIPE_SHADER_FRAGMENT) {
       ctx->dirty |= SWR_NEW_FSCONSTANTS;
    }
@@ -667,10 +758,10 @@ swr_update_derived(struct swr_context *ctx,
          if ((uintptr_t)ctx->current.attachment[i]
              ^ (uintptr_t)new_attachment[i]) {
             if (ctx->current.attachment[i]) {
-               enum SWR_TILE_STATE post_state;
-               post_state =
-                  (new_attachment[i] ? SWR_TILE_INVALID : SWR_TILE_RESOLVED);
-               swr_store_render_target(ctx, i, post_state);
+               /* The hot tiles no longer represent a bound surface.  Whatever
+                * is bound next reloads them, and a hot tile budget lets the
+                * core release them now. */
+               swr_store_render_target(ctx, i, SWR_TILE_INVALID);
                need_idle |= TRUE;
             }
             changed |= TRUE;
@@ -705,13 +796,13 @@ swr_update_derived(struct swr_context *ctx,
 
          /* rendertarget changes also necessitate updating other state */
          ctx->dirty |= SWR_NEW_BLEND | SWR_NEW_SAMPLER_VIEW | SWR_NEW_VS
-            | SWR_NEW_FS | SWR_NEW_RASTERIZER | SWR_NEW_VIEWPORT
+            | SWR_NEW_GS | SWR_NEW_FS | SWR_NEW_RASTERIZER | SWR_NEW_VIEWPORT
             | SWR_NEW_DEPTH_STENCIL_ALPHA;
       }
    }
 
    /* Raster state */
-   if (ctx->dirty & (SWR_NEW_RASTERIZER | SWR_NEW_VS)) {
+   if (ctx->dirty & (SWR_NEW_RASTERIZER | SWR_NEW_VS | SWR_NEW_GS)) {
       SWR_RASTSTATE *rastState = &ctx->current.rastState;
       rastState->cullMode = swr_convert_cull_mode(ctx->rasterizer->cull_face);
       rastState->frontWinding = ctx->rasterizer->front_ccw
@@ -726,15 +817,22 @@ swr_update_derived(struct swr_context *ctx,
          : 1.0f;
 
       rastState->pointParam = ctx->rasterizer->point_size_per_vertex;
-      rastState->pointSizeAttrib = ctx->vs->pointSizeAttrib;
+      rastState->pointSizeAttrib =
+         ctx->gs ? ctx->gs->pointSizeAttrib : ctx->vs->pointSizeAttrib;
 
       rastState->pointSpriteEnable = ctx->rasterizer->sprite_coord_enable;
       rastState->pointSpriteTopOrigin =
          ctx->rasterizer->sprite_coord_mode == PIPE_SPRITE_COORD_UPPER_LEFT;
-      rastState->pointSpriteFESlot = ctx->vs->info.base.num_outputs;
+      rastState->pointSpriteFESlot = swr_last_vertex_stage_info(ctx)->num_outputs;
 
-      /* XXX TODO: Add multisample */
-      rastState->sampleCount = SWR_MULTISAMPLE_1X;
+      /* Sample count follows the framebuffer, all attachments share it */
+      unsigned nr_samples = 1;
+      if (ctx->framebuffer.nr_cbufs && ctx->framebuffer.cbufs[0])
+         nr_samples = ctx->framebuffer.cbufs[0]->texture->nr_samples;
+      else if (ctx->framebuffer.zsbuf)
+         nr_samples = ctx->framebuffer.zsbuf->texture->nr_samples;
+      rastState->sampleCount = GetSampleCount(MAX2(nr_samples, 1));
+      rastState->sampleMask = ctx->sample_mask;
 
       bool do_offset = false;
       switch (ctx->rasterizer->fill_front) {
@@ -944,31 +1042,72 @@ swr_update_derived(struct swr_context *ctx,
       SwrSetVertexFunc(ctx->swrContext, ctx->vs->func);
    }
 
+   /* GeometryShader */
+   if (ctx->dirty & (SWR_NEW_VS | SWR_NEW_GS)) {
+      SWR_GS_STATE gsState = {0};
+      if (ctx->gs) {
+         swr_gs_key gs_key;
+         swr_generate_gs_key(gs_key, ctx, ctx->gs);
+
+         PFN_GS_FUNC func;
+         auto search = ctx->gs->map.find(gs_key);
+         if (search != ctx->gs->map.end()) {
+            func = search->second;
+         } else {
+            func = swr_compile_gs(ctx, gs_key);
+            ctx->gs->map.insert(std::make_pair(gs_key, func));
+         }
+         SwrSetGsFunc(ctx->swrContext, func);
+
+         /* assemble the vertex shader outputs the geometry shader reads */
+         gsState = ctx->gs->gsState;
+         for (unsigned i = 0; i < ctx->gs->info.base.num_inputs; i++) {
+            if (gs_key.input_slot[i] != SWR_GS_INPUT_UNLINKED)
+               gsState.numInputAttribs =
+                  MAX2(gsState.numInputAttribs, gs_key.input_slot[i]);
+         }
+      }
+      SwrSetGsState(ctx->swrContext, &gsState);
+   }
+
    swr_jit_key key;
    if (ctx->dirty & (SWR_NEW_FS | SWR_NEW_SAMPLER | SWR_NEW_SAMPLER_VIEW
                      | SWR_NEW_DEPTH_STENCIL_ALPHA | SWR_NEW_RASTERIZER
-                     | SWR_NEW_FRAMEBUFFER)) {
+                     | SWR_NEW_FRAMEBUFFER | SWR_NEW_VS | SWR_NEW_GS)) {
       memset(&key, 0, sizeof(key));
       swr_generate_fs_key(key, ctx, ctx->fs);
-      auto search = ctx->fs->map.find(key);
-      PFN_PIXEL_KERNEL func;
-      if (search != ctx->fs->map.end()) {
-         func = search->second;
-      } else {
-         func = swr_compile_fs(ctx, key);
-         ctx->fs->map.insert(std::make_pair(key, func));
+
+      /* Dropping a draw loses its stream output and query counts too, so
+       * only those that produce nothing but pixels are skipped. */
+      bool can_skip = KNOB_JIT_ASYNC_SKIP_DRAWS && !ctx->active_queries;
+      if (can_skip && p_draw_info) {
+         struct pipe_stream_output_info *so = ctx->gs
+            ? &ctx->gs->pipe.stream_output
+            : &ctx->vs->pipe.stream_output;
+         can_skip = !so->num_outputs;
+      }
+
+      bool pending;
+      PFN_PIXEL_KERNEL func =
+         swr_get_fs_variant(ctx, key, can_skip, pending);
+      /* a stand-in variant is bound until the real one finishes compiling;
+       * without one, draws are dropped until then */
+      if (pending)
+         post_update_dirty_flags |= SWR_NEW_FS;
+      ctx->fs_compiling = func == NULL;
+      if (func) {
+         SWR_PS_STATE psState = {0};
+         psState.pfnPixelShader = func;
+         psState.killsPixel =
+            ctx->fs->info.base.uses_kill || key.alphaTest.enabled;
+         psState.writesODepth = ctx->fs->info.base.writes_z;
+         psState.usesSourceDepth = ctx->fs->info.base.reads_z;
+         psState.maxRTSlotUsed =
+            (ctx->framebuffer.nr_cbufs != 0) ?
+            (ctx->framebuffer.nr_cbufs - 1) :
+            0;
+         SwrSetPixelShaderState(ctx->swrContext, &psState);
       }
-      SWR_PS_STATE psState = {0};
-      psState.pfnPixelShader = func;
-      psState.killsPixel =
-         ctx->fs->info.base.uses_kill || key.alphaTest.enabled;
-      psState.writesODepth = ctx->fs->info.base.writes_z;
-      psState.usesSourceDepth = ctx->fs->info.base.reads_z;
-      psState.maxRTSlotUsed =
-         (ctx->framebuffer.nr_cbufs != 0) ?
-         (ctx->framebuffer.nr_cbufs - 1) :
-         0;
-      SwrSetPixelShaderState(ctx->swrContext, &psState);
    }
 
    /* JIT sampler state */
@@ -1047,6 +1186,32 @@ swr_update_derived(struct swr_context *ctx,
       }
    }
 
+   /* GeometryShader Constants */
+   if (ctx->dirty & SWR_NEW_GSCONSTANTS) {
+      swr_draw_context *pDC =
+         (swr_draw_context *)SwrGetPrivateContextState(ctx->swrContext);
+
+      for (UINT i = 0; i < PIPE_MAX_CONSTANT_BUFFERS; i++) {
+         const pipe_constant_buffer *cb =
+            &ctx->constants[PIPE_SHADER_GEOMETRY][i];
+         pDC->num_constantsGS[i] = cb->buffer_size;
+         if (cb->buffer)
+            pDC->constantGS[i] =
+               (const float *)((const BYTE *)cb->buffer + cb->buffer_offset);
+         else {
+            /* Need to copy these constants to scratch space */
+            if (cb->user_buffer && cb->buffer_size) {
+               const void *ptr =
+                  ((const BYTE *)cb->user_buffer + cb->buffer_offset);
+               uint32_t size = AlignUp(cb->buffer_size, 4);
+               ptr = swr_copy_to_scratch_space(
+                  ctx, &ctx->scratch->gs_constants, ptr, size);
+               pDC->constantGS[i] = (const float *)ptr;
+            }
+         }
+      }
+   }
+
    /* FragmentShader Constants */
    if (ctx->dirty & SWR_NEW_FSCONSTANTS) {
       swr_draw_context *pDC =
@@ -1161,6 +1326,8 @@ swr_update_derived(struct swr_context *ctx,
             struct swr_resource *colorBuffer =
                swr_resource(fb->cbufs[target]->texture);
             compileState->format = colorBuffer->swr.format;
+            compileState->hotTileFormat =
+               SwrGetColorHotTileFormat(colorBuffer->swr.format);
 
             memcpy(&blendState.renderTarget[target],
                   &compileState->blendState,
@@ -1188,12 +1355,17 @@ swr_update_derived(struct swr_context *ctx,
       /* XXX What to do with this one??? SWR doesn't stipple */
    }
 
-   if (ctx->dirty & (SWR_NEW_VS | SWR_NEW_SO | SWR_NEW_RASTERIZER)) {
-      ctx->vs->soState.rasterizerDisable =
-         ctx->rasterizer->rasterizer_discard;
-      SwrSetSoState(ctx->swrContext, &ctx->vs->soState);
+   if (ctx->dirty
+       & (SWR_NEW_VS | SWR_NEW_GS | SWR_NEW_SO | SWR_NEW_RASTERIZER)) {
+      /* stream output is fed by the last vertex processing stage */
+      SWR_STREAMOUT_STATE *soState =
+         ctx->gs ? &ctx->gs->soState : &ctx->vs->soState;
+      soState->rasterizerDisable = ctx->rasterizer->rasterizer_discard;
+      SwrSetSoState(ctx->swrContext, soState);
 
-      pipe_stream_output_info *stream_output = &ctx->vs->pipe.stream_output;
+      pipe_stream_output_info *stream_output = ctx->gs
+         ? &ctx->gs->pipe.stream_output
+         : &ctx->vs->pipe.stream_output;
 
       for (uint32_t i = 0; i < ctx->num_so_targets; i++) {
          SWR_STREAMOUT_BUFFER buffer = {0};
@@ -1210,9 +1382,9 @@ swr_update_derived(struct swr_context *ctx,
       }
    }
 
-   uint32_t linkage = ctx->vs->linkageMask;
+   uint32_t linkage = ctx->gs ? ctx->gs->linkageMask : ctx->vs->linkageMask;
    if (ctx->rasterizer->sprite_coord_enable)
-      linkage |= (1 << ctx->vs->info.base.num_outputs);
+      linkage |= (1 << swr_last_vertex_stage_info(ctx)->num_outputs);
 
    SwrSetLinkage(ctx->swrContext, linkage, NULL);
 
@@ -1225,6 +1397,14 @@ swr_update_derived(struct swr_context *ctx,
    backendState.numAttributes = 1;
    backendState.numComponents[0] = 4;
    backendState.constantInterpolationMask = ctx->fs->constantMask;
+   for (unsigned i = 0;
+        i < std::min((unsigned)SWR_NUM_RENDERTARGETS, ctx->framebuffer.nr_cbufs);
+        i++) {
+      if (!ctx->framebuffer.cbufs[i])
+         continue;
+      backendState.colorHotTileFormat[i] = SwrGetColorHotTileFormat(
+         swr_resource(ctx->framebuffer.cbufs[i]->texture)->swr.format);
+   }
    SwrSetBackendState(ctx->swrContext, &backendState);
 
    ctx->dirty = post_update_dirty_flags;
@@ -1313,6 +1493,10 @@ swr_state_init(struct pipe_context *pipe)
    pipe->bind_vs_state = swr_bind_vs_state;
    pipe->delete_vs_state = swr_delete_vs_state;
 
+   pipe->create_gs_state = swr_create_gs_state;
+   pipe->bind_gs_state = swr_bind_gs_state;
+   pipe->delete_gs_state = swr_delete_gs_state;
+
    pipe->create_fs_state = swr_create_fs_state;
    pipe->bind_fs_state = swr_bind_fs_state;
    pipe->delete_fs_state = swr_delete_fs_state;
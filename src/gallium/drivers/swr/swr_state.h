@@ -46,11 +46,32 @@ struct swr_vertex_shader {
    PFN_SO_FUNC soFunc[PIPE_PRIM_MAX];
 };
 
+struct swr_geometry_shader {
+   struct pipe_shader_state pipe;
+   struct lp_tgsi_info info;
+   unsigned linkageMask;
+   unsigned pointSizeAttrib;
+   /* numInputAttribs depends on the bound vertex shader */
+   SWR_GS_STATE gsState;
+   SWR_STREAMOUT_STATE soState;
+   PFN_SO_FUNC soFunc[PIPE_PRIM_MAX];
+   std::unordered_map<swr_gs_key, PFN_GS_FUNC> map;
+};
+
+/* The flat shading mask depends on the key's attribute linkage */
+struct swr_fs_variant {
+   PFN_PIXEL_KERNEL func;
+   unsigned constantMask;
+};
+
 struct swr_fragment_shader {
    struct pipe_shader_state pipe;
    struct lp_tgsi_info info;
+   /* mask of the variant last returned by swr_get_fs_variant */
    unsigned constantMask;
-   std::unordered_map<swr_jit_key, PFN_PIXEL_KERNEL> map;
+   std::unordered_map<swr_jit_key, swr_fs_variant> map;
+   /* variants still compiling on the screen's compile queue */
+   std::unordered_map<swr_jit_key, swr_fs_compile_job *> pending;
 };
 
 /* Vertex element state */
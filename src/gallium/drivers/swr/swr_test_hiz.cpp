@@ -0,0 +1,129 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Walks a raster tile through the hierarchical Z updates the rasterizer
+ * makes: after a clear, a primitive that covers the whole tile has to pull
+ * the far bound in, so a later primitive behind it is rejected without
+ * running the backend.  Partial coverage and killed pixels must leave the
+ * far bound alone.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "context.h"
+#include "hiz.h"
+
+static bool pass = true;
+
+static void
+check(bool cond, const char *what)
+{
+   if (!cond) {
+      fprintf(stderr, "%s\n", what);
+      pass = false;
+   }
+}
+
+/* depth plane of a primitive whose depth goes from z at the left of the
+ * raster tile at 0,0 to z + dzdx at its right */
+static HIZ_PLANE
+plane(const API_STATE &state, float z, float dzdx)
+{
+   OSALIGN(SWR_TRIANGLE_DESC, 16) triDesc;
+   memset(&triDesc, 0, sizeof(triDesc));
+
+   /* i = x / KNOB_TILE_X_DIM, j = 0 */
+   triDesc.recipDet = 1.0f;
+   triDesc.I[0] = 1.0f / KNOB_TILE_X_DIM;
+   triDesc.Z[0] = dzdx;
+   triDesc.Z[2] = z;
+
+   return HIZ_PLANE(triDesc, state.vp[0], KNOB_TILE_X_DIM, KNOB_TILE_Y_DIM);
+}
+
+static bool
+rejects(const API_STATE &state, const HIZ_TILE &hiZ, const HIZ_PLANE &zPlane)
+{
+   float zMin, zMax;
+   zPlane.TileRange(0, 0, zMin, zMax);
+   return HiZReject(state.depthStencilState.depthTestFunc, hiZ, zMin, zMax);
+}
+
+static void
+test_func(API_STATE &state, uint32_t func, float clear, float z, float behind)
+{
+   state.depthStencilState.depthTestFunc = func;
+   check(CanHiZReject(state), "depth state can't reject");
+
+   HIZ_TILE hiZ = { clear, clear };
+
+   check(!rejects(state, hiZ, plane(state, behind, 0.0f)),
+         "rejected against the cleared tile");
+
+   /* a sloped primitive that misses part of the tile leaves the bounds
+    * covering the clear value */
+   HiZUpdateTile(state, plane(state, z, 0.125f), hiZ, 0, 0, false);
+   check(!rejects(state, hiZ, plane(state, behind, 0.0f)),
+         "rejected after a partially covered tile");
+
+   /* so do killed pixels */
+   state.psState.killsPixel = 1;
+   HiZUpdateTile(state, plane(state, z, 0.125f), hiZ, 0, 0, true);
+   state.psState.killsPixel = 0;
+   check(!rejects(state, hiZ, plane(state, behind, 0.0f)),
+         "rejected after a tile with killed pixels");
+
+   /* once it covers every sample, nothing can be left behind it */
+   HiZUpdateTile(state, plane(state, z, 0.125f), hiZ, 0, 0, true);
+   check(rejects(state, hiZ, plane(state, behind, 0.0f)),
+         "not rejected behind a fully covered tile");
+   check(!rejects(state, hiZ, plane(state, z, 0.0f)),
+         "rejected at the depth that was drawn");
+}
+
+int
+main(void)
+{
+   if (!KNOB_HIZ) {
+      fprintf(stderr, "HIZ knob is off, nothing was tested\n");
+      return EXIT_FAILURE;
+   }
+
+   API_STATE *pState = (API_STATE *)calloc(1, sizeof(API_STATE));
+   pState->vp[0].minZ = 0.0f;
+   pState->vp[0].maxZ = 1.0f;
+   pState->depthStencilState.depthTestEnable = 1;
+   pState->depthStencilState.depthWriteEnable = 1;
+
+   test_func(*pState, ZFUNC_LT, 1.0f, 0.25f, 0.75f);
+   test_func(*pState, ZFUNC_LE, 1.0f, 0.25f, 0.75f);
+   test_func(*pState, ZFUNC_GT, 0.0f, 0.5f, 0.25f);
+   test_func(*pState, ZFUNC_GE, 0.0f, 0.5f, 0.25f);
+
+   free(pState);
+
+   return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,143 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Renders every macrotile of a render target many times the hot tile
+ * budget in a single draw, the way a backend worker does: lock the tile,
+ * dirty its hot tile, unlock and evict.  Dirty tiles that store losslessly
+ * have to be stored and freed, so the hot tiles stay near the budget, and
+ * every tile has to reach the surface exactly once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "context.h"
+#include "tilemgr.h"
+
+#define TARGET_TILES_X 64
+#define TARGET_TILES_Y 64
+#define BUDGET_MB 1
+
+static unsigned stores[TARGET_TILES_X][TARGET_TILES_Y];
+
+static void
+load_tile(HANDLE hPrivateContext, SWR_FORMAT dstFormat,
+          SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+          uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex,
+          BYTE *pDstHotTile)
+{
+}
+
+static void
+store_tile(HANDLE hPrivateContext, SWR_FORMAT srcFormat,
+           SWR_RENDERTARGET_ATTACHMENT renderTargetIndex,
+           uint32_t x, uint32_t y, uint32_t renderTargetArrayIndex,
+           BYTE *pSrcHotTile)
+{
+   stores[x / KNOB_MACROTILE_X_DIM][y / KNOB_MACROTILE_Y_DIM]++;
+}
+
+int
+main(int argc, char **argv)
+{
+   SET_KNOB(HOT_TILE_BUDGET_MB, BUDGET_MB);
+
+   SWR_CONTEXT *pContext = (SWR_CONTEXT *)calloc(1, sizeof(SWR_CONTEXT));
+   pContext->pfnLoadTile = load_tile;
+   pContext->pfnStoreTile = store_tile;
+
+   DRAW_STATE *pState = (DRAW_STATE *)calloc(1, sizeof(DRAW_STATE));
+   pState->state.backendState.colorHotTileFormat[0] =
+      KNOB_COLOR_HOT_TILE_FORMAT_UNORM8;
+
+   DRAW_CONTEXT dc;
+   memset(&dc, 0, sizeof(dc));
+   dc.pContext = pContext;
+   dc.pState = pState;
+   dc.drawId = 1;
+
+   uint32_t nodeId = 0;
+   HotTileMgr *pHotTileMgr = new HotTileMgr(1, &nodeId);
+   pContext->pHotTileMgr = pHotTileMgr;
+
+   const int64_t budget = int64_t(BUDGET_MB) * 1024 * 1024;
+   const int64_t tileBytes = KNOB_MACROTILE_X_DIM * KNOB_MACROTILE_Y_DIM * 4;
+   int64_t peak = 0;
+
+   for (uint32_t y = 0; y < TARGET_TILES_Y; y++) {
+      for (uint32_t x = 0; x < TARGET_TILES_X; x++) {
+         uint32_t macroID = (x << 16) | y;
+
+         pHotTileMgr->LockTile(macroID);
+         HOTTILE *pHotTile = pHotTileMgr->GetHotTile(
+            pContext, &dc, macroID, SWR_ATTACHMENT_COLOR0, true);
+         pHotTile->state = HOTTILE_DIRTY;
+         pHotTileMgr->UnlockTile(macroID);
+
+         pHotTileMgr->EvictHotTiles(pContext, &dc);
+
+         if (pHotTileMgr->GetBytesAllocated() > peak)
+            peak = pHotTileMgr->GetBytesAllocated();
+      }
+   }
+
+   bool pass = true;
+
+   /* the tile being rendered can push it over, plus what the clock needs
+    * to come round to the next tile to evict */
+   if (peak > budget + budget / 2) {
+      fprintf(stderr, "hot tiles peaked at %lld bytes, budget %lld\n",
+              (long long)peak, (long long)budget);
+      pass = false;
+   }
+
+   /* what is still resident is stored at the end of the frame, the rest
+    * must have been stored by eviction, and only once */
+   for (uint32_t y = 0; y < TARGET_TILES_Y; y++) {
+      for (uint32_t x = 0; x < TARGET_TILES_X; x++) {
+         uint32_t macroID = (x << 16) | y;
+         HOTTILE *pHotTile = pHotTileMgr->GetHotTile(
+            pContext, &dc, macroID, SWR_ATTACHMENT_COLOR0, false);
+         bool resident = pHotTile && pHotTile->pBuffer;
+
+         if (stores[x][y] != (resident ? 0u : 1u)) {
+            fprintf(stderr, "tile %u,%u stored %u times, %s\n", x, y,
+                    stores[x][y], resident ? "resident" : "evicted");
+            pass = false;
+         }
+      }
+   }
+
+   if (tileBytes * TARGET_TILES_X * TARGET_TILES_Y <= budget) {
+      fprintf(stderr, "target fits the budget, nothing was tested\n");
+      pass = false;
+   }
+
+   delete pHotTileMgr;
+   free(pState);
+   free(pContext);
+
+   return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
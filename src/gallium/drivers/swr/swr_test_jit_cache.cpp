@@ -0,0 +1,176 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Compiles a cacheable blend function, tears the jit down and compiles it
+ * again with a fresh jit on the same cache directory, as a restarted
+ * process would.  The second compile must be served from the cache.  An
+ * entry whose stored key doesn't match the module's, as left by another
+ * state with the same key hash, must be a miss.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string>
+
+#include "gen_knobs.h"
+#include "jit_api.h"
+
+static bool
+compile_blend(const BLEND_COMPILE_STATE &state, JIT_CACHE_STATS &stats)
+{
+   HANDLE hJitMgr = JitCreateContext(KNOB_SIMD_WIDTH, KNOB_ARCH_STR);
+   if (!hJitMgr)
+      return false;
+
+   PFN_BLEND_JIT_FUNC func = JitCompileBlend(hJitMgr, state);
+   JitGetCacheStats(hJitMgr, stats);
+   JitDestroyContext(hJitMgr);
+
+   return func != NULL;
+}
+
+static bool
+check_stats(const char *step, const JIT_CACHE_STATS &stats,
+            uint64_t hits, uint64_t misses, uint64_t stores)
+{
+   if (stats.hits == hits && stats.misses == misses && stats.stores == stores)
+      return true;
+
+   fprintf(stderr, "%s: got %llu hits %llu misses %llu stores, "
+           "expected %llu %llu %llu\n", step,
+           (unsigned long long)stats.hits,
+           (unsigned long long)stats.misses,
+           (unsigned long long)stats.stores,
+           (unsigned long long)hits,
+           (unsigned long long)misses,
+           (unsigned long long)stores);
+   return false;
+}
+
+/* Flips a byte of the key stored in each entry; it follows the header. */
+static bool
+corrupt_cache_keys(const char *dir)
+{
+   const long key_offset = 24;
+   bool found = false;
+
+   DIR *d = opendir(dir);
+   if (!d)
+      return false;
+
+   struct dirent *entry;
+   while ((entry = readdir(d)) != NULL) {
+      if (entry->d_name[0] == '.')
+         continue;
+      std::string path = std::string(dir) + "/" + entry->d_name;
+      FILE *f = fopen(path.c_str(), "r+b");
+      if (!f)
+         continue;
+      int c;
+      if (!fseek(f, key_offset, SEEK_SET) && (c = fgetc(f)) != EOF &&
+          !fseek(f, key_offset, SEEK_SET) && fputc(c ^ 0xff, f) != EOF)
+         found = true;
+      fclose(f);
+   }
+   closedir(d);
+
+   return found;
+}
+
+static void
+remove_cache_dir(const char *dir)
+{
+   DIR *d = opendir(dir);
+   if (d) {
+      struct dirent *entry;
+      while ((entry = readdir(d)) != NULL) {
+         if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            continue;
+         std::string path = std::string(dir) + "/" + entry->d_name;
+         unlink(path.c_str());
+      }
+      closedir(d);
+   }
+   rmdir(dir);
+}
+
+int
+main(int argc, char **argv)
+{
+   char dir[] = "/tmp/swr_jit_cache_XXXXXX";
+   if (!mkdtemp(dir)) {
+      perror("mkdtemp");
+      return EXIT_FAILURE;
+   }
+
+   SET_KNOB(JIT_ENABLE_CACHE, true);
+   SET_KNOB(JIT_CACHE_DIR, std::string(dir));
+
+   BLEND_COMPILE_STATE state;
+   memset(&state, 0, sizeof(state));
+   state.format = R32G32B32A32_FLOAT;
+   state.hotTileFormat = R32G32B32A32_FLOAT;
+   state.blendState.colorBlendEnable = 1;
+   state.blendState.sourceBlendFactor = BLENDFACTOR_SRC_ALPHA;
+   state.blendState.destBlendFactor = BLENDFACTOR_INV_SRC_ALPHA;
+   state.blendState.sourceAlphaBlendFactor = BLENDFACTOR_ONE;
+   state.blendState.destAlphaBlendFactor = BLENDFACTOR_ZERO;
+
+   JIT_CACHE_STATS stats;
+   bool pass = true;
+
+   /* cold cache: compiled and stored */
+   pass = compile_blend(state, stats) && pass;
+   pass = check_stats("first compile", stats, 0, 1, 1) && pass;
+
+   /* restarted: loaded from disk */
+   pass = compile_blend(state, stats) && pass;
+   pass = check_stats("after restart", stats, 1, 0, 0) && pass;
+
+   /* different state: new entry */
+   state.blendState.destBlendFactor = BLENDFACTOR_ONE;
+   pass = compile_blend(state, stats) && pass;
+   pass = check_stats("new state", stats, 0, 1, 1) && pass;
+
+   /* same file names, other keys: recompiled and replaced */
+   if (!corrupt_cache_keys(dir)) {
+      fprintf(stderr, "no cache entries to corrupt\n");
+      pass = false;
+   }
+   pass = compile_blend(state, stats) && pass;
+   pass = check_stats("key mismatch", stats, 0, 1, 1) && pass;
+
+   pass = compile_blend(state, stats) && pass;
+   pass = check_stats("after replace", stats, 1, 0, 0) && pass;
+
+   remove_cache_dir(dir);
+
+   if (!pass)
+      fprintf(stderr, "jit cache test failed\n");
+
+   return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,289 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Queues many draws that each take their fragment color from several user
+ * constant buffers, which live in the fs constant scratch ring.  The draws
+ * outnumber the ring several times over, and halfway through the buffers
+ * grow so the ring is replaced while earlier draws are still queued.  Every
+ * draw fills its own cell of the render target; any constant overwritten
+ * or freed before its draw ran shows up as a wrong cell.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_inlines.h"
+#include "util/u_simple_shaders.h"
+#include "tgsi/tgsi_text.h"
+
+#include "swr_public.h"
+
+extern "C" {
+#include "sw/null/null_sw_winsys.h"
+}
+
+#define CELLS_X 16
+#define CELLS_Y 16
+#define CELL_SIZE 4
+#define NUM_DRAWS (CELLS_X * CELLS_Y)
+#define NUM_CONSTANT_BUFFERS 4
+
+/* fragment color is the sum of the first vec4 of each constant buffer */
+static const char fs_text[] =
+   "FRAG\n"
+   "DCL OUT[0], COLOR\n"
+   "DCL CONST[0][0]\n"
+   "DCL CONST[1][0]\n"
+   "DCL CONST[2][0]\n"
+   "DCL CONST[3][0]\n"
+   "DCL TEMP[0]\n"
+   "  0: ADD TEMP[0], CONST[0][0], CONST[1][0]\n"
+   "  1: ADD TEMP[0], TEMP[0], CONST[2][0]\n"
+   "  2: ADD OUT[0], TEMP[0], CONST[3][0]\n"
+   "  3: END\n";
+
+/* constant buffer b of draw d contributes (d + 1) * 4^b to channel b */
+static float
+expected_channel(unsigned draw, unsigned channel)
+{
+   return (float)(draw + 1) * (float)(1 << (2 * channel));
+}
+
+static void *
+create_fs(struct pipe_context *pipe)
+{
+   struct tgsi_token tokens[256];
+   struct pipe_shader_state state;
+
+   if (!tgsi_text_translate(fs_text, tokens, ARRAY_SIZE(tokens)))
+      return NULL;
+
+   memset(&state, 0, sizeof(state));
+   state.tokens = tokens;
+   return pipe->create_fs_state(pipe, &state);
+}
+
+static struct pipe_resource *
+create_quads(struct pipe_context *pipe)
+{
+   static float verts[NUM_DRAWS * 6][4];
+   static const float corner[6][2] = {
+      { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 }
+   };
+
+   for (unsigned d = 0; d < NUM_DRAWS; d++) {
+      unsigned cx = d % CELLS_X;
+      unsigned cy = d / CELLS_X;
+      for (unsigned v = 0; v < 6; v++) {
+         verts[d * 6 + v][0] = -1.0f + 2.0f * (cx + corner[v][0]) / CELLS_X;
+         verts[d * 6 + v][1] = -1.0f + 2.0f * (cy + corner[v][1]) / CELLS_Y;
+         verts[d * 6 + v][2] = 0.0f;
+         verts[d * 6 + v][3] = 1.0f;
+      }
+   }
+
+   struct pipe_resource *buf =
+      pipe_buffer_create(pipe->screen, PIPE_BIND_VERTEX_BUFFER,
+                         PIPE_USAGE_IMMUTABLE, sizeof(verts));
+   if (buf)
+      pipe_buffer_write(pipe, buf, 0, sizeof(verts), verts);
+   return buf;
+}
+
+static void
+bind_state(struct pipe_context *pipe, struct pipe_surface *surf,
+           struct pipe_resource *vbuf)
+{
+   struct pipe_framebuffer_state fb;
+   memset(&fb, 0, sizeof(fb));
+   fb.width = surf->width;
+   fb.height = surf->height;
+   fb.nr_cbufs = 1;
+   fb.cbufs[0] = surf;
+   pipe->set_framebuffer_state(pipe, &fb);
+
+   struct pipe_viewport_state vp;
+   vp.scale[0] = fb.width * 0.5f;
+   vp.scale[1] = fb.height * 0.5f;
+   vp.scale[2] = 0.5f;
+   vp.translate[0] = fb.width * 0.5f;
+   vp.translate[1] = fb.height * 0.5f;
+   vp.translate[2] = 0.5f;
+   pipe->set_viewport_states(pipe, 0, 1, &vp);
+
+   struct pipe_rasterizer_state rs;
+   memset(&rs, 0, sizeof(rs));
+   rs.half_pixel_center = 1;
+   rs.bottom_edge_rule = 1;
+   rs.depth_clip = 1;
+   pipe->bind_rasterizer_state(pipe, pipe->create_rasterizer_state(pipe, &rs));
+
+   struct pipe_blend_state blend;
+   memset(&blend, 0, sizeof(blend));
+   blend.rt[0].colormask = PIPE_MASK_RGBA;
+   pipe->bind_blend_state(pipe, pipe->create_blend_state(pipe, &blend));
+
+   struct pipe_depth_stencil_alpha_state dsa;
+   memset(&dsa, 0, sizeof(dsa));
+   pipe->bind_depth_stencil_alpha_state(
+      pipe, pipe->create_depth_stencil_alpha_state(pipe, &dsa));
+
+   struct pipe_vertex_element ve;
+   memset(&ve, 0, sizeof(ve));
+   ve.src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   pipe->bind_vertex_elements_state(
+      pipe, pipe->create_vertex_elements_state(pipe, 1, &ve));
+
+   struct pipe_vertex_buffer vb;
+   memset(&vb, 0, sizeof(vb));
+   vb.stride = 4 * sizeof(float);
+   vb.buffer = vbuf;
+   pipe->set_vertex_buffers(pipe, 0, 1, &vb);
+
+   const uint semantic_names[] = { TGSI_SEMANTIC_POSITION };
+   const uint semantic_indexes[] = { 0 };
+   pipe->bind_vs_state(pipe,
+                       util_make_vertex_passthrough_shader(
+                          pipe, 1, semantic_names, semantic_indexes, false));
+   pipe->bind_fs_state(pipe, create_fs(pipe));
+}
+
+static void
+draw_cells(struct pipe_context *pipe)
+{
+   /* the second half uses larger buffers, which replaces the ring */
+   static float constants[NUM_CONSTANT_BUFFERS][16];
+
+   for (unsigned d = 0; d < NUM_DRAWS; d++) {
+      unsigned size = d < NUM_DRAWS / 2 ? 4 * sizeof(float)
+                                         : 16 * sizeof(float);
+
+      for (unsigned b = 0; b < NUM_CONSTANT_BUFFERS; b++) {
+         memset(constants[b], 0, sizeof(constants[b]));
+         constants[b][b] = expected_channel(d, b);
+
+         struct pipe_constant_buffer cb;
+         memset(&cb, 0, sizeof(cb));
+         cb.user_buffer = constants[b];
+         cb.buffer_size = size;
+         pipe->set_constant_buffer(pipe, PIPE_SHADER_FRAGMENT, b, &cb);
+      }
+
+      struct pipe_draw_info info;
+      memset(&info, 0, sizeof(info));
+      info.mode = PIPE_PRIM_TRIANGLES;
+      info.start = d * 6;
+      info.count = 6;
+      info.instance_count = 1;
+      info.max_index = ~0;
+      pipe->draw_vbo(pipe, &info);
+   }
+}
+
+static unsigned
+check_cells(struct pipe_context *pipe, struct pipe_resource *rt)
+{
+   struct pipe_transfer *transfer;
+   const float *map = (const float *)
+      pipe_transfer_map(pipe, rt, 0, 0, PIPE_TRANSFER_READ,
+                        0, 0, rt->width0, rt->height0, &transfer);
+   if (!map)
+      return NUM_DRAWS;
+
+   unsigned failures = 0;
+   for (unsigned d = 0; d < NUM_DRAWS; d++) {
+      unsigned x = (d % CELLS_X) * CELL_SIZE + CELL_SIZE / 2;
+      unsigned y = (d / CELLS_X) * CELL_SIZE + CELL_SIZE / 2;
+      const float *texel =
+         (const float *)((const char *)map + y * transfer->stride) + x * 4;
+
+      for (unsigned c = 0; c < 4; c++) {
+         if (texel[c] != expected_channel(d, c)) {
+            fprintf(stderr, "draw %u: channel %u is %f, expected %f\n",
+                    d, c, texel[c], expected_channel(d, c));
+            failures++;
+            break;
+         }
+      }
+   }
+
+   pipe_transfer_unmap(pipe, transfer);
+   return failures;
+}
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_screen *screen = swr_create_screen(null_sw_create());
+   if (!screen)
+      return EXIT_FAILURE;
+
+   const enum pipe_format format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   if (!screen->is_format_supported(screen, format, PIPE_TEXTURE_2D, 0,
+                                    PIPE_BIND_RENDER_TARGET)) {
+      fprintf(stderr, "float render targets not supported, skipping\n");
+      screen->destroy(screen);
+      return 77;
+   }
+
+   struct pipe_context *pipe = screen->context_create(screen, NULL);
+
+   struct pipe_resource templ;
+   memset(&templ, 0, sizeof(templ));
+   templ.target = PIPE_TEXTURE_2D;
+   templ.format = format;
+   templ.width0 = CELLS_X * CELL_SIZE;
+   templ.height0 = CELLS_Y * CELL_SIZE;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = PIPE_BIND_RENDER_TARGET;
+   struct pipe_resource *rt = screen->resource_create(screen, &templ);
+
+   struct pipe_surface surf_templ;
+   memset(&surf_templ, 0, sizeof(surf_templ));
+   surf_templ.format = format;
+   struct pipe_surface *surf = pipe->create_surface(pipe, rt, &surf_templ);
+
+   struct pipe_resource *vbuf = create_quads(pipe);
+
+   bind_state(pipe, surf, vbuf);
+   draw_cells(pipe);
+
+   unsigned failures = check_cells(pipe, rt);
+   if (failures)
+      fprintf(stderr, "%u of %u draws read the wrong constants\n",
+              failures, NUM_DRAWS);
+
+   pipe_surface_reference(&surf, NULL);
+   pipe_resource_reference(&vbuf, NULL);
+   pipe_resource_reference(&rt, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
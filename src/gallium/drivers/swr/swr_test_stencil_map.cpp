@@ -0,0 +1,157 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Writes a Z24_UNORM_S8_UINT array texture through a full map, then a box
+ * that starts at a non-zero x, y and layer, and reads everything back.  The
+ * stencil bytes go through SWR's separate stencil surface on unmap and come
+ * back on the next map, so every texel must read back what was last written
+ * to it, inside the box and out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+#include "util/u_box.h"
+#include "util/u_inlines.h"
+
+#include "swr_public.h"
+
+extern "C" {
+#include "sw/null/null_sw_winsys.h"
+}
+
+#define WIDTH 100
+#define HEIGHT 70
+#define LAYERS 3
+
+static uint32_t
+texel_value(unsigned x, unsigned y, unsigned z, bool in_box)
+{
+   uint32_t stencil = (x * 7 + y * 13 + z * 29 + (in_box ? 101 : 0)) & 0xff;
+   uint32_t depth = (x << 12) ^ (y << 4) ^ z ^ (in_box ? 0x800000 : 0);
+   return (stencil << 24) | (depth & 0x00ffffff);
+}
+
+static bool
+in_box(const struct pipe_box *box, unsigned x, unsigned y, unsigned z)
+{
+   return (int)x >= box->x && (int)x < box->x + box->width
+      && (int)y >= box->y && (int)y < box->y + box->height
+      && (int)z >= box->z && (int)z < box->z + box->depth;
+}
+
+/* Writes the box, using the in-box values if marked */
+static void
+write_box(struct pipe_context *pipe, struct pipe_resource *res,
+          const struct pipe_box *box, bool marked)
+{
+   struct pipe_transfer *transfer;
+   uint8_t *map = (uint8_t *)pipe->transfer_map(
+      pipe, res, 0, PIPE_TRANSFER_WRITE, box, &transfer);
+
+   for (int z = 0; z < box->depth; z++) {
+      for (int y = 0; y < box->height; y++) {
+         uint32_t *row = (uint32_t *)(map + z * transfer->layer_stride
+                                      + y * transfer->stride);
+         for (int x = 0; x < box->width; x++)
+            row[x] = texel_value(box->x + x, box->y + y, box->z + z, marked);
+      }
+   }
+
+   pipe->transfer_unmap(pipe, transfer);
+}
+
+static unsigned
+check_all(struct pipe_context *pipe, struct pipe_resource *res,
+          const struct pipe_box *marked)
+{
+   struct pipe_box box;
+   u_box_3d(0, 0, 0, WIDTH, HEIGHT, LAYERS, &box);
+
+   struct pipe_transfer *transfer;
+   const uint8_t *map = (const uint8_t *)pipe->transfer_map(
+      pipe, res, 0, PIPE_TRANSFER_READ, &box, &transfer);
+
+   unsigned failures = 0;
+   for (unsigned z = 0; z < LAYERS; z++) {
+      for (unsigned y = 0; y < HEIGHT; y++) {
+         const uint32_t *row = (const uint32_t *)
+            (map + z * transfer->layer_stride + y * transfer->stride);
+         for (unsigned x = 0; x < WIDTH; x++) {
+            uint32_t expected = texel_value(x, y, z, in_box(marked, x, y, z));
+            if (row[x] != expected) {
+               if (failures < 8)
+                  fprintf(stderr, "texel %u,%u,%u is %08x, expected %08x\n",
+                          x, y, z, row[x], expected);
+               failures++;
+            }
+         }
+      }
+   }
+
+   pipe->transfer_unmap(pipe, transfer);
+   return failures;
+}
+
+int
+main(int argc, char **argv)
+{
+   struct pipe_screen *screen = swr_create_screen(null_sw_create());
+   if (!screen)
+      return EXIT_FAILURE;
+
+   struct pipe_context *pipe = screen->context_create(screen, NULL);
+
+   struct pipe_resource templ;
+   memset(&templ, 0, sizeof(templ));
+   templ.target = PIPE_TEXTURE_2D_ARRAY;
+   templ.format = PIPE_FORMAT_Z24_UNORM_S8_UINT;
+   templ.width0 = WIDTH;
+   templ.height0 = HEIGHT;
+   templ.depth0 = 1;
+   templ.array_size = LAYERS;
+   templ.bind = PIPE_BIND_DEPTH_STENCIL;
+   struct pipe_resource *res = screen->resource_create(screen, &templ);
+
+   struct pipe_box whole, partial;
+   u_box_3d(0, 0, 0, WIDTH, HEIGHT, LAYERS, &whole);
+   u_box_3d(5, 7, 1, 37, 20, 2, &partial);
+
+   write_box(pipe, res, &whole, false);
+   write_box(pipe, res, &partial, true);
+
+   unsigned failures = check_all(pipe, res, &partial);
+   if (failures)
+      fprintf(stderr, "%u texels did not survive the round trip\n", failures);
+
+   pipe_resource_reference(&res, NULL);
+   pipe->destroy(pipe);
+   screen->destroy(screen);
+
+   return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,282 @@
+/****************************************************************************
+ * Copyright (C) 2015 Intel Corporation.   All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ ***************************************************************************/
+
+/*
+ * Runs the fixed function tessellator on known factors and compares the
+ * output against hand computed reference tables, for every domain and
+ * partitioning mode.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "context.h"
+#include "tessellator.h"
+
+struct edge_ref {
+   SWR_TS_PARTITIONING partitioning;
+   float factor;
+   unsigned num_points;
+   float u[8];
+};
+
+/*
+ * Points along an edge.  Integer rounds the factor up; the fractional
+ * modes use segments of 1 / factor except for the two placed around the
+ * middle of the edge, which share what is left.
+ */
+static const edge_ref edge_refs[] = {
+   { SWR_TS_INTEGER,         1.0f, 2, { 0.0f, 1.0f } },
+   { SWR_TS_INTEGER,         2.5f, 4, { 0.0f, 1.0f / 3, 2.0f / 3, 1.0f } },
+   { SWR_TS_INTEGER,         4.0f, 5, { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f } },
+   { SWR_TS_ODD_FRACTIONAL,  1.0f, 2, { 0.0f, 1.0f } },
+   { SWR_TS_ODD_FRACTIONAL,  2.5f, 4, { 0.0f, 0.3f, 0.7f, 1.0f } },
+   { SWR_TS_ODD_FRACTIONAL,  3.0f, 4, { 0.0f, 1.0f / 3, 2.0f / 3, 1.0f } },
+   { SWR_TS_ODD_FRACTIONAL,  4.0f, 6, { 0.0f, 0.25f, 0.375f, 0.625f, 0.75f, 1.0f } },
+   { SWR_TS_EVEN_FRACTIONAL, 1.0f, 3, { 0.0f, 0.5f, 1.0f } },
+   { SWR_TS_EVEN_FRACTIONAL, 3.0f, 5, { 0.0f, 1.0f / 3, 0.5f, 2.0f / 3, 1.0f } },
+   { SWR_TS_EVEN_FRACTIONAL, 5.0f, 7, { 0.0f, 0.2f, 0.4f, 0.5f, 0.6f, 0.8f, 1.0f } },
+};
+
+struct patch_ref {
+   SWR_TS_DOMAIN domain;
+   SWR_TS_PARTITIONING partitioning;
+   float outer[4];
+   float inner[2];
+   unsigned num_points;
+   unsigned num_prims;
+};
+
+static const patch_ref patch_refs[] = {
+   /* quads: outer ring plus a (segments - 1)^2 interior grid */
+   { SWR_TS_QUAD,    SWR_TS_INTEGER,         { 1, 1, 1, 1 }, { 1, 1 },  4,  2 },
+   { SWR_TS_QUAD,    SWR_TS_INTEGER,         { 3, 3, 3, 3 }, { 3, 3 }, 16, 18 },
+   { SWR_TS_QUAD,    SWR_TS_INTEGER,         { 2, 3, 4, 5 }, { 3, 3 }, 18, 20 },
+   { SWR_TS_QUAD,    SWR_TS_INTEGER,         { 3, 3, 3, 3 }, { 1, 1 }, 13, 12 },
+   { SWR_TS_QUAD,    SWR_TS_ODD_FRACTIONAL,  { 2.5f, 2.5f, 2.5f, 2.5f }, { 2.5f, 2.5f }, 16, 18 },
+   { SWR_TS_QUAD,    SWR_TS_EVEN_FRACTIONAL, { 3, 3, 3, 3 }, { 3, 3 }, 25, 32 },
+   /* triangles: concentric rings, inner factor 2 ends in a center point */
+   { SWR_TS_TRI,     SWR_TS_INTEGER,         { 1, 1, 1 }, { 1 },  3,  1 },
+   { SWR_TS_TRI,     SWR_TS_INTEGER,         { 3, 3, 3 }, { 3 }, 12, 13 },
+   { SWR_TS_TRI,     SWR_TS_INTEGER,         { 4, 4, 4 }, { 4 }, 19, 24 },
+   { SWR_TS_TRI,     SWR_TS_INTEGER,         { 1, 2, 3 }, { 2 },  7,  6 },
+   { SWR_TS_TRI,     SWR_TS_ODD_FRACTIONAL,  { 2.5f, 2.5f, 2.5f }, { 2.5f }, 12, 13 },
+   { SWR_TS_TRI,     SWR_TS_EVEN_FRACTIONAL, { 2, 2, 2 }, { 2 },  7,  6 },
+   { SWR_TS_TRI,     SWR_TS_EVEN_FRACTIONAL, { 3, 3, 3 }, { 3 }, 19, 24 },
+   /* isolines: density lines of detail segments each */
+   { SWR_TS_ISOLINE, SWR_TS_INTEGER,         { 4, 2 }, { 0 }, 10,  8 },
+   { SWR_TS_ISOLINE, SWR_TS_ODD_FRACTIONAL,  { 2.5f, 2.5f }, { 0 }, 12,  9 },
+   { SWR_TS_ISOLINE, SWR_TS_EVEN_FRACTIONAL, { 3, 1 }, { 0 },  5,  4 },
+   /* culled */
+   { SWR_TS_QUAD,    SWR_TS_INTEGER,         { 3, 0, 3, 3 }, { 3, 3 },  0,  0 },
+   { SWR_TS_TRI,     SWR_TS_ODD_FRACTIONAL,  { 3, 3, NAN }, { 3 },  0,  0 },
+   { SWR_TS_ISOLINE, SWR_TS_INTEGER,         { 4, -1 }, { 0 },  0,  0 },
+};
+
+static const char *
+partitioning_name(SWR_TS_PARTITIONING partitioning)
+{
+   switch (partitioning) {
+   case SWR_TS_INTEGER:         return "integer";
+   case SWR_TS_ODD_FRACTIONAL:  return "fractional_odd";
+   case SWR_TS_EVEN_FRACTIONAL: return "fractional_even";
+   default:                     return "?";
+   }
+}
+
+static const char *
+domain_name(SWR_TS_DOMAIN domain)
+{
+   switch (domain) {
+   case SWR_TS_QUAD:    return "quad";
+   case SWR_TS_TRI:     return "tri";
+   case SWR_TS_ISOLINE: return "isoline";
+   default:             return "?";
+   }
+}
+
+static bool
+close_enough(float a, float b)
+{
+   return fabsf(a - b) <= 1e-5f;
+}
+
+struct ts_test_ctx {
+   void *mem;
+   HANDLE handle;
+};
+
+static bool
+ts_test_init(ts_test_ctx &ctx, SWR_TS_DOMAIN domain,
+             SWR_TS_PARTITIONING partitioning, SWR_TS_OUTPUT_TOPOLOGY topology)
+{
+   size_t size = 0;
+   TSInitCtx(domain, partitioning, topology, NULL, size);
+
+   ctx.mem = _aligned_malloc(size, 64);
+   if (!ctx.mem)
+      return false;
+
+   ctx.handle = TSInitCtx(domain, partitioning, topology, ctx.mem, size);
+   return ctx.handle != NULL;
+}
+
+static void
+ts_test_fini(ts_test_ctx &ctx)
+{
+   if (ctx.handle)
+      TSDestroyCtx(ctx.handle);
+   _aligned_free(ctx.mem);
+}
+
+/*
+ * Tessellates a single isoline with the factor as line detail and
+ * compares the points against the reference edge.
+ */
+static bool
+test_edge(const edge_ref &ref)
+{
+   ts_test_ctx ctx;
+   if (!ts_test_init(ctx, SWR_TS_ISOLINE, ref.partitioning, SWR_TS_OUTPUT_LINE))
+      return false;
+
+   SWR_TESSELLATION_FACTORS factors = {};
+   factors.OuterTessFactors[SWR_QUAD_U_EQ0_TRI_U_LINE_DETAIL] = ref.factor;
+   factors.OuterTessFactors[SWR_QUAD_V_EQ0_TRI_V_LINE_DENSITY] = 1.0f;
+
+   SWR_TS_TESSELLATED_DATA data;
+   TSTessellate(ctx.handle, factors, data);
+
+   bool pass = data.NumDomainPoints == ref.num_points;
+   for (unsigned i = 0; pass && i < ref.num_points; i++) {
+      pass = close_enough(data.pDomainPointsU[i], ref.u[i]) &&
+             data.pDomainPointsV[i] == 0.0f;
+   }
+
+   if (!pass) {
+      fprintf(stderr, "edge %s %f: got", partitioning_name(ref.partitioning),
+              ref.factor);
+      for (unsigned i = 0; i < data.NumDomainPoints; i++)
+         fprintf(stderr, " %f", data.pDomainPointsU[i]);
+      fprintf(stderr, ", expected");
+      for (unsigned i = 0; i < ref.num_points; i++)
+         fprintf(stderr, " %f", ref.u[i]);
+      fprintf(stderr, "\n");
+   }
+
+   ts_test_fini(ctx);
+   return pass;
+}
+
+/*
+ * Checks the point and primitive counts.  Triangles must index valid
+ * points, wind counter-clockwise in (u, v) and cover the domain exactly.
+ */
+static bool
+test_patch(const patch_ref &ref)
+{
+   SWR_TS_OUTPUT_TOPOLOGY topology =
+      ref.domain == SWR_TS_ISOLINE ? SWR_TS_OUTPUT_LINE : SWR_TS_OUTPUT_TRI_CCW;
+
+   ts_test_ctx ctx;
+   if (!ts_test_init(ctx, ref.domain, ref.partitioning, topology))
+      return false;
+
+   SWR_TESSELLATION_FACTORS factors = {};
+   factors.OuterTessFactors[SWR_QUAD_V_EQ0_TRI_V_LINE_DENSITY] = ref.outer[0];
+   factors.OuterTessFactors[SWR_QUAD_U_EQ1_TRI_W] = ref.outer[1];
+   factors.OuterTessFactors[SWR_QUAD_V_EQ1] = ref.outer[2];
+   factors.OuterTessFactors[SWR_QUAD_U_EQ0_TRI_U_LINE_DETAIL] = ref.outer[3];
+   factors.InnerTessFactors[SWR_QUAD_U_TRI_INSIDE] = ref.inner[0];
+   factors.InnerTessFactors[SWR_QUAD_V_INSIDE] = ref.inner[1];
+
+   if (ref.domain == SWR_TS_TRI) {
+      factors.OuterTessFactors[SWR_QUAD_U_EQ0_TRI_U_LINE_DETAIL] = ref.outer[2];
+   } else if (ref.domain == SWR_TS_ISOLINE) {
+      factors.OuterTessFactors[SWR_QUAD_U_EQ0_TRI_U_LINE_DETAIL] = ref.outer[0];
+      factors.OuterTessFactors[SWR_QUAD_V_EQ0_TRI_V_LINE_DENSITY] = ref.outer[1];
+   }
+
+   SWR_TS_TESSELLATED_DATA data;
+   TSTessellate(ctx.handle, factors, data);
+
+   bool pass = data.NumDomainPoints == ref.num_points &&
+               data.NumPrimitives == ref.num_prims;
+
+   unsigned verts = ref.domain == SWR_TS_ISOLINE ? 2 : 3;
+   for (unsigned p = 0; pass && p < data.NumPrimitives; p++) {
+      for (unsigned v = 0; v < verts; v++)
+         pass = pass && data.ppIndices[v][p] < data.NumDomainPoints;
+   }
+
+   if (pass && ref.domain != SWR_TS_ISOLINE && data.NumPrimitives) {
+      const float *u = data.pDomainPointsU;
+      const float *v = data.pDomainPointsV;
+      double area = 0.0;
+
+      for (unsigned p = 0; pass && p < data.NumPrimitives; p++) {
+         uint32_t i0 = data.ppIndices[0][p];
+         uint32_t i1 = data.ppIndices[1][p];
+         uint32_t i2 = data.ppIndices[2][p];
+         double a = 0.5 * ((u[i1] - u[i0]) * (v[i2] - v[i0]) -
+                           (u[i2] - u[i0]) * (v[i1] - v[i0]));
+         pass = a >= -1e-6;
+         area += a;
+      }
+
+      double domain_area = ref.domain == SWR_TS_QUAD ? 1.0 : 0.5;
+      pass = pass && fabs(area - domain_area) <= 1e-4;
+   }
+
+   if (!pass) {
+      fprintf(stderr, "%s %s: got %u points %u prims, expected %u %u\n",
+              domain_name(ref.domain), partitioning_name(ref.partitioning),
+              data.NumDomainPoints, data.NumPrimitives,
+              ref.num_points, ref.num_prims);
+   }
+
+   ts_test_fini(ctx);
+   return pass;
+}
+
+int
+main(void)
+{
+   unsigned failures = 0;
+
+   for (unsigned i = 0; i < sizeof(edge_refs) / sizeof(edge_refs[0]); i++) {
+      if (!test_edge(edge_refs[i]))
+         failures++;
+   }
+
+   for (unsigned i = 0; i < sizeof(patch_refs) / sizeof(patch_refs[0]); i++) {
+      if (!test_patch(patch_refs[i]))
+         failures++;
+   }
+
+   if (failures)
+      fprintf(stderr, "%u tessellator tests failed\n", failures);
+
+   return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}